@@ -14,6 +14,8 @@
 
 #include "abbreviationmanager.h"
 
+#include <algorithm>
+
 #include <KMessageBox>
 #include "codecompletion.h"
 #include "kileinfo.h"
@@ -21,7 +23,8 @@
 
 namespace KileAbbreviation {
 
-Manager::Manager(KileInfo* kileInfo, QObject *parent) : QObject(parent), m_kileInfo(kileInfo), m_abbreviationsDirty(false)
+Manager::Manager(KileInfo* kileInfo, QObject *parent) : QObject(parent), m_kileInfo(kileInfo), m_abbreviationsDirty(false),
+    m_usage(KileUtilities::writableLocation(QStandardPaths::AppDataLocation) + "/complete/usage/abbreviation")
 {
     setObjectName("KileAbbreviation::Manager");
     m_localAbbreviationFile = KileUtilities::writableLocation(QStandardPaths::AppDataLocation) + '/' + "complete/abbreviation/" + "kile-abbrevs.cwl";
@@ -54,6 +57,7 @@ void Manager::updateLocalAbbreviation(const QString& text, const QString& replac
         m_abbreviationMap.erase(it);
     }
     m_abbreviationMap[text] = createLocalAbbreviationPair(replacement);
+    m_characterMaskMap[text] = KileCodeCompletion::FuzzyMatcher::characterMask(text);
     m_abbreviationsDirty = true;
     emit(abbreviationsChanged());
 }
@@ -67,6 +71,7 @@ void Manager::removeLocalAbbreviation(const QString& text)
     StringBooleanPair pair = it.value();
     if(isLocalAbbreviation(pair)) {
         m_abbreviationMap.erase(it);
+        m_characterMaskMap.remove(text);
         m_abbreviationsDirty = true;
     }
     emit(abbreviationsChanged());
@@ -78,6 +83,7 @@ void Manager::readAbbreviationFiles()
         saveLocalAbbreviations();
     }
     m_abbreviationMap.clear();
+    m_characterMaskMap.clear();
     QStringList list = m_kileInfo->codeCompletionManager()->readCWLFiles(KileConfig::completeAbbrev(), "abbreviation");
     addAbbreviationListToMap(list, true);
 
@@ -138,6 +144,7 @@ void Manager::addAbbreviationListToMap(const QStringList& list, bool global)
             continue;
         }
         m_abbreviationMap[left] = StringBooleanPair(right, global);
+        m_characterMaskMap[left] = KileCodeCompletion::FuzzyMatcher::characterMask(left);
     }
 }
 
@@ -153,6 +160,44 @@ QStringList Manager::getAbbreviationTextMatches(const QString& text) const
     return toReturn;
 }
 
+QStringList Manager::getRankedAbbreviationTextMatches(const QString& text)
+{
+    const KileCodeCompletion::FuzzyMatcher matcher(text);
+    QVector<KileCodeCompletion::ScoredWord> matches;
+    // all the matching abbreviations start with the anchor of the pattern, and only those
+    // whose character masks pass the test are compared with the pattern; as both maps have
+    // the same keys, they can be traversed together
+    AbbreviationMap::const_iterator i = m_abbreviationMap.lowerBound(matcher.anchor());
+    QMap<QString, quint64>::const_iterator maskIt = m_characterMaskMap.lowerBound(matcher.anchor());
+    for(; i != m_abbreviationMap.constEnd() && i.key().startsWith(matcher.anchor()); ++i, ++maskIt) {
+        if(!matcher.mayMatch(*maskIt)) {
+            continue;
+        }
+        const int score = matcher.score(i.key());
+        if(score >= 0) {
+            const QString& replacement = i.value().first;
+            matches.append(KileCodeCompletion::ScoredWord(replacement, score + m_usage.usageBonus(replacement)));
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const KileCodeCompletion::ScoredWord& m1, const KileCodeCompletion::ScoredWord& m2) {
+        if(m1.score != m2.score) {
+            return m1.score > m2.score;
+        }
+        return m1.word < m2.word;
+    });
+
+    QStringList toReturn;
+    for(const KileCodeCompletion::ScoredWord& match : matches) {
+        toReturn.append(match.word);
+    }
+    return toReturn;
+}
+
+void Manager::recordAbbreviationUsage(const QString& replacement)
+{
+    m_usage.recordUsage(replacement);
+}
+
 QString Manager::getAbbreviationTextMatch(const QString& text) const
 {
     return m_abbreviationMap[text].first;
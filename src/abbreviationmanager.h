@@ -21,6 +21,8 @@
 
 #include <KConfig>
 
+#include "completionranking.h"
+
 class KileInfo;
 
 namespace KileAbbreviation {
@@ -75,6 +77,13 @@ public:
      **/
     QStringList getAbbreviationTextMatches(const QString& text) const;
 
+    /**
+     * Returns the replacement strings of the abbreviations that match 'text' as described in
+     * KileCodeCompletion::FuzzyMatcher, the best and most frequently used matches first.
+     **/
+    QStringList getRankedAbbreviationTextMatches(const QString& text);
+    void recordAbbreviationUsage(const QString& replacement);
+
     /**
      * Returns the replacement string for 'text'; an empty string is returned
      * is 'text' is not found
@@ -96,6 +105,9 @@ protected:
     bool m_abbreviationsDirty;
     QString m_localAbbreviationFile;
     AbbreviationMap m_abbreviationMap;
+    // the character masks of the abbreviations, which have the same keys as 'm_abbreviationMap'
+    QMap<QString, quint64> m_characterMaskMap;
+    KileCodeCompletion::CompletionUsage m_usage;
 
     void addAbbreviationListToMap(const QStringList& list, bool global);
 };
@@ -0,0 +1,139 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+// Times the URL and document lookups of a synthetic project with many items.
+// Build it explicitly with 'make projectlookupbenchmark'; it is not part of the default build.
+//
+// Usage: projectlookupbenchmark [number of items] [number of rounds]
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QUrl>
+
+#include "documentinfo.h"
+#include "kiledocmanager.h"
+#include "kileextensions.h"
+#include "kileproject.h"
+
+static void report(const QString &name, qint64 nsecs, int lookups)
+{
+    QTextStream out(stdout);
+    out << qSetFieldWidth(24) << left << name << qSetFieldWidth(0)
+        << (nsecs / 1000000.0) << " ms total, "
+        << (double(nsecs) / lookups) << " ns per lookup" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    const int itemCount = (args.count() > 1) ? args.at(1).toInt() : 2000;
+    const int rounds = (args.count() > 2) ? args.at(2).toInt() : 10;
+    if(itemCount <= 0 || rounds <= 0) {
+        QTextStream(stderr) << "usage: projectlookupbenchmark [items] [rounds]" << endl;
+        return 1;
+    }
+
+    QTemporaryDir dir;
+    if(!dir.isValid()) {
+        QTextStream(stderr) << "cannot create a temporary directory" << endl;
+        return 1;
+    }
+
+    KileDocument::Extensions extensions;
+    KileProject *project = new KileProject(QUrl::fromLocalFile(dir.path() + QLatin1String("/benchmark.kilepr")), &extensions);
+
+    QList<QUrl> urls;
+    QList<KileDocument::TextInfo*> infos;
+    for(int i = 0; i < itemCount; ++i) {
+        const QUrl url = QUrl::fromLocalFile(dir.path() + QStringLiteral("/chapter%1.tex").arg(i));
+        KileProjectItem *item = new KileProjectItem(project, url, KileProjectItem::Source);
+        project->add(item);
+
+        KileDocument::TextInfo *info = new KileDocument::TextInfo(&extensions, Q_NULLPTR, Q_NULLPTR);
+        item->setInfo(info);
+
+        urls.append(url);
+        infos.append(info);
+    }
+
+    KileDocument::Manager manager(Q_NULLPTR, Q_NULLPTR, "benchmark document manager");
+    manager.addProject(project);
+
+    const int lookups = itemCount * rounds;
+    int found = 0;
+    QElapsedTimer timer;
+
+    timer.start();
+    for(int round = 0; round < rounds; ++round) {
+        for(int i = 0; i < itemCount; ++i) {
+            if(project->item(urls.at(i))) {
+                ++found;
+            }
+        }
+    }
+    report(QStringLiteral("item(url)"), timer.nsecsElapsed(), lookups);
+
+    timer.start();
+    for(int round = 0; round < rounds; ++round) {
+        for(int i = 0; i < itemCount; ++i) {
+            if(project->item(infos.at(i))) {
+                ++found;
+            }
+        }
+    }
+    report(QStringLiteral("item(info)"), timer.nsecsElapsed(), lookups);
+
+    timer.start();
+    for(int round = 0; round < rounds; ++round) {
+        for(int i = 0; i < itemCount; ++i) {
+            if(project->contains(urls.at(i))) {
+                ++found;
+            }
+        }
+    }
+    report(QStringLiteral("contains(url)"), timer.nsecsElapsed(), lookups);
+
+    timer.start();
+    for(int round = 0; round < rounds; ++round) {
+        for(int i = 0; i < itemCount; ++i) {
+            if(project->contains(infos.at(i))) {
+                ++found;
+            }
+        }
+    }
+    report(QStringLiteral("contains(info)"), timer.nsecsElapsed(), lookups);
+
+    timer.start();
+    for(int round = 0; round < rounds; ++round) {
+        for(int i = 0; i < itemCount; ++i) {
+            if(manager.textInfoFor(urls.at(i))) {
+                ++found;
+            }
+        }
+    }
+    report(QStringLiteral("textInfoFor(url)"), timer.nsecsElapsed(), lookups);
+
+    if(found != 5 * lookups) {
+        QTextStream(stderr) << "lookup failed: found " << found << " of " << (5 * lookups) << " items" << endl;
+    }
+
+    delete project;
+    qDeleteAll(infos);
+
+    return (found == 5 * lookups) ? 0 : 1;
+}
@@ -19,6 +19,7 @@
 #include <QFile>
 #include <QList>
 #include <QRegExp>
+#include <QRunnable>
 #include <QTimer>
 
 #include <KConfig>
@@ -37,6 +38,140 @@
 
 namespace KileCodeCompletion {
 
+static inline bool isSpecialLaTeXCommandCharacter(const QChar& c) {
+    return (c == '{' || c == '[' || c == '*' || c == ']' || c == '}');
+}
+
+static inline int specialLaTeXCommandCharacterOrdering(const QChar& c)
+{
+    switch(c.unicode()) {
+    case '{':
+        return 1;
+    case '[':
+        return 2;
+    case ']':
+        return 3;
+    case '}':
+        return 4;
+    case '*':
+        return 5;
+    default: // does nothing
+        break;
+    }
+    return 4; // must be 'isLetterOrNumber()' now
+}
+
+CompletionIndex::CompletionIndex()
+{
+}
+
+// The special characters come before all the other characters, which is why the words starting
+// with a given prefix form a contiguous range. A prefix of a word is smaller than the word.
+bool CompletionIndex::lessThan(const QString& s1, const QString& s2)
+{
+    const int length = qMin(s1.length(), s2.length());
+    for(int i = 0; i < length; ++i) {
+        const QChar c1 = s1.at(i);
+        const QChar c2 = s2.at(i);
+
+        if(c1 == c2) {
+            continue;
+        }
+        const bool special1 = isSpecialLaTeXCommandCharacter(c1);
+        const bool special2 = isSpecialLaTeXCommandCharacter(c2);
+        if(special1 && special2) {
+            return (specialLaTeXCommandCharacterOrdering(c1)
+                    < specialLaTeXCommandCharacterOrdering(c2));
+        }
+        else if(special1 != special2) {
+            return special1;
+        }
+        else {
+            return (c1 < c2);
+        }
+    }
+    return (s1.length() < s2.length());
+}
+
+void CompletionIndex::setWords(const QStringList& words)
+{
+    if(words == m_sourceWords) {
+        return;
+    }
+    m_sourceWords = words;
+    m_words = words.toVector();
+    std::sort(m_words.begin(), m_words.end(), lessThan);
+    m_words.erase(std::unique(m_words.begin(), m_words.end()), m_words.end());
+
+    m_characterMasks.resize(m_words.size());
+    for(int i = 0; i < m_words.size(); ++i) {
+        m_characterMasks[i] = FuzzyMatcher::characterMask(m_words[i]);
+    }
+}
+
+QVector<QString>::const_iterator CompletionIndex::lowerBound(const QString& prefix) const
+{
+    return std::lower_bound(m_words.constBegin(), m_words.constEnd(), prefix, lessThan);
+}
+
+QVector<QString>::const_iterator CompletionIndex::prefixEnd(QVector<QString>::const_iterator begin, const QString& prefix) const
+{
+    return std::partition_point(begin, m_words.constEnd(),
+    [&prefix](const QString& word) {
+        return word.startsWith(prefix);
+    });
+}
+
+QStringList CompletionIndex::wordsWithPrefix(const QString& prefix) const
+{
+    QVector<QString>::const_iterator begin = lowerBound(prefix);
+    QVector<QString>::const_iterator end = prefixEnd(begin, prefix);
+    QStringList toReturn;
+    toReturn.reserve(end - begin);
+    for(QVector<QString>::const_iterator it = begin; it != end; ++it) {
+        toReturn.append(*it);
+    }
+    return toReturn;
+}
+
+void CompletionIndex::findMatches(const FuzzyMatcher& matcher, QVector<ScoredWord>& matches) const
+{
+    // all the matching words start with the anchor of the pattern, and only those words
+    // whose character masks pass the test are compared with the pattern
+    const int begin = lowerBound(matcher.anchor()) - m_words.constBegin();
+    const int end = prefixEnd(m_words.constBegin() + begin, matcher.anchor()) - m_words.constBegin();
+    const quint64 *masks = m_characterMasks.constData();
+    for(int i = begin; i < end; ++i) {
+        if(!matcher.mayMatch(masks[i])) {
+            continue;
+        }
+        const int score = matcher.score(m_words[i]);
+        if(score >= 0) {
+            matches.append(ScoredWord(m_words[i], score));
+        }
+    }
+}
+
+QStringList CompletionIndex::merge(const QStringList& list1, const QStringList& list2)
+{
+    if(list2.isEmpty()) {
+        return list1;
+    }
+    if(list1.isEmpty()) {
+        return list2;
+    }
+    QStringList toReturn;
+    toReturn.reserve(list1.size() + list2.size());
+    QStringList::const_iterator it1 = list1.constBegin(), it2 = list2.constBegin();
+    while(it1 != list1.constEnd() || it2 != list2.constEnd()) {
+        const QString& word = (it2 == list2.constEnd() || (it1 != list1.constEnd() && !lessThan(*it2, *it1))) ? *it1++ : *it2++;
+        if(toReturn.isEmpty() || toReturn.last() != word) {
+            toReturn.append(word);
+        }
+    }
+    return toReturn;
+}
+
 LaTeXCompletionModel::LaTeXCompletionModel(QObject *parent, KileCodeCompletion::Manager *manager,
         KileDocument::EditorExtension *editorExtension)
     : KTextEditor::CodeCompletionModel(parent), m_codeCompletionManager(manager), m_editorExtension(editorExtension), m_currentView(Q_NULLPTR)
@@ -75,74 +210,23 @@ KTextEditor::Range LaTeXCompletionModel::updateCompletionRange(KTextEditor::View
     return newRange;
 }
 
-static inline bool isSpecialLaTeXCommandCharacter(const QChar& c) {
-    return (c == '{' || c == '[' || c == '*' || c == ']' || c == '}');
-}
-
-static inline int specialLaTeXCommandCharacterOrdering(const QChar& c)
-{
-    switch(c.unicode()) {
-    case '{':
-        return 1;
-    case '[':
-        return 2;
-    case ']':
-        return 3;
-    case '}':
-        return 4;
-    case '*':
-        return 5;
-    default: // does nothing
-        break;
-    }
-    return 4; // must be 'isLetterOrNumber()' now
-}
-
-static bool laTeXCommandLessThan(const QString& s1, const QString& s2)
-{
-    for(int i = 0; i < s1.length(); ++i) {
-        if(i >= s2.length()) {
-            return false;
-        }
-        const QChar c1 = s1.at(i);
-        const QChar c2 = s2.at(i);
-
-        if(c1 == c2) {
-            continue;
-        }
-        if(c1.isLetterOrNumber()) {
-            if(isSpecialLaTeXCommandCharacter(c2)) {
-                return false;
-            }
-            else {
-                return (c1 < c2);
-            }
-        }
-        else if(isSpecialLaTeXCommandCharacter(c1)) {
-            if(isSpecialLaTeXCommandCharacter(c2)) {
-                return (specialLaTeXCommandCharacterOrdering(c1)
-                        < specialLaTeXCommandCharacterOrdering(c2));
-            }
-            else if(c2.isLetterOrNumber()) {
-                return true;
-            }
-            else {
-                return (c1 < c2);
-            }
-        }
-    }
-    return true;
-}
-
 void LaTeXCompletionModel::buildModel(KTextEditor::View *view, const KTextEditor::Range &range)
 {
     QString completionString = view->document()->text(range);
     KILE_DEBUG_CODECOMPLETION << "Text in completion range: " << completionString;
     m_completionList.clear();
 
+    // the indices containing the words that can be completed
+    QList<const CompletionIndex*> indices;
     if(completionString.startsWith('\\')) {
-        m_completionList = m_codeCompletionManager->getLaTeXCommands();
-        m_completionList += m_codeCompletionManager->getLocallyDefinedLaTeXCommands(view);
+        m_localCommandIndex.setWords(m_codeCompletionManager->getLocallyDefinedLaTeXCommands(view));
+        indices << &m_codeCompletionManager->laTeXCommandIndex() << &m_localCommandIndex;
+        if(KileConfig::completePackageLists()) {
+            KileDocument::TextInfo *textInfo = m_codeCompletionManager->m_ki->docManager()->textInfoFor(view->document());
+            if(textInfo) {
+                indices += m_codeCompletionManager->packageWordIndices(m_codeCompletionManager->m_ki->allPackages(textInfo));
+            }
+        }
     }
     else {
         KTextEditor::Cursor latexCommandStart = determineLaTeXCommandStart(view->document(),
@@ -156,16 +240,32 @@ void LaTeXCompletionModel::buildModel(KTextEditor::View *view, const KTextEditor
         int citationIndex = leftSubstring.indexOf(m_codeCompletionManager->m_citeRegExp);
         int referenceIndex = leftSubstring.indexOf(m_codeCompletionManager->m_referencesRegExp);
         if(referenceIndex != -1) {
-            //FIXME: the retrieval of labels and BibTeX entries has to be revised!
-            m_completionList = m_codeCompletionManager->m_ki->allLabels();
+            m_labelIndex.setWords(m_codeCompletionManager->m_ki->allLabels());
+            indices << &m_labelIndex;
         }
         else if(citationIndex != -1) {
-            m_completionList = m_codeCompletionManager->m_ki->allBibItems();
+            m_bibItemIndex.setWords(m_codeCompletionManager->m_ki->allBibItems());
+            indices << &m_bibItemIndex;
+        }
+    }
+
+    QStringList completionList;
+    if(KileConfig::completeFuzzy()) {
+        const FuzzyMatcher matcher(completionString);
+        QVector<ScoredWord> matches;
+        for(const CompletionIndex *index : indices) {
+            index->findMatches(matcher, matches);
+        }
+        completionList = m_codeCompletionManager->rankMatches(matches);
+    }
+    else {
+        // only the words starting with 'completionString' are looked up in the indices
+        for(const CompletionIndex *index : indices) {
+            completionList = CompletionIndex::merge(completionList, index->wordsWithPrefix(completionString));
         }
     }
     beginResetModel();
-    filterModel(completionString);
-    std::sort(m_completionList.begin(), m_completionList.end(), laTeXCommandLessThan);
+    m_completionList = completionList;
     endResetModel();
 }
 
@@ -351,17 +451,6 @@ int LaTeXCompletionModel::rowCount(const QModelIndex &parent) const
     return m_completionList.size();
 }
 
-void LaTeXCompletionModel::filterModel(const QString& text)
-{
-    QMutableStringListIterator it(m_completionList);
-    while(it.hasNext()) {
-        QString string = it.next();
-        if(!string.startsWith(text)) {
-            it.remove();
-        }
-    }
-}
-
 void LaTeXCompletionModel::executeCompletionItem(KTextEditor::View *view,
         const KTextEditor::Range& word, const QModelIndex &index) const
 {
@@ -371,6 +460,7 @@ void LaTeXCompletionModel::executeCompletionItem(KTextEditor::View *view,
 
     int cursorXPos = -1, cursorYPos = -1;
     QString completionText = data(index.sibling(index.row(), Name), Qt::DisplayRole).toString();
+    m_codeCompletionManager->recordCompletionUsage(completionText);
 
     QString textToInsert;
     int envIndex = reEnv.indexIn(completionText);
@@ -783,6 +873,7 @@ void AbbreviationCompletionModel::executeCompletionItem(KTextEditor::View *view,
 {
     // replace abbreviation and take care of newlines
     QString completionText = data(index.sibling(index.row(), Name), Qt::DisplayRole).toString();
+    m_abbreviationManager->recordAbbreviationUsage(completionText);
     completionText.replace("%n","\n");
     KTextEditor::Document *document = view->document();
     document->replaceText(word, completionText);
@@ -817,19 +908,55 @@ void AbbreviationCompletionModel::buildModel(KTextEditor::View *view, const KTex
         executeCompletionItem(view, range, index(0, 0));
     }
     else {
-        m_completionList = m_abbreviationManager->getAbbreviationTextMatches(text);
-        m_completionList.sort();
-        if(m_completionList.size() == 1
+        const QStringList prefixMatches = m_abbreviationManager->getAbbreviationTextMatches(text);
+        if(KileConfig::completeFuzzy()) {
+            m_completionList = m_abbreviationManager->getRankedAbbreviationTextMatches(text);
+        }
+        else {
+            m_completionList = prefixMatches;
+            m_completionList.sort();
+        }
+        // the additional matches of the fuzzy search don't prevent the substitution
+        if(prefixMatches.size() == 1
                 && m_abbreviationManager->isAbbreviationDefined(text)) {
+            m_completionList = prefixMatches;
             executeCompletionItem(view, range, index(0, 0));
         }
     }
 }
 
+namespace {
+
+class PackageListLoadTask : public QRunnable
+{
+public:
+    PackageListLoadTask(Manager *manager, const QString &package)
+        : m_manager(manager)
+        , m_package(package)
+    {
+    }
+
+    void run() override
+    {
+        const QStringList words = Manager::readCWLFile("tex/" + m_package + ".cwl");
+        QMetaObject::invokeMethod(m_manager, "packageListLoaded", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_package), Q_ARG(QStringList, words));
+    }
+
+private:
+    Manager *m_manager;
+    QString m_package;
+};
+
+}
+
 Manager::Manager(KileInfo *info, QObject *parent)
-    : QObject(parent), m_ki(info)
+    : QObject(parent), m_ki(info),
+      m_usage(KileUtilities::writableLocation(QStandardPaths::AppDataLocation) + "/complete/usage/latex")
 {
     m_firstConfig = true;
+    // the lists are read one after the other
+    m_packageListThreadPool.setMaxThreadCount(1);
 }
 
 Manager::~Manager()
@@ -863,10 +990,28 @@ void Manager::readConfig(KConfig *config)
         buildReferenceCitationRegularExpressions();
 
         KILE_DEBUG_CODECOMPLETION << "   read wordlists...";
-        // wordlists for Tex/Latex mode
+        // wordlists for Tex/Latex mode; if the lists of the packages are loaded on demand,
+        // only the lists that don't belong to a package are read now
         QStringList files = KileConfig::completeTex();
+        if(KileConfig::completePackageLists()) {
+            QStringList eagerFiles;
+            for(const QString& file : files) {
+                if(!isPackageListName(validCwlFile(file))) {
+                    eagerFiles.append(file);
+                }
+            }
+            files = eagerFiles;
+        }
         m_texWordList = readCWLFiles(files, "tex");
         addUserDefinedLaTeXCommands(m_texWordList);
+        m_texWordIndex.setWords(m_texWordList);
+        m_texListNames.clear();
+        for(const QString& file : files) {
+            const QString cwlfile = validCwlFile(file);
+            if(!cwlfile.isEmpty()) {
+                m_texListNames.insert(cwlfile);
+            }
+        }
 
         // wordlist for dictionary mode
         files = KileConfig::completeDict();
@@ -881,6 +1026,77 @@ void Manager::readConfig(KConfig *config)
     }
 }
 
+// the names of the lists of packages are the names of the packages, whereas the names of
+// the other lists, e.g. 'latex-document' or 'class-beamer', contain a hyphen
+bool Manager::isPackageListName(const QString &name)
+{
+    return !name.isEmpty() && name != QLatin1String("tex")
+           && !name.contains('-') && !name.contains(',');
+}
+
+QList<const CompletionIndex*> Manager::packageWordIndices(const QStringList &packages)
+{
+    loadPackageLists(packages);
+
+    QList<const CompletionIndex*> toReturn;
+    for(const QString& package : packages) {
+        QHash<QString, CompletionIndex>::const_iterator it = m_packageWordIndices.constFind(package);
+        if(it != m_packageWordIndices.constEnd() && it->size() > 0) {
+            toReturn.append(&(*it));
+        }
+    }
+    return toReturn;
+}
+
+void Manager::loadPackageLists(const QStringList &packages)
+{
+    for(const QString& package : packages) {
+        if(package.isEmpty() || package.contains('/') || package.startsWith('.')
+                || m_texListNames.contains(package)
+                || m_packageWordIndices.contains(package)
+                || m_pendingPackageLists.contains(package)) {
+            continue;
+        }
+        KILE_DEBUG_CODECOMPLETION << "loading the command list of package" << package;
+        m_pendingPackageLists.insert(package);
+        m_packageListThreadPool.start(new PackageListLoadTask(this, package));
+    }
+}
+
+QStringList Manager::rankMatches(QVector<ScoredWord> &matches)
+{
+    for(ScoredWord& match : matches) {
+        match.score += m_usage.usageBonus(match.word);
+    }
+    std::sort(matches.begin(), matches.end(), [](const ScoredWord& m1, const ScoredWord& m2) {
+        if(m1.score != m2.score) {
+            return m1.score > m2.score;
+        }
+        return CompletionIndex::lessThan(m1.word, m2.word);
+    });
+
+    // a word that is contained in several indices appears several times in a row
+    QStringList toReturn;
+    toReturn.reserve(matches.size());
+    for(const ScoredWord& match : matches) {
+        if(toReturn.isEmpty() || toReturn.last() != match.word) {
+            toReturn.append(match.word);
+        }
+    }
+    return toReturn;
+}
+
+void Manager::recordCompletionUsage(const QString &word)
+{
+    m_usage.recordUsage(word);
+}
+
+void Manager::packageListLoaded(const QString &package, const QStringList &words)
+{
+    m_pendingPackageLists.remove(package);
+    m_packageWordIndices[package].setWords(words);
+}
+
 void Manager::startLaTeXCompletion(KTextEditor::View *view)
 {
     if(!view) {
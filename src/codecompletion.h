@@ -15,8 +15,12 @@
 #ifndef CODECOMPLETION_H
 #define CODECOMPLETION_H
 
+#include <QHash>
 #include <QObject>
 #include <QList>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
 
 #include <KTextEditor/CodeCompletionInterface>
 #include <KTextEditor/CodeCompletionModel>
@@ -25,6 +29,7 @@
 #include <KTextEditor/View>
 #include <kconfig.h>
 
+#include "completionranking.h"
 #include "latexcmd.h"
 #include "widgets/abbreviationview.h"
 
@@ -44,6 +49,49 @@ namespace KileCodeCompletion
 {
 class Manager;
 
+/**
+ * A sorted list of completion words without duplicates, in which the words starting with a
+ * given prefix are found by binary search. The words are sorted in the order in which LaTeX
+ * commands are presented to the user, i.e. the result of a lookup doesn't have to be sorted.
+ **/
+class CompletionIndex
+{
+public:
+    CompletionIndex();
+
+    /**
+     * Replaces the words in the index. Nothing is done if 'words' is the same list as
+     * the one passed in the previous call.
+     **/
+    void setWords(const QStringList& words);
+
+    int size() const {
+        return m_words.size();
+    }
+
+    QStringList wordsWithPrefix(const QString& prefix) const;
+    /**
+     * Appends the words that match 'matcher' to 'matches', together with their scores.
+     **/
+    void findMatches(const FuzzyMatcher& matcher, QVector<ScoredWord>& matches) const;
+
+    /**
+     * Merges two lists that are sorted with @ref lessThan and removes duplicates.
+     **/
+    static QStringList merge(const QStringList& list1, const QStringList& list2);
+
+    static bool lessThan(const QString& s1, const QString& s2);
+
+private:
+    QStringList m_sourceWords;
+    QVector<QString> m_words;
+    // the character masks of 'm_words' (see FuzzyMatcher::characterMask)
+    QVector<quint64> m_characterMasks;
+
+    QVector<QString>::const_iterator lowerBound(const QString& prefix) const;
+    QVector<QString>::const_iterator prefixEnd(QVector<QString>::const_iterator begin, const QString& prefix) const;
+};
+
 class LaTeXCompletionModel : public KTextEditor::CodeCompletionModel,
     public KTextEditor::CodeCompletionModelControllerInterface {
     Q_OBJECT
@@ -81,9 +129,10 @@ protected:
     KileDocument::EditorExtension *m_editorExtension;
     QStringList m_completionList;
     KTextEditor::View *m_currentView;
+    // the words that are defined in the documents only change occasionally
+    CompletionIndex m_localCommandIndex, m_labelIndex, m_bibItemIndex;
 
     void buildModel(KTextEditor::View *view, const KTextEditor::Range &r);
-    void filterModel(const QString& text);
 
     QString stripParameters(const QString &text) const;
     QString buildRegularCompletedText(const QString &text, int &cursorYPos, int &cursorXPos,
@@ -149,11 +198,37 @@ public:
     virtual ~Manager();
 
     QStringList getLaTeXCommands() const;
+    const CompletionIndex& laTeXCommandIndex() const {
+        return m_texWordIndex;
+    }
     QStringList getLocallyDefinedLaTeXCommands(KTextEditor::View *view) const;
 
     void readConfig(KConfig *config);
 
-    QStringList readCWLFile(const QString &filename, bool fullPathGiven = false);
+    /**
+     * Returns the indices of the command lists of 'packages' that have been loaded so far.
+     * The remaining lists are scheduled for loading.
+     **/
+    QList<const CompletionIndex*> packageWordIndices(const QStringList &packages);
+    /**
+     * Reads the command lists 'tex/<package>.cwl' of 'packages' in the background unless
+     * they have been loaded already.
+     **/
+    void loadPackageLists(const QStringList &packages);
+    /**
+     * Returns true if 'name' is the name of a list in 'complete/tex' that belongs to a package,
+     * and which is therefore loaded on demand if 'KileConfig::completePackageLists()' is set.
+     **/
+    static bool isPackageListName(const QString &name);
+
+    static QStringList readCWLFile(const QString &filename, bool fullPathGiven = false);
+
+    /**
+     * Sorts 'matches' by their scores, which are increased for the words that have been
+     * chosen often, and returns the words without duplicates.
+     **/
+    QStringList rankMatches(QVector<ScoredWord> &matches);
+    void recordCompletionUsage(const QString &word);
     QStringList readCWLFiles(const QStringList &files, const QString &dir);
     QString validCwlFile(const QString &filename);
 
@@ -173,9 +248,21 @@ public Q_SLOTS:
 
     void textInserted(KTextEditor::View* view, const KTextEditor::Cursor& position, const QString & text);
 
+private Q_SLOTS:
+    void packageListLoaded(const QString &package, const QStringList &words);
+
 protected:
     KileInfo* m_ki;
     QStringList m_texWordList, m_dictWordList, m_abbrevWordList;
+    CompletionIndex m_texWordIndex;
+    // names of the enabled lists in 'complete/tex', which are part of 'm_texWordIndex'
+    QSet<QString> m_texListNames;
+    // the lists of the packages, which are kept for all the documents; the index is
+    // empty if there is no list for a package
+    QHash<QString, CompletionIndex> m_packageWordIndices;
+    QSet<QString> m_pendingPackageLists;
+    QThreadPool m_packageListThreadPool;
+    CompletionUsage m_usage;
     bool m_firstConfig;
     QRegExp m_referencesRegExp;
     QRegExp m_referencesExtRegExp;
@@ -0,0 +1,229 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "completionranking.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+
+#include "kiledebug.h"
+
+namespace KileCodeCompletion {
+
+namespace {
+
+const quint32 usageFileMagic = 0x4b435553; // "KCUS"
+const quint32 usageFileVersion = 1;
+// only the most frequently used words are kept
+const int maximumUsageEntries = 5000;
+
+// words starting with the whole pattern are always ranked first
+const int prefixMatchScore = 1000;
+const int maximumLengthPenalty = 100;
+const int maximumUsageBonus = 200;
+
+inline ushort foldCase(ushort c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+inline bool isWordBoundary(const QChar& previous, const QChar& current)
+{
+    return !previous.isLetterOrNumber() || (previous.isLower() && current.isUpper());
+}
+
+}
+
+FuzzyMatcher::FuzzyMatcher(const QString& pattern)
+    : m_pattern(pattern)
+    , m_mask(characterMask(pattern))
+{
+    int anchorLength = 0;
+    while(anchorLength < pattern.length() && !pattern[anchorLength].isLetterOrNumber()) {
+        ++anchorLength;
+    }
+    m_anchor = pattern.left(anchorLength + 1);
+}
+
+quint64 FuzzyMatcher::characterMask(const QString& s)
+{
+    quint64 mask = 0;
+    for(const QChar& ch : s) {
+        ushort c = foldCase(ch.unicode());
+        if(c >= 0x80) {
+            c = ch.toLower().unicode();
+        }
+        if(c >= 'a' && c <= 'z') {
+            mask |= quint64(1) << (c - 'a');
+        }
+        else if(c >= '0' && c <= '9') {
+            mask |= quint64(1) << (26 + (c - '0'));
+        }
+        else {
+            // the remaining characters share the upper bits
+            mask |= quint64(1) << (36 + (c % 28));
+        }
+    }
+    return mask;
+}
+
+int FuzzyMatcher::score(const QString& word) const
+{
+    if(!word.startsWith(m_anchor)) {
+        return -1;
+    }
+    // shorter words are preferred
+    const int lengthPenalty = qMin(word.length() - m_pattern.length(), maximumLengthPenalty);
+    if(word.startsWith(m_pattern)) {
+        return prefixMatchScore - lengthPenalty;
+    }
+
+    int score = 0;
+    int wordPos = m_anchor.length();
+    bool previousMatched = true;
+    for(int i = m_anchor.length(); i < m_pattern.length(); ++i) {
+        const QChar c = m_pattern[i];
+        const ushort foldedC = foldCase(c.unicode());
+        bool found = false;
+        for(; wordPos < word.length(); ++wordPos) {
+            const QChar w = word[wordPos];
+            if(foldCase(w.unicode()) == foldedC || (w.unicode() >= 0x80 && w.toLower() == c.toLower())) {
+                score += (w == c) ? 2 : 1;
+                if(previousMatched) {
+                    score += 4;
+                }
+                if(isWordBoundary(word[wordPos - 1], w)) {
+                    score += 3;
+                }
+                previousMatched = true;
+                found = true;
+                ++wordPos;
+                break;
+            }
+            previousMatched = false;
+        }
+        if(!found) {
+            return -1;
+        }
+    }
+    return qMax(0, score - lengthPenalty / 4);
+}
+
+CompletionUsage::CompletionUsage(const QString& fileName)
+    : m_fileName(fileName)
+    , m_loaded(false)
+    , m_modified(false)
+{
+}
+
+CompletionUsage::~CompletionUsage()
+{
+    save();
+}
+
+void CompletionUsage::recordUsage(const QString& word)
+{
+    load();
+    ++m_counts[word];
+    m_modified = true;
+}
+
+int CompletionUsage::usageBonus(const QString& word)
+{
+    load();
+    const quint32 count = m_counts.value(word);
+    if(count == 0) {
+        return 0;
+    }
+    return qMin(maximumUsageBonus, int(20 * std::log2(double(count) + 1.0)));
+}
+
+void CompletionUsage::load()
+{
+    if(m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QFile file(m_fileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if(magic != usageFileMagic || version != usageFileVersion) {
+        KILE_DEBUG_CODECOMPLETION << "ignoring" << m_fileName << "with wrong version";
+        return;
+    }
+    stream >> m_counts;
+    if(stream.status() != QDataStream::Ok) {
+        m_counts.clear();
+    }
+}
+
+void CompletionUsage::save()
+{
+    if(!m_modified) {
+        return;
+    }
+    if(m_counts.size() > maximumUsageEntries) {
+        // the most frequently used words are kept; ties are broken by the words themselves
+        // such that exactly 'maximumUsageEntries' entries remain
+        typedef QHash<QString, quint32>::const_iterator CountIterator;
+        QVector<CountIterator> entries;
+        entries.reserve(m_counts.size());
+        for(CountIterator it = m_counts.constBegin(); it != m_counts.constEnd(); ++it) {
+            entries.append(it);
+        }
+        std::nth_element(entries.begin(), entries.begin() + maximumUsageEntries, entries.end(),
+        [](const CountIterator& it1, const CountIterator& it2) {
+            if(*it1 != *it2) {
+                return *it1 > *it2;
+            }
+            return it1.key() < it2.key();
+        });
+        QHash<QString, quint32> keptCounts;
+        keptCounts.reserve(maximumUsageEntries);
+        for(int i = 0; i < maximumUsageEntries; ++i) {
+            keptCounts.insert(entries[i].key(), *entries[i]);
+        }
+        m_counts.swap(keptCounts);
+    }
+
+    if(!QDir().mkpath(QFileInfo(m_fileName).absolutePath())) {
+        return;
+    }
+    QSaveFile file(m_fileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << usageFileMagic << usageFileVersion << m_counts;
+    if(stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+    }
+    if(file.commit()) {
+        m_modified = false;
+    }
+}
+
+}
@@ -0,0 +1,105 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef COMPLETIONRANKING_H
+#define COMPLETIONRANKING_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace KileCodeCompletion {
+
+struct ScoredWord {
+    ScoredWord() : score(0) {}
+    ScoredWord(const QString& w, int s) : word(w), score(s) {}
+
+    QString word;
+    int score;
+};
+
+/**
+ * Decides whether a completion word matches the text typed by the user, and how well.
+ *
+ * A word matches if it starts with the pattern up to and including the first letter or digit
+ * of the pattern (the anchor), and if the remaining characters of the pattern occur in the word
+ * in the same order, ignoring case. For example, '\sec' matches '\section' and '\subsection'
+ * but not '\ssec'. Words starting with the whole pattern always have a higher score than the
+ * other matches.
+ **/
+class FuzzyMatcher
+{
+public:
+    explicit FuzzyMatcher(const QString& pattern);
+
+    const QString& pattern() const {
+        return m_pattern;
+    }
+
+    const QString& anchor() const {
+        return m_anchor;
+    }
+
+    /**
+     * Returns a bit mask of the characters that occur in 's' (ignoring case). A word can only
+     * match if its mask contains all the bits of the mask of the pattern, which is much faster
+     * to check than computing the score.
+     **/
+    static quint64 characterMask(const QString& s);
+
+    bool mayMatch(quint64 wordMask) const {
+        return (wordMask & m_mask) == m_mask;
+    }
+
+    /**
+     * Returns the score of 'word', or -1 if it doesn't match.
+     **/
+    int score(const QString& word) const;
+
+private:
+    QString m_pattern;
+    QString m_anchor;
+    quint64 m_mask;
+};
+
+/**
+ * Counts how often the user has chosen the completion words; the counts are kept in a file
+ * that is read when they are needed for the first time.
+ **/
+class CompletionUsage
+{
+public:
+    explicit CompletionUsage(const QString& fileName);
+    ~CompletionUsage();
+
+    void recordUsage(const QString& word);
+
+    /**
+     * Returns the score that is added for the number of times 'word' has been chosen.
+     **/
+    int usageBonus(const QString& word);
+
+    void save();
+
+private:
+    QString m_fileName;
+    QHash<QString, quint32> m_counts;
+    bool m_loaded;
+    bool m_modified;
+
+    void load();
+};
+
+}
+
+#endif
@@ -14,10 +14,18 @@
 
 #include "convert.h"
 
+#include <QAtomicInt>
 #include <QFile>
+#include <QMutex>
+#include <QMetaObject>
+#include <QMutexLocker>
 #include <QRegExp>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSharedPointer>
 #include <QTextCodec>
 #include <QTextStream>
+#include <QThreadPool>
 
 #include <KMessageBox>
 #include <KTextEditor/Document>
@@ -26,11 +34,13 @@
 #include "utilities.h"
 
 QMap<QString, ConvertMap*> ConvertMap::g_maps;
+QMutex ConvertMap::g_mapsMutex;
 
 bool ConvertMap::create(const QString & encoding)
 {
     KILE_DEBUG_MAIN << "\tlooking for map for " << encoding;
-    ConvertMap * map = g_maps[encoding];
+    QMutexLocker locker(&g_mapsMutex);
+    ConvertMap * map = g_maps.value(encoding);
 
     if(!map) {
         KILE_DEBUG_MAIN << "\tcreating a map for " << encoding;
@@ -42,12 +52,18 @@ bool ConvertMap::create(const QString & encoding)
             delete map;
             map = Q_NULLPTR;
         }
-        map = g_maps[encoding];
+        map = g_maps.value(encoding);
     }
 
     return (map != Q_NULLPTR);
 }
 
+ConvertMap * ConvertMap::mapFor(const QString & enc)
+{
+    QMutexLocker locker(&g_mapsMutex);
+    return g_maps.value(enc);
+}
+
 QString ConvertMap::encodingNameFor(const QString & name)
 {
     QString std;
@@ -93,6 +109,7 @@ QString ConvertMap::isoNameFor(const QString & name)
 }
 
 ConvertMap::ConvertMap(const QString& enc)
+    : m_toASCII(0x10000, 0)
 {
     m_aliases.append(encodingNameFor(enc));
     m_aliases.append(isoNameFor(enc));
@@ -100,7 +117,15 @@ ConvertMap::ConvertMap(const QString& enc)
 
 void ConvertMap::addPair(QChar c, const QString& enc)
 {
-    m_toASCII[c] = commandIsTerminated(enc) ? enc : enc + "{}" ;
+    const QString sequence = commandIsTerminated(enc) ? enc : enc + "{}";
+    quint16 &index = m_toASCII[c.unicode()];
+    if(index) {
+        m_sequences[index - 1] = sequence;
+    }
+    else if(m_sequences.size() < 0xffff) {
+        m_sequences.append(sequence);
+        index = m_sequences.size();
+    }
     m_toEncoding[enc] = c;
 }
 
@@ -144,13 +169,12 @@ bool ConvertMap::load()
 //BEGIN ConvertIO classes
 ConvertIO::ConvertIO(KTextEditor::Document *doc) :
     m_doc(doc),
-    m_text(QString()),
     m_line(QString()),
     m_nLine(0)
 {
 }
 
-QString & ConvertIO::currentLine()
+const QString & ConvertIO::currentLine() const
 {
     return m_line;
 }
@@ -160,9 +184,37 @@ void ConvertIO::nextLine()
     m_line = m_doc->line(m_nLine++);
 }
 
+void ConvertIO::writeLine(const QString &line)
+{
+    if(line == m_line) {
+        return;
+    }
+
+    // only the part between the common prefix and suffix is replaced in the document
+    int prefix = 0;
+    const int maxLength = qMin(line.length(), m_line.length());
+    while(prefix < maxLength && line[prefix] == m_line[prefix]) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while(suffix < maxLength - prefix
+            && line[line.length() - 1 - suffix] == m_line[m_line.length() - 1 - suffix]) {
+        ++suffix;
+    }
+    m_edits.append({m_nLine - 1, prefix, m_line.length() - suffix, line.mid(prefix, line.length() - prefix - suffix)});
+}
+
 void ConvertIO::writeText()
 {
-    m_doc->setText(m_text);
+    if(m_edits.isEmpty()) {
+        return;
+    }
+    // the document is changed in one step that can be undone
+    KTextEditor::Document::EditingTransaction transaction(m_doc);
+    for(const Edit &edit : qAsConst(m_edits)) {
+        m_doc->replaceText(KTextEditor::Range(edit.line, edit.startColumn, edit.line, edit.endColumn), edit.text);
+    }
+    m_edits.clear();
 }
 
 int ConvertIO::current()
@@ -175,24 +227,75 @@ bool ConvertIO::done()
     return current() == m_doc->lines();
 }
 
-ConvertIOFile::ConvertIOFile(KTextEditor::Document *doc, const QUrl &url) : ConvertIO(doc), m_url(url)
+ConvertIOFile::ConvertIOFile(const QUrl &url, const QString &encoding) :
+    ConvertIO(Q_NULLPTR),
+    m_url(url),
+    m_encoding(encoding),
+    m_open(false),
+    m_modified(false),
+    m_written(false)
+{
+    QFile qf(m_url.toLocalFile());
+    if(qf.open(QIODevice::ReadOnly)) {
+        QTextStream stream(&qf);
+        QTextCodec *codec = QTextCodec::codecForName(m_encoding.toLatin1());
+        if(codec) {
+            stream.setCodec(codec);
+        }
+        // the line endings are kept as they are
+        m_lines = stream.readAll().split('\n');
+        m_open = true;
+    }
+    else {
+        qWarning() << "Could not open " << m_url.toLocalFile();
+    }
+}
+
+void ConvertIOFile::nextLine()
 {
+    m_line = m_lines[m_nLine++];
+}
+
+void ConvertIOFile::writeLine(const QString &line)
+{
+    if(line != m_line) {
+        m_lines[m_nLine - 1] = line;
+        m_modified = true;
+    }
 }
 
 void ConvertIOFile::writeText()
 {
-    QFile qf(m_url.toLocalFile());
+    if(!m_modified) {
+        m_written = true;
+        return;
+    }
+    QSaveFile qf(m_url.toLocalFile());
     if(qf.open(QIODevice::WriteOnly)) {
-        //read the file
         QTextStream stream(&qf);
-        stream << m_text;
-        qf.close();
+        QTextCodec *codec = QTextCodec::codecForName(m_encoding.toLatin1());
+        if(codec) {
+            stream.setCodec(codec);
+        }
+        stream << m_lines.join('\n');
+        stream.flush();
+        m_written = qf.commit();
     }
     else {
         qWarning() << "Could not open " << m_url.toLocalFile();
     }
 }
 
+int ConvertIOFile::current()
+{
+    return m_nLine;
+}
+
+bool ConvertIOFile::done()
+{
+    return m_nLine >= m_lines.size();
+}
+
 ConvertBase::ConvertBase(const QString & encoding, ConvertIO * io) :
     m_io(io),
     m_encoding(encoding),
@@ -203,9 +306,9 @@ ConvertBase::ConvertBase(const QString & encoding, ConvertIO * io) :
 //END ConvertIO classes
 
 //BEGIN ConvertBase
-QString ConvertBase::mapNext(int &i)
+void ConvertBase::mapNext(const QString &line, int &i, QString &output)
 {
-    return (QString)m_io->currentLine()[i++];
+    output += line[i++];
 }
 
 bool ConvertBase::convert()
@@ -214,16 +317,18 @@ bool ConvertBase::convert()
         return false;
     }
 
-    m_io->text().clear();
+    // the same buffer is used for all the lines
+    QString output;
     do {
         m_io->nextLine();
+        const QString &line = m_io->currentLine();
+        output.truncate(0);
+        output.reserve(line.length() + 16);
         int i = 0;
-        while(i < m_io->currentLine().length()) {
-            m_io->text() += mapNext(i);
-        }
-        if(!m_io->done()) {
-            m_io->text() += '\n';
+        while(i < line.length()) {
+            mapNext(line, i, output);
         }
+        m_io->writeLine(output);
     }
     while(!m_io->done());
 
@@ -246,27 +351,119 @@ bool ConvertBase::setMap()
 //END ConvertBase
 
 //BEGIN ConvertEncToASCII
-QString ConvertEncToASCII::mapNext(int &i)
+void ConvertEncToASCII::mapNext(const QString &line, int &i, QString &output)
 {
-    return m_map->canDecode(m_io->currentLine()[i]) ? m_map->toASCII(m_io->currentLine()[i++]) : (QString)m_io->currentLine()[i++];
+    const QString *sequence = m_map->sequenceFor(line[i]);
+    if(sequence) {
+        output += *sequence;
+        ++i;
+    }
+    else {
+        output += line[i++];
+    }
+}
+
+namespace {
+
+// shared by all the tasks that convert the files of one call to 'convertFiles'
+struct ConvertFilesJob
+{
+    QList<QUrl> urls;
+    QString encoding;
+    QAtomicInt nextFile;
+    QAtomicInt runningTasks;
+    QMutex mutex;
+    QList<QUrl> failedFiles;
+    QObject *context;
+    std::function<void (const QList<QUrl>&)> finished;
+};
+
+class ConvertFilesTask : public QRunnable
+{
+public:
+    explicit ConvertFilesTask(const QSharedPointer<ConvertFilesJob> &job)
+        : m_job(job)
+    {
+    }
+
+    void run() override
+    {
+        for(int index = m_job->nextFile.fetchAndAddOrdered(1); index < m_job->urls.size(); index = m_job->nextFile.fetchAndAddOrdered(1)) {
+            const QUrl &url = m_job->urls[index];
+            ConvertIOFile io(url, m_job->encoding);
+            ConvertEncToASCII conv(m_job->encoding, &io);
+            if(!io.isOpen() || !conv.convert() || !io.writeSucceeded()) {
+                QMutexLocker locker(&m_job->mutex);
+                m_job->failedFiles.append(url);
+            }
+        }
+
+        // the last task reports the results
+        if(!m_job->runningTasks.deref()) {
+            QSharedPointer<ConvertFilesJob> job = m_job;
+            QMetaObject::invokeMethod(job->context, [job]() {
+                job->finished(job->failedFiles);
+            }, Qt::QueuedConnection);
+        }
+    }
+
+private:
+    QSharedPointer<ConvertFilesJob> m_job;
+};
+
+}
+
+bool ConvertEncToASCII::convertFiles(const QList<QUrl> &urls, const QString &encoding, QThreadPool *threadPool,
+                                     QObject *context, const std::function<void (const QList<QUrl>&)> &finished)
+{
+    if(!ConvertMap::create(encoding)) {
+        return false;
+    }
+
+    QSharedPointer<ConvertFilesJob> job(new ConvertFilesJob);
+    job->urls = urls;
+    job->encoding = encoding;
+    job->context = context;
+    job->finished = finished;
+    const int taskCount = qMax(1, qMin(threadPool->maxThreadCount(), urls.size()));
+    job->runningTasks.store(taskCount);
+    for(int i = 0; i < taskCount; ++i) {
+        threadPool->start(new ConvertFilesTask(job));
+    }
+
+    return true;
 }
 //END ConvertEncToASCII
 
 //BEGIN ConvertASCIIToEnc
 
+namespace {
+
+inline QChar charAt(const QString &line, int i)
+{
+    return (i < line.length()) ? line[i] : QChar();
+}
+
+inline bool isASCIILetter(const QChar &c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+}
+
 //i is the position of the '\'
-QString ConvertASCIIToEnc::nextSequence(int &i)
+QString ConvertASCIIToEnc::nextSequence(const QString &line, int &i)
 {
     //get first two characters
-    QString seq = (QString)m_io->currentLine()[i++];
+    QString seq = line[i++];
 
-    if(m_io->currentLine()[i].isLetter()) {
-        while(m_io->currentLine()[i].isLetter()) {
-            seq += (QString)m_io->currentLine()[i++];
+    if(charAt(line, i).isLetter()) {
+        while(charAt(line, i).isLetter()) {
+            seq += line[i++];
         }
     }
-    else {
-        return seq + (QString)m_io->currentLine()[i++];
+    else if(i < line.length()) {
+        seq += line[i++];
     }
 
     return seq;
@@ -274,14 +471,13 @@ QString ConvertASCIIToEnc::nextSequence(int &i)
 
 bool ConvertASCIIToEnc::isModifier(const QString& seq)
 {
-    static QRegExp reModifier("\\\\([cHkruv]|\"|\'|\\^|`|~|=|\\.)");
-    return reModifier.exactMatch(seq);
+    // \c, \H, \k, \r, \u, \v, \", \', \^, \`, \~, \= and \.
+    return seq.length() == 2 && seq[0] == '\\' && QStringLiteral("cHkruv\"'^`~=.").contains(seq[1]);
 }
 
-QString ConvertASCIIToEnc::getSequence(int &i)
+QString ConvertASCIIToEnc::getSequence(const QString &line, int &i)
 {
-    QString seq = nextSequence(i);
-    static QRegExp reBraces("\\{([a-zA-Z]?)\\}");
+    QString seq = nextSequence(line, i);
 
     if(isModifier(seq)) {
         KILE_DEBUG_MAIN << "\tisModifier true : " << seq;
@@ -289,36 +485,38 @@ QString ConvertASCIIToEnc::getSequence(int &i)
             seq += ' ';
         }
 
-        while(m_io->currentLine()[i].isSpace()) {
+        while(charAt(line, i).isSpace()) {
             ++i;
         }
 
-        if(m_io->currentLine().mid(i, 2) == "{}") {
+        if(line.midRef(i, 2) == QLatin1String("{}")) {
             i = i + 2;
         }
 
-        if(m_io->currentLine()[i] == '\\') {
-            seq += nextSequence(i);
+        if(charAt(line, i) == '\\') {
+            seq += nextSequence(line, i);
         }
-        else {
-            if(reBraces.exactMatch(m_io->currentLine().mid(i, 3))) {
-                KILE_DEBUG_MAIN << "\tbraces detected";
-                i = i + 3;
-                seq += reBraces.cap(1);
-            }
-            else {
-                QChar nextChar = m_io->currentLine()[i++];
-                if(!nextChar.isSpace()) {
-                    seq += (QString)nextChar;
-                }
+        // a letter in braces, like in \'{e}
+        else if(charAt(line, i) == '{' && isASCIILetter(charAt(line, i + 1)) && charAt(line, i + 2) == '}') {
+            KILE_DEBUG_MAIN << "\tbraces detected";
+            seq += line[i + 1];
+            i = i + 3;
+        }
+        else if(line.midRef(i) == QLatin1String("{}")) {
+            i = i + 2;
+        }
+        else if(i < line.length()) {
+            QChar nextChar = line[i++];
+            if(!nextChar.isSpace()) {
+                seq += nextChar;
             }
         }
     }
     else if(m_map->canEncode(seq)) {
-        if(m_io->currentLine().mid(i, 2) == "{}") {
+        if(line.midRef(i, 2) == QLatin1String("{}")) {
             i = i + 2;
         }
-        else if(m_io->currentLine()[i].isSpace()) {
+        else if(charAt(line, i).isSpace()) {
             ++i;
         }
     }
@@ -326,21 +524,19 @@ QString ConvertASCIIToEnc::getSequence(int &i)
     return seq;
 }
 
-QString ConvertASCIIToEnc::mapNext(int &i)
+void ConvertASCIIToEnc::mapNext(const QString &line, int &i, QString &output)
 {
-    if(m_io->currentLine()[i] == '\\') {
-        QString seq = getSequence(i);
-        KILE_DEBUG_MAIN << "'\tsequence: " << seq;
+    if(line[i] == '\\') {
+        const QString seq = getSequence(line, i);
         if(m_map->canEncode(seq)) {
-            KILE_DEBUG_MAIN << "\tcan encode this";
-            //if ( m_io->currentLine().mid(i, 2) == "{}" ) i = i + 2;
-            return m_map->toEncoding(seq);
+            output += m_map->toEncoding(seq);
         }
         else {
-            return seq;
+            output += seq;
         }
+        return;
     }
 
-    return ConvertBase::mapNext(i);
+    ConvertBase::mapNext(line, i, output);
 }
 //END ConvertASCIIToEnc
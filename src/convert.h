@@ -16,12 +16,21 @@
 #ifndef CONVERT_H
 #define CONVERT_H
 
+#include <QHash>
+#include <QList>
+#include <QMutex>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 #include <qmap.h>
 
 #include <QUrl>
 
+#include <functional>
+
+class QObject;
+class QThreadPool;
+
 namespace KTextEditor {
 class Document;
 }
@@ -39,20 +48,26 @@ public:
         return m_aliases[1];
     }
 
-    QChar toEncoding(const QString & enc) {
-        return m_toEncoding[enc];
+    QChar toEncoding(const QString & enc) const {
+        return m_toEncoding.value(enc);
+    }
+    QString toASCII(const QChar & c) const {
+        const QString *sequence = sequenceFor(c);
+        return sequence ? *sequence : QString();
     }
-    QString toASCII(const QChar & c) {
-        return m_toASCII[c];
+    /** @returns the ASCII sequence for 'c', or Q_NULLPTR if there is none **/
+    const QString* sequenceFor(const QChar & c) const {
+        const quint16 index = m_toASCII[c.unicode()];
+        return index ? &m_sequences[index - 1] : Q_NULLPTR;
     }
 
     void addPair(QChar c, const QString & enc);
 
-    bool canDecode(const QChar & c) {
-        return ( m_toASCII.contains(c));
+    bool canDecode(const QChar & c) const {
+        return (m_toASCII[c.unicode()] != 0);
     }
-    bool canEncode(const QString & enc) {
-        return ( m_toEncoding.contains(enc));
+    bool canEncode(const QString & enc) const {
+        return (m_toEncoding.contains(enc));
     }
 
     bool load();
@@ -62,20 +77,23 @@ private:
 
 private:
     QStringList				m_aliases;
-    QMap<QChar, QString>		m_toASCII;
-    QMap<QString, QChar>		m_toEncoding;
+    // maps every character to the position of its sequence in 'm_sequences' plus one,
+    // or to zero if it has none
+    QVector<quint16>		m_toASCII;
+    QVector<QString>		m_sequences;
+    QHash<QString, QChar>		m_toEncoding;
 
 //static members
 public:
+    // the maps are never deleted, and they can be created and used by several threads
     static bool create(const QString & encoding);
     static QString encodingNameFor(const QString &);
     static QString isoNameFor(const QString &);
-    static ConvertMap * mapFor(const QString & enc) {
-        return g_maps[enc];
-    }
+    static ConvertMap * mapFor(const QString & enc);
 
 private:
     static QMap<QString, ConvertMap*>	g_maps;
+    static QMutex				g_mapsMutex;
 };
 
 class ConvertIO
@@ -85,29 +103,56 @@ public:
     virtual ~ConvertIO() {}
 
     virtual void nextLine(); //read next line
-    virtual QString& currentLine();
-    virtual QString& text() {
-        return m_text;
-    }
+    virtual const QString& currentLine() const;
+    /** Replaces the current line with its converted version 'line'. **/
+    virtual void writeLine(const QString &line);
     virtual void writeText();
     virtual int current(); //current line number
     virtual bool done();
 
 protected:
     KTextEditor::Document	*m_doc;
-    QString			m_text, m_line;
+    QString			m_line;
     int				m_nLine;
+
+private:
+    // the part of a line that has been changed by the conversion
+    struct Edit {
+        int line;
+        int startColumn;
+        int endColumn;
+        QString text;
+    };
+    QVector<Edit>		m_edits;
 };
 
 class ConvertIOFile : public ConvertIO
 {
 public:
-    ConvertIOFile(KTextEditor::Document *doc, const QUrl &url);
+    /** The file is read and written with the codec for 'encoding'. **/
+    ConvertIOFile(const QUrl &url, const QString &encoding);
+
+    bool isOpen() const {
+        return m_open;
+    }
 
+    void nextLine() override;
+    void writeLine(const QString &line) override;
     void writeText() override;
+    int current() override;
+    bool done() override;
+
+    bool writeSucceeded() const {
+        return m_written;
+    }
 
 private:
-    QUrl	m_url;
+    QUrl		m_url;
+    QString		m_encoding;
+    QStringList	m_lines;
+    bool		m_open;
+    bool		m_modified;
+    bool		m_written;
 };
 
 class ConvertBase
@@ -122,7 +167,8 @@ public:
 protected:
     virtual bool setMap();
 
-    virtual QString mapNext(int&);
+    // appends the conversion of the characters starting at position 'i' of 'line' to 'output'
+    virtual void mapNext(const QString &line, int &i, QString &output);
 
     ConvertIO		*m_io;
     QString			m_encoding;
@@ -134,8 +180,18 @@ class ConvertEncToASCII : public ConvertBase
 public:
     ConvertEncToASCII(const QString & encoding, ConvertIO * io) : ConvertBase(encoding, io) {}
 
+    /**
+     * Starts converting the files 'urls', which are encoded in 'encoding', to ASCII on several
+     * threads of 'threadPool'. The conversion cannot be undone. Once all the files have been
+     * processed, 'finished' is called in the thread of 'context' with the files that couldn't
+     * be converted.
+     * @returns false if there is no conversion map for 'encoding'; nothing is converted then
+     **/
+    static bool convertFiles(const QList<QUrl> &urls, const QString &encoding, QThreadPool *threadPool,
+                             QObject *context, const std::function<void (const QList<QUrl>&)> &finished);
+
 protected:
-    QString mapNext(int&) override;
+    void mapNext(const QString &line, int &i, QString &output) override;
 };
 
 class ConvertASCIIToEnc : public ConvertBase
@@ -144,10 +200,10 @@ public:
     ConvertASCIIToEnc(const QString & encoding, ConvertIO * io) : ConvertBase(encoding, io) {}
 
 protected:
-    QString getSequence(int&);
-    QString nextSequence(int&);
+    QString getSequence(const QString &line, int&);
+    QString nextSequence(const QString &line, int&);
     bool isModifier(const QString&);
-    QString mapNext(int&) override;
+    void mapNext(const QString &line, int &i, QString &output) override;
 };
 
 #endif
@@ -0,0 +1,123 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/*
+ * Combines the symbol images of several groups into one image and writes an index
+ * containing the position and the text chunks of every symbol.
+ *
+ * usage: gensymbolatlas <output base name> <symbol directory> <group>...
+ */
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QList>
+#include <QStringList>
+
+#include <cstring>
+#include <iostream>
+
+#include "../../symbolviewclasses.h"
+
+namespace {
+
+// the atlas is widened if a symbol doesn't fit into this width
+const int minimumAtlasWidth = 1024;
+const int padding = 1;
+
+struct Symbol {
+    SymbolAtlasEntry entry;
+    QImage image;
+};
+
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 4) {
+        std::cerr << "usage: " << argv[0] << " <output base name> <symbol directory> <group>..." << std::endl;
+        return 1;
+    }
+    const QString outputBaseName = QString::fromLocal8Bit(argv[1]);
+    const QDir symbolDir(QString::fromLocal8Bit(argv[2]));
+
+    QList<Symbol> symbols;
+    for(int i = 3; i < argc; ++i) {
+        const QString group = QString::fromLocal8Bit(argv[i]);
+        QDir groupDir(symbolDir.filePath(group));
+        const QStringList fileNames = groupDir.entryList(QStringList() << QStringLiteral("*.png"), QDir::Files, QDir::Name);
+        for(const QString &fileName : fileNames) {
+            Symbol symbol;
+            if(!symbol.image.load(groupDir.filePath(fileName))) {
+                std::cerr << "cannot load " << qPrintable(groupDir.filePath(fileName)) << std::endl;
+                return 1;
+            }
+            symbol.image = symbol.image.convertToFormat(QImage::Format_ARGB32);
+            symbol.entry.group = group;
+            symbol.entry.fileName = fileName;
+            symbol.entry.command = symbol.image.text("Command");
+            symbol.entry.commandUnicode = symbol.image.text("CommandUnicode");
+            symbol.entry.unicodePackages = symbol.image.text("UnicodePackages");
+            symbol.entry.packages = symbol.image.text("Packages");
+            symbol.entry.comment = symbol.image.text("Comment");
+            symbols.append(symbol);
+        }
+    }
+
+    int atlasWidth = minimumAtlasWidth;
+    for(const Symbol &symbol : symbols) {
+        atlasWidth = qMax(atlasWidth, symbol.image.width());
+    }
+
+    // place the images row by row
+    int x = 0, y = 0, rowHeight = 0;
+    for(Symbol &symbol : symbols) {
+        const QSize size = symbol.image.size();
+        if(x > 0 && x + size.width() > atlasWidth) {
+            x = 0;
+            y += rowHeight + padding;
+            rowHeight = 0;
+        }
+        symbol.entry.rect = QRect(QPoint(x, y), size);
+        x += size.width() + padding;
+        rowHeight = qMax(rowHeight, size.height());
+    }
+
+    QImage atlas(atlasWidth, qMax(1, y + rowHeight), QImage::Format_ARGB32);
+    atlas.fill(Qt::transparent);
+    for(const Symbol &symbol : symbols) {
+        const QRect &rect = symbol.entry.rect;
+        for(int line = 0; line < rect.height(); ++line) {
+            std::memcpy(atlas.scanLine(rect.y() + line) + rect.x() * 4, symbol.image.constScanLine(line), rect.width() * 4);
+        }
+    }
+    if(!atlas.save(outputBaseName + QLatin1String(".png"), "PNG")) {
+        std::cerr << "cannot write " << qPrintable(outputBaseName) << ".png" << std::endl;
+        return 1;
+    }
+
+    QFile indexFile(outputBaseName + QLatin1String(".index"));
+    if(!indexFile.open(QIODevice::WriteOnly)) {
+        std::cerr << "cannot write " << qPrintable(indexFile.fileName()) << std::endl;
+        return 1;
+    }
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << quint32(SYMBOL_ATLAS_MAGIC) << quint32(SYMBOL_ATLAS_VERSION) << qint32(symbols.size());
+    for(const Symbol &symbol : symbols) {
+        stream << symbol.entry;
+    }
+    return (stream.status() == QDataStream::Ok) ? 0 : 1;
+}
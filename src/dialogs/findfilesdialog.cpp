@@ -57,6 +57,7 @@
 #include <QObject>
 #include <QPushButton>
 #include <QRegExp>
+#include <QRegularExpression>
 #include <QVBoxLayout>
 
 #include <KProcess>
@@ -69,6 +70,8 @@
 #include <KUrlRequester>
 #include <KConfigGroup>
 
+#include "dialogs/findfilessearch.h"
+#include "documentinfo.h"
 #include "kiledebug.h"
 #include "kileconfig.h"
 #include "kileproject.h"
@@ -83,6 +86,7 @@ FindFilesDialog::FindFilesDialog(QWidget *parent, KileInfo *ki, KileGrep::Mode m
     , m_mode(mode)
     , m_proc(Q_NULLPTR)
     , m_grepJobs(0)
+    , m_search(Q_NULLPTR)
 {
     setObjectName(name);
     setWindowTitle(QString());
@@ -516,17 +520,7 @@ void FindFilesDialog::processOutput(bool forceAll)
     while((pos = m_buf.indexOf('\n')) != -1) {
         QString item = m_buf.left(pos);
         if(!item.isEmpty()) {
-            if(m_mode == KileGrep::Project) {
-                if (item.indexOf(m_projectdir) == 0) {
-                    new QListWidgetItem(item.mid(m_projectdir.length()), resultbox);
-                }
-                else {
-                    new QListWidgetItem(item, resultbox);
-                }
-            }
-            else {
-                new QListWidgetItem(item.mid(dir_combo->url().toLocalFile().length() + 1), resultbox);
-            }
+            addResultItem(item);
         }
         m_buf = m_buf.right(m_buf.length() - pos - 1);
         if(!forceAll) {
@@ -538,6 +532,21 @@ void FindFilesDialog::processOutput(bool forceAll)
     }
 }
 
+void FindFilesDialog::addResultItem(const QString &item)
+{
+    if(m_mode == KileGrep::Project) {
+        if (item.indexOf(m_projectdir) == 0) {
+            new QListWidgetItem(item.mid(m_projectdir.length()), resultbox);
+        }
+        else {
+            new QListWidgetItem(item, resultbox);
+        }
+    }
+    else {
+        new QListWidgetItem(item.mid(dir_combo->url().toLocalFile().length() + 1), resultbox);
+    }
+}
+
 void FindFilesDialog::processStandardOutputReady()
 {
     QByteArray outputBuffer = m_proc->readAllStandardOutput();
@@ -562,8 +571,53 @@ void FindFilesDialog::processExited(int /*exitCode*/, QProcess::ExitStatus /*exi
     }
 }
 
+void FindFilesDialog::startSearch(const QRegularExpression &regExp)
+{
+    if(!m_search) {
+        m_search = new FindFilesSearch(this);
+        connect(m_search, &FindFilesSearch::resultsAvailable,
+                this, &FindFilesDialog::searchResultsAvailable);
+        connect(m_search, &FindFilesSearch::finished,
+                this, &FindFilesDialog::finish);
+    }
+
+    // open documents are searched in their current state
+    QHash<QString, KileDocument::DocumentSnapshot> openDocuments;
+    Q_FOREACH(KileDocument::TextInfo *textInfo, m_ki->docManager()->textDocumentInfos()) {
+        const QUrl url = textInfo->url();
+        if(textInfo->getDoc() && url.isLocalFile()) {
+            openDocuments.insert(url.toLocalFile(), textInfo->documentSnapshot());
+        }
+    }
+    m_search->setOpenDocuments(openDocuments);
+
+    if (m_mode == KileGrep::Project) {
+        m_search->searchFiles(m_projectfiles, regExp);
+    }
+    else {
+        m_search->searchDirectory(dir_combo->url().toLocalFile(), getFilterPatterns(), recursive_box->isChecked(), regExp);
+    }
+}
+
+bool FindFilesDialog::isSearching() const
+{
+    return m_proc || (m_search && m_search->isRunning());
+}
+
+void FindFilesDialog::searchResultsAvailable(const QStringList &results)
+{
+    resultbox->setUpdatesEnabled(false);
+    for(const QString& item : results) {
+        addResultItem(item);
+    }
+    resultbox->setUpdatesEnabled(true);
+}
+
 void FindFilesDialog::finish()
 {
+    if(m_search) {
+        m_search->cancel();
+    }
     if(m_proc) {
         m_proc->kill();
         m_proc->disconnect();
@@ -628,9 +682,9 @@ QString FindFilesDialog::getShellPattern()
 }
 
 
-QString FindFilesDialog::buildFilesCommand()
+QStringList FindFilesDialog::getFilterPatterns()
 {
-    QString files, files_temp;
+    QString files_temp;
 
     if(filter_combo->currentIndex() >= 0) {
         files_temp = m_filterList[filter_combo->currentIndex()];
@@ -639,7 +693,14 @@ QString FindFilesDialog::buildFilesCommand()
         files_temp = filter_combo->currentText();
     }
 
-    QStringList tokens = files_temp.split(' ', QString::SkipEmptyParts);
+    return files_temp.split(' ', QString::SkipEmptyParts);
+}
+
+QString FindFilesDialog::buildFilesCommand()
+{
+    QString files;
+
+    QStringList tokens = getFilterPatterns();
     QStringList::Iterator it = tokens.begin();
     if (it != tokens.end()) {
         files = " '" + (*it) + '\'';
@@ -675,7 +736,7 @@ void FindFilesDialog::slotSearch()
 {
     KILE_DEBUG_MAIN << "\tgrep: start slot search" << m_proc;
 
-    if (m_proc) {
+    if (isSearching()) {
         clearGrepJobs();
         finish();
         return;
@@ -686,10 +747,21 @@ void FindFilesDialog::slotSearch()
     }
 
     KILE_DEBUG_MAIN << "\tgrep: start new search";
-    QRegExp re(getPattern());
-    if(!re.isValid()) {
-        KMessageBox::error(m_ki->mainWindow(), i18n("Invalid regular expression: %1", re.errorString()), i18n("Grep Tool Error"));
-        return;
+    const bool inProcess = KileConfig::grepInProcess();
+    QRegularExpression regExp;
+    if(inProcess) {
+        regExp = FindFilesSearch::compilePattern(getPattern());
+        if(!regExp.isValid()) {
+            KMessageBox::error(m_ki->mainWindow(), i18n("Invalid regular expression: %1", regExp.errorString()), i18n("Grep Tool Error"));
+            return;
+        }
+    }
+    else {
+        QRegExp re(getPattern());
+        if(!re.isValid()) {
+            KMessageBox::error(m_ki->mainWindow(), i18n("Invalid regular expression: %1", re.errorString()), i18n("Grep Tool Error"));
+            return;
+        }
     }
 
     resultbox->setCursor(QCursor(Qt::WaitCursor));
@@ -698,6 +770,12 @@ void FindFilesDialog::slotSearch()
         m_TemplateList[m_lastTemplateIndex] = template_edit->text();
     }
 
+    if(inProcess) {
+        clearGrepJobs();
+        startSearch(regExp);
+        return;
+    }
+
     // start grep command
     m_grepJobs = (m_mode == KileGrep::Project) ? m_projectfiles.count() : 1;
     startGrep();
@@ -37,6 +37,7 @@ class QLabel;
 class QLineEdit;
 class QListWidget;
 class QPushButton;
+class QRegularExpression;
 
 class KProcess;
 class KComboBox;
@@ -53,6 +54,8 @@ enum TemplateMode { tmNormal = 0, tmCommand, tmCommandWithOption, tmEnv, tmGraph
 
 namespace KileDialog {
 
+class FindFilesSearch;
+
 class FindFilesDialog : public QDialog
 {
     Q_OBJECT
@@ -77,6 +80,7 @@ private:
     KileGrep::Mode m_mode;
     KProcess *m_proc;
     int m_grepJobs;
+    FindFilesSearch *m_search;
 
     void readConfig();
     void writeConfig();
@@ -86,15 +90,19 @@ private:
     void updateListItems(KComboBox *combo);
 
     void processOutput(bool forceAll = false);
+    void addResultItem(const QString &item);
     void finish();
 
     void startGrep();
+    void startSearch(const QRegularExpression &regExp);
+    bool isSearching() const;
     bool shouldRestart() {
         return (m_grepJobs > 0);
     }
     void clearGrepJobs() {
         m_grepJobs = 0;
     }
+    QStringList getFilterPatterns();
     QString buildFilesCommand();
     QString buildProjectCommand();
     QString getPattern();
@@ -130,6 +138,7 @@ private Q_SLOTS:
     void processExited(int exitCode, QProcess::ExitStatus exitStatus);
     void processStandardOutputReady();
     void processErrorOutputReady();
+    void searchResultsAvailable(const QStringList &results);
     void slotItemSelected(const QString&);
     void slotSearch();
     void slotClear();
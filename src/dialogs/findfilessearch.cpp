@@ -0,0 +1,268 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dialogs/findfilessearch.h"
+
+#include <QDirIterator>
+#include <QFile>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include "kiledebug.h"
+
+namespace KileDialog {
+
+namespace {
+
+// the results are passed on to the dialog in batches
+const int reportInterval = 100;
+// number of lines after which it is checked whether the search has been cancelled
+const int cancelCheckInterval = 1024;
+
+template<class Lines>
+void matchLines(const QString& fileName, const Lines& lines, const QRegularExpression& regExp,
+                const QAtomicInt& cancelled, QStringList& results)
+{
+    for(int i = 0; i < lines.size(); ++i) {
+        if(i % cancelCheckInterval == 0 && cancelled.loadAcquire() != 0) {
+            return;
+        }
+        const QString& line = lines.at(i);
+        if(regExp.match(line).hasMatch()) {
+            results.append(fileName + ':' + QString::number(i + 1) + ':' + line);
+        }
+    }
+}
+
+}
+
+class FindFilesSearch::SearchTask : public QRunnable
+{
+public:
+    explicit SearchTask(FindFilesSearch *search)
+        : m_search(search)
+    {
+    }
+
+    void run() override
+    {
+        // every thread uses its own copy of the expression
+        const QRegularExpression regExp(m_search->m_regExp.pattern(), m_search->m_regExp.patternOptions());
+        while(!m_search->isCancelled()) {
+            const int index = m_search->m_nextFile.fetchAndAddOrdered(1);
+            if(index >= m_search->m_files.size()) {
+                break;
+            }
+            m_search->searchFile(index, regExp);
+        }
+        m_search->m_activeTasks.deref();
+    }
+
+private:
+    FindFilesSearch *m_search;
+};
+
+class FindFilesSearch::DirectoryScanTask : public QRunnable
+{
+public:
+    DirectoryScanTask(FindFilesSearch *search, const QString& directory, const QStringList& nameFilters, bool recursive)
+        : m_search(search)
+        , m_directory(directory)
+        , m_nameFilters(nameFilters)
+        , m_recursive(recursive)
+    {
+    }
+
+    void run() override
+    {
+        QStringList files;
+        QDirIterator it(m_directory, m_nameFilters, QDir::Files | QDir::Hidden,
+                        m_recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+        while(it.hasNext() && !m_search->isCancelled()) {
+            files.append(it.next());
+        }
+        if(!m_search->isCancelled()) {
+            m_search->m_files = files;
+            m_search->startSearchTasks();
+        }
+        m_search->m_activeTasks.deref();
+    }
+
+private:
+    FindFilesSearch *m_search;
+    QString m_directory;
+    QStringList m_nameFilters;
+    bool m_recursive;
+};
+
+FindFilesSearch::FindFilesSearch(QObject *parent)
+    : QObject(parent)
+    , m_running(false)
+    , m_nextFileToReport(0)
+{
+    m_threadPool.setMaxThreadCount(QThread::idealThreadCount());
+    m_reportTimer.setInterval(reportInterval);
+    connect(&m_reportTimer, &QTimer::timeout, this, &FindFilesSearch::reportResults);
+}
+
+FindFilesSearch::~FindFilesSearch()
+{
+    cancel();
+}
+
+QRegularExpression FindFilesSearch::compilePattern(const QString& pattern)
+{
+    QString perlPattern;
+    perlPattern.reserve(pattern.length());
+    for(int i = 0; i < pattern.length(); ++i) {
+        if(pattern[i] == '\\' && i + 1 < pattern.length()) {
+            const QChar next = pattern[++i];
+            if(next == '<' || next == '>') {
+                perlPattern += QLatin1String("\\b");
+            }
+            else {
+                perlPattern += '\\';
+                perlPattern += next;
+            }
+        }
+        else {
+            perlPattern += pattern[i];
+        }
+    }
+    return QRegularExpression(perlPattern);
+}
+
+void FindFilesSearch::setOpenDocuments(const QHash<QString, KileDocument::DocumentSnapshot>& documents)
+{
+    Q_ASSERT(!m_running);
+    m_openDocuments = documents;
+}
+
+void FindFilesSearch::searchFiles(const QStringList& files, const QRegularExpression& regExp)
+{
+    start(regExp);
+    m_files = files;
+    startSearchTasks();
+}
+
+void FindFilesSearch::searchDirectory(const QString& directory, const QStringList& nameFilters, bool recursive,
+                                      const QRegularExpression& regExp)
+{
+    start(regExp);
+    m_activeTasks.ref();
+    m_threadPool.start(new DirectoryScanTask(this, directory, nameFilters, recursive));
+}
+
+void FindFilesSearch::start(const QRegularExpression& regExp)
+{
+    cancel();
+
+    m_regExp = regExp;
+    m_files.clear();
+    m_nextFile.storeRelease(0);
+    m_activeTasks.storeRelease(0);
+    m_cancelled.storeRelease(0);
+    m_fileResults.clear();
+    m_nextFileToReport = 0;
+
+    m_running = true;
+    m_reportTimer.start();
+}
+
+// might be called from a worker thread
+void FindFilesSearch::startSearchTasks()
+{
+    const int taskCount = qMin(m_threadPool.maxThreadCount(), m_files.size());
+    KILE_DEBUG_MAIN << "searching" << m_files.size() << "files with" << taskCount << "threads";
+    for(int i = 0; i < taskCount; ++i) {
+        m_activeTasks.ref();
+        m_threadPool.start(new SearchTask(this));
+    }
+}
+
+void FindFilesSearch::searchFile(int index, const QRegularExpression& regExp)
+{
+    const QString& fileName = m_files[index];
+    QStringList results;
+
+    QHash<QString, KileDocument::DocumentSnapshot>::const_iterator it = m_openDocuments.constFind(fileName);
+    if(it != m_openDocuments.constEnd()) {
+        matchLines(fileName, *it, regExp, m_cancelled, results);
+    }
+    else {
+        QFile file(fileName);
+        if(file.open(QIODevice::ReadOnly)) {
+            const QByteArray contents = file.readAll();
+            // binary files are skipped, like with 'grep -I'
+            if(!contents.contains('\0')) {
+                QStringList lines = QString::fromLocal8Bit(contents).split('\n');
+                if(contents.endsWith('\n')) {
+                    lines.removeLast();
+                }
+                for(QString& line : lines) {
+                    if(line.endsWith('\r')) {
+                        line.chop(1);
+                    }
+                }
+                matchLines(fileName, lines, regExp, m_cancelled, results);
+            }
+        }
+    }
+
+    QMutexLocker locker(&m_resultMutex);
+    m_fileResults.insert(index, results);
+}
+
+void FindFilesSearch::reportResults()
+{
+    // all the results have been stored once no task is active anymore
+    const bool done = (m_activeTasks.loadAcquire() == 0);
+
+    QStringList results;
+    {
+        QMutexLocker locker(&m_resultMutex);
+        QMap<int, QStringList>::iterator it = m_fileResults.begin();
+        while(it != m_fileResults.end() && it.key() == m_nextFileToReport) {
+            results += *it;
+            it = m_fileResults.erase(it);
+            ++m_nextFileToReport;
+        }
+    }
+
+    if(done) {
+        m_threadPool.waitForDone();
+        m_reportTimer.stop();
+        m_running = false;
+    }
+    if(!results.isEmpty()) {
+        emit(resultsAvailable(results));
+    }
+    if(done) {
+        emit(finished());
+    }
+}
+
+void FindFilesSearch::cancel()
+{
+    if(!m_running) {
+        return;
+    }
+    m_cancelled.storeRelease(1);
+    m_threadPool.waitForDone();
+    m_reportTimer.stop();
+    m_fileResults.clear();
+    m_running = false;
+}
+
+}
@@ -0,0 +1,111 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FINDFILESSEARCH_H
+#define FINDFILESSEARCH_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+#include "documentsnapshot.h"
+
+namespace KileDialog {
+
+/**
+ * Searches files for a regular expression with several threads, without having to start
+ * a 'grep' process for every file.
+ *
+ * The matching lines are reported in the format of 'grep -n -H', i.e. as "file:line:text",
+ * and in the order of the files that are searched. Files that are opened in the editor are
+ * searched in the snapshots passed via @ref setOpenDocuments instead of on disk.
+ **/
+class FindFilesSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FindFilesSearch(QObject *parent = Q_NULLPTR);
+    ~FindFilesSearch();
+
+    /**
+     * Compiles a pattern in the syntax of 'grep -E'. The word boundaries '\<' and '\>'
+     * are translated, the other constructs used by Kile have the same meaning.
+     **/
+    static QRegularExpression compilePattern(const QString& pattern);
+
+    /**
+     * Sets the contents of the open documents, mapped from their local file names.
+     **/
+    void setOpenDocuments(const QHash<QString, KileDocument::DocumentSnapshot>& documents);
+
+    void searchFiles(const QStringList& files, const QRegularExpression& regExp);
+    void searchDirectory(const QString& directory, const QStringList& nameFilters, bool recursive,
+                         const QRegularExpression& regExp);
+
+    /**
+     * Stops the current search; no further results are reported and 'finished' is not emitted.
+     **/
+    void cancel();
+
+    bool isRunning() const {
+        return m_running;
+    }
+
+Q_SIGNALS:
+    void resultsAvailable(const QStringList& results);
+    void finished();
+
+private Q_SLOTS:
+    void reportResults();
+
+private:
+    class DirectoryScanTask;
+    class SearchTask;
+
+    QThreadPool m_threadPool;
+    QTimer m_reportTimer;
+    bool m_running;
+
+    // the following members are not changed while the tasks are running,
+    // except for 'm_files', which is filled by the directory scan first
+    QHash<QString, KileDocument::DocumentSnapshot> m_openDocuments;
+    QRegularExpression m_regExp;
+    QStringList m_files;
+
+    QAtomicInt m_nextFile;
+    QAtomicInt m_activeTasks;
+    QAtomicInt m_cancelled;
+
+    QMutex m_resultMutex;
+    // the matching lines of the files that have been searched, which haven't been reported yet
+    QMap<int, QStringList> m_fileResults;
+    int m_nextFileToReport;
+
+    void start(const QRegularExpression& regExp);
+    void startSearchTasks();
+    void searchFile(int index, const QRegularExpression& regExp);
+    bool isCancelled() const {
+        return m_cancelled.loadAcquire() != 0;
+    }
+};
+
+}
+
+#endif
@@ -221,8 +221,7 @@ QString IncludeGraphics::getTemplate()
         // Sending a warning to the log here would be good, but
         // the log seems to get cleared before user could catch
         // the warning.
-        QStringList packagelist = m_ki->allPackages();
-        if (!packagelist.contains("wrapfig")) {
+        if (!m_ki->isSymbolDefined(KileDocument::SymbolIndex::Packages, "wrapfig")) {
             s += "%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%\n";
             s += "%%% You will need to add \\usepackage{wrapfig} to your preamble to use textwrapping %%%\n";
             s += "%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%\n";
@@ -613,8 +612,7 @@ void IncludeGraphics::onWrapFigureSelected(bool state) {
         m_widget.cb_figure->setChecked(false);
     }
     // Adds warning to log if wrapfig isn't in the preamble
-    QStringList packagelist = m_ki->allPackages();
-    if (!packagelist.contains("wrapfig")) {
+    if (!m_ki->isSymbolDefined(KileDocument::SymbolIndex::Packages, "wrapfig")) {
         m_ki->errorHandler()->printMessage(KileTool::Error, i18n("You must include the wrapfig package to use the text wrapping options"), i18n("Missing Package"));
     }
 }
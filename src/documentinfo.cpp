@@ -73,6 +73,7 @@
 #include <KIO/StatJob>
 #include <KLocalizedString>
 #include <KMessageBox>
+#include <KTextEditor/MovingInterface>
 
 #include "abbreviationmanager.h"
 #include "codecompletion.h"
@@ -91,6 +92,65 @@
 namespace KileDocument
 {
 
+namespace {
+// only accessed from the GUI thread
+quint64 s_lastSnapshotRevision = 0;
+}
+
+EditedLineRange::EditedLineRange()
+    : valid(false),
+      firstLine(-1),
+      lastLine(-1),
+      lineDelta(0),
+      baseRevision(0),
+      revision(0)
+{
+}
+
+void EditedLineRange::addLines(int first, int last)
+{
+    if(firstLine < 0) {
+        firstLine = first;
+        lastLine = last;
+    }
+    else {
+        firstLine = qMin(firstLine, first);
+        lastLine = qMax(lastLine, last);
+    }
+}
+
+EditedLineRange EditedLineRange::followedBy(const EditedLineRange& next) const
+{
+    EditedLineRange toReturn(next);
+    toReturn.baseRevision = baseRevision;
+    if(!valid || !next.valid || revision != next.baseRevision) {
+        toReturn.valid = false;
+        return toReturn;
+    }
+    toReturn.lineDelta = lineDelta + next.lineDelta;
+    if(isEmpty()) {
+        return toReturn;
+    }
+    if(next.isEmpty()) {
+        toReturn.firstLine = firstLine;
+        toReturn.lastLine = lastLine;
+        return toReturn;
+    }
+    // map our lines onto the lines of the snapshot 'next' refers to:
+    // lines in front of the range edited by 'next' are unchanged, and lines
+    // behind it are shifted by 'next.lineDelta'
+    const int nextOldLastLine = next.lastLine - next.lineDelta;
+    int first = firstLine, last = lastLine;
+    if(first >= next.firstLine) {
+        first = (first > nextOldLastLine) ? first + next.lineDelta : next.firstLine;
+    }
+    if(last >= next.firstLine) {
+        last = (last > nextOldLastLine) ? last + next.lineDelta : next.lastLine;
+    }
+    toReturn.addLines(first, last);
+    return toReturn;
+}
+
 bool Info::containsInvalidCharacters(const QUrl &url)
 {
     QString filename = url.fileName();
@@ -404,7 +464,11 @@ TextInfo::TextInfo(Extensions* extensions,
     : m_doc(Q_NULLPTR),
       m_defaultMode(defaultMode),
       m_abbreviationManager(abbreviationManager),
-      m_parserManager(parserManager)
+      m_parserManager(parserManager),
+      m_editedLinesRange(Q_NULLPTR),
+      m_editedLinesKnown(false),
+      m_snapshotLineCount(-1),
+      m_snapshotRevision(0)
 {
     m_arStatistics = new long[SIZE_STAT_ARRAY];
 
@@ -456,11 +520,21 @@ void TextInfo::setDocument(KTextEditor::Document *doc)
     detach();
     if(doc) {
         m_doc = doc;
-        m_documentContents.clear();
+        m_snapshot = DocumentSnapshot();
         connect(m_doc, SIGNAL(documentNameChanged(KTextEditor::Document*)), this, SLOT(slotFileNameChanged()));
         connect(m_doc, SIGNAL(documentUrlChanged(KTextEditor::Document*)), this, SLOT(slotFileNameChanged()));
         connect(m_doc, SIGNAL(completed()), this, SLOT(slotCompleted()));
         connect(m_doc, SIGNAL(modifiedChanged(KTextEditor::Document*)), this, SLOT(makeDirtyIfModified()));
+        // the parser cache only stores the results for saved contents
+        connect(m_doc, SIGNAL(documentSavedOrUploaded(KTextEditor::Document*,bool)), this, SLOT(updateStruct()));
+        // track the edited lines for incremental parsing
+        connect(m_doc, SIGNAL(textInserted(KTextEditor::Document*,KTextEditor::Range)),
+                this, SLOT(handleTextInserted(KTextEditor::Document*,KTextEditor::Range)));
+        connect(m_doc, SIGNAL(textRemoved(KTextEditor::Document*,KTextEditor::Range,QString)),
+                this, SLOT(handleTextRemoved(KTextEditor::Document*,KTextEditor::Range,QString)));
+        connect(m_doc, SIGNAL(reloaded(KTextEditor::Document*)), this, SLOT(invalidateEditedLineRange()));
+        connect(m_doc, SIGNAL(aboutToInvalidateMovingInterfaceContent(KTextEditor::Document*)), this, SLOT(invalidateEditedLineRange()));
+        connect(m_doc, SIGNAL(aboutToDeleteMovingInterfaceContent(KTextEditor::Document*)), this, SLOT(invalidateEditedLineRange()));
         // this could be a KatePart bug, and as "work-around" we manually set the highlighting mode again
         connect(m_doc, SIGNAL(completed()), this, SLOT(activateDefaultMode()));
         setMode(m_defaultMode);
@@ -472,6 +546,7 @@ void TextInfo::setDocument(KTextEditor::Document *doc)
 void TextInfo::detach()
 {
     if(m_doc) {
+        deleteEditedLinesRange();
         m_doc->disconnect(this);
         removeInstalledEventFilters();
         removeSignalConnections();
@@ -479,6 +554,10 @@ void TextInfo::detach()
         emit(documentDetached(m_doc));
     }
     m_doc = Q_NULLPTR;
+    m_editedLinesKnown = false;
+    m_snapshotRevision = 0;
+    m_snapshot = DocumentSnapshot();
+    m_pendingEditedLineRange = EditedLineRange();
 }
 
 void TextInfo::makeDirtyIfModified()
@@ -832,13 +911,130 @@ const QStringList TextInfo::documentContents() const
         return m_doc->textLines(m_doc->documentRange());
     }
     else {
-        return m_documentContents;
+        return m_snapshot.toStringList();
     }
 }
 
 void TextInfo::setDocumentContents(const QStringList& contents)
 {
-    m_documentContents = contents;
+    m_snapshot = DocumentSnapshot(contents);
+}
+
+DocumentSnapshot TextInfo::documentSnapshot()
+{
+    updateDocumentSnapshot();
+    return m_snapshot;
+}
+
+EditedLineRange TextInfo::takeEditedLineRange()
+{
+    updateDocumentSnapshot();
+    EditedLineRange range = m_pendingEditedLineRange;
+    if(m_doc) {
+        // the next range starts at the current snapshot
+        m_pendingEditedLineRange = EditedLineRange();
+        m_pendingEditedLineRange.valid = true;
+        m_pendingEditedLineRange.baseRevision = m_snapshotRevision;
+        m_pendingEditedLineRange.revision = m_snapshotRevision;
+    }
+    return range;
+}
+
+// Only the lines that have been edited since the last snapshot are copied from the document.
+// The edited lines are also accumulated in 'm_pendingEditedLineRange' for the parser.
+void TextInfo::updateDocumentSnapshot()
+{
+    if(!m_doc) {
+        // edits cannot be tracked without a document; 'm_snapshot' contains
+        // the contents set with 'setDocumentContents'
+        m_snapshotRevision = 0;
+        m_pendingEditedLineRange = EditedLineRange();
+        return;
+    }
+    EditedLineRange range;
+    range.baseRevision = m_snapshotRevision;
+    range.valid = (m_editedLinesKnown && m_snapshotRevision > 0);
+    range.lineDelta = m_doc->lines() - m_snapshotLineCount;
+    if(m_editedLinesRange) {
+        range.addLines(m_editedLinesRange->start().line(), m_editedLinesRange->end().line());
+    }
+    if(range.valid && range.isEmpty() && range.lineDelta == 0) {
+        // nothing has changed
+        return;
+    }
+    range.revision = ++s_lastSnapshotRevision;
+
+    if(range.valid && !range.isEmpty()) {
+        const int removeCount = range.lastLine - range.lineDelta - range.firstLine + 1;
+        if(removeCount >= 0 && range.firstLine + removeCount <= m_snapshot.size()) {
+            QStringList lines;
+            for(int line = range.firstLine; line <= range.lastLine; ++line) {
+                lines.append(m_doc->line(line));
+            }
+            m_snapshot = m_snapshot.withReplacedLines(range.firstLine, removeCount, lines);
+        }
+        else {
+            range.valid = false;
+        }
+    }
+    if(!range.valid || m_snapshot.size() != m_doc->lines()) {
+        range.valid = false;
+        m_snapshot = DocumentSnapshot(m_doc->textLines(m_doc->documentRange()));
+    }
+
+    deleteEditedLinesRange();
+    m_editedLinesKnown = true;
+    m_snapshotLineCount = m_doc->lines();
+    m_snapshotRevision = range.revision;
+    m_pendingEditedLineRange = m_pendingEditedLineRange.followedBy(range);
+}
+
+void TextInfo::markLinesAsEdited(int first, int last)
+{
+    if(!m_doc || !m_editedLinesKnown) {
+        return;
+    }
+    // a moving range is used as its position is automatically adjusted by
+    // the document when lines are inserted or removed in front of it
+    if(!m_editedLinesRange) {
+        KTextEditor::MovingInterface *movingInterface = qobject_cast<KTextEditor::MovingInterface*>(m_doc);
+        if(!movingInterface) {
+            m_editedLinesKnown = false;
+            return;
+        }
+        m_editedLinesRange = movingInterface->newMovingRange(KTextEditor::Range(first, 0, last, m_doc->lineLength(last)),
+                                                             KTextEditor::MovingRange::ExpandLeft | KTextEditor::MovingRange::ExpandRight);
+        return;
+    }
+    first = qMin(first, m_editedLinesRange->start().line());
+    last = qMax(last, m_editedLinesRange->end().line());
+    m_editedLinesRange->setRange(KTextEditor::Range(first, 0, last, m_doc->lineLength(last)));
+}
+
+void TextInfo::deleteEditedLinesRange()
+{
+    delete m_editedLinesRange;
+    m_editedLinesRange = Q_NULLPTR;
+}
+
+void TextInfo::handleTextInserted(KTextEditor::Document *document, const KTextEditor::Range &range)
+{
+    Q_UNUSED(document);
+    markLinesAsEdited(range.start().line(), range.end().line());
+}
+
+void TextInfo::handleTextRemoved(KTextEditor::Document *document, const KTextEditor::Range &range, const QString &oldText)
+{
+    Q_UNUSED(document);
+    Q_UNUSED(oldText);
+    // the removed lines have been merged into the start line of 'range'
+    markLinesAsEdited(range.start().line(), range.start().line());
+}
+
+void TextInfo::invalidateEditedLineRange()
+{
+    deleteEditedLinesRange();
+    m_editedLinesKnown = false;
 }
 
 LaTeXInfo::LaTeXInfo(Extensions* extensions,
@@ -985,6 +1181,9 @@ void LaTeXInfo::updateStructLevelInfo() {
     for(it=list.constBegin(); it != list.constEnd(); ++it) {
         m_dictStructLevel[*it] = KileStructData(0, KileStruct::Bibliography, "viewbib");
     }
+
+    // previous parsing results cannot be reused anymore
+    invalidateEditedLineRange();
 }
 
 QList<QObject*> LaTeXInfo::createEventFilters(KTextEditor::View *view)
@@ -18,8 +18,10 @@
 #include <QHash>
 
 #include <KTextEditor/Document>
+#include <KTextEditor/MovingRange>
 #include <QUrl>
 
+#include "documentsnapshot.h"
 #include "kiledebug.h"
 
 #include <latexcmd.h>
@@ -127,6 +129,45 @@ struct TodoResult
     QString comment;
 };
 
+/**
+ * Describes which lines of a document have been edited between two snapshots of its
+ * contents that have been handed over to the parser. Every snapshot is identified by a
+ * revision number; 'firstLine' and 'lastLine' refer to the lines of the newer snapshot,
+ * and 'lineDelta' is the number of lines that have been added (or removed if negative).
+ * An invalid range indicates that the edits are not known and that the whole document
+ * has to be parsed again.
+ **/
+class EditedLineRange
+{
+public:
+    EditedLineRange();
+
+    bool isValid() const {
+        return valid;
+    }
+    /**
+     * Returns true iff the range is valid and no line has been edited.
+     **/
+    bool isEmpty() const {
+        return valid && firstLine < 0;
+    }
+    void addLines(int first, int last);
+
+    /**
+     * Combines this range with the range 'next', which describes the edits that have
+     * been performed on the snapshot with revision 'revision'. The returned range
+     * describes all the edits between 'baseRevision' and 'next.revision'.
+     **/
+    EditedLineRange followedBy(const EditedLineRange& next) const;
+
+    bool valid;
+    int firstLine;
+    int lastLine;
+    int lineDelta;
+    quint64 baseRevision;
+    quint64 revision;
+};
+
 class Info : public QObject
 {
     Q_OBJECT
@@ -348,6 +389,20 @@ public:
     const QStringList documentContents() const;
     void setDocumentContents(const QStringList& contents);
 
+    /**
+     * Returns a snapshot of the current contents of the document, or of the contents supplied
+     * via @ref setDocumentContents if no KTextEditor::Document is present. Only the lines that
+     * have been edited since the previous snapshot are copied from the document.
+     **/
+    DocumentSnapshot documentSnapshot();
+
+    /**
+     * Returns the lines that have been edited since the last call of this method, relative to
+     * the current snapshot (see @ref documentSnapshot). The range is only valid if a
+     * KTextEditor::Document is present and all the edits could be tracked.
+     **/
+    EditedLineRange takeEditedLineRange();
+
 Q_SIGNALS:
     void documentDetached(KTextEditor::Document*);
     void aboutToBeDestroyed(KileDocument::TextInfo*);
@@ -359,6 +414,10 @@ protected Q_SLOTS:
 
     void makeDirtyIfModified();
 
+    void handleTextInserted(KTextEditor::Document *document, const KTextEditor::Range &range);
+    void handleTextRemoved(KTextEditor::Document *document, const KTextEditor::Range &range, const QString &oldText);
+    void invalidateEditedLineRange();
+
 protected:
     KTextEditor::Document				*m_doc;
     bool						m_dirty;
@@ -459,7 +518,17 @@ protected:
     void unregisterCodeCompletionModels();
 
 private:
-    QStringList m_documentContents;
+    DocumentSnapshot m_snapshot;
+    // the lines edited since the last call of 'takeEditedLineRange'
+    EditedLineRange m_pendingEditedLineRange;
+    KTextEditor::MovingRange *m_editedLinesRange;
+    bool m_editedLinesKnown;
+    int m_snapshotLineCount;
+    quint64 m_snapshotRevision;
+
+    void updateDocumentSnapshot();
+    void markLinesAsEdited(int first, int last);
+    void deleteEditedLinesRange();
 };
 
 
@@ -0,0 +1,173 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "documentsnapshot.h"
+
+#include <QCryptographicHash>
+
+#include <algorithm>
+
+namespace KileDocument {
+
+namespace {
+// the preferred number of lines per chunk; chunks that result from edits
+// can contain between one and twice as many lines
+const int chunkSize = 256;
+}
+
+DocumentSnapshot::DocumentSnapshot()
+    : m_lineCount(0)
+{
+}
+
+DocumentSnapshot::DocumentSnapshot(const QStringList& lines)
+    : m_lineCount(lines.size())
+{
+    appendChunks(m_chunks, lines.toVector());
+    updateChunkStartLines();
+}
+
+QSharedPointer<const DocumentSnapshot::Chunk> DocumentSnapshot::createChunk(const QVector<QString>& lines)
+{
+    Chunk *chunk = new Chunk();
+    chunk->lines = lines;
+    QCryptographicHash cryptographicHash(QCryptographicHash::Sha1);
+    for(const QString& line : lines) {
+        cryptographicHash.addData(reinterpret_cast<const char*>(line.constData()), line.length() * sizeof(QChar));
+        cryptographicHash.addData("\n", 1);
+    }
+    chunk->hash = cryptographicHash.result();
+    return QSharedPointer<const Chunk>(chunk);
+}
+
+void DocumentSnapshot::appendChunks(QVector<QSharedPointer<const Chunk> > &chunks, const QVector<QString>& lines)
+{
+    const int lineCount = lines.size();
+    // split 'lines' into chunks of roughly equal size
+    const int chunkCount = (lineCount + chunkSize - 1) / chunkSize;
+    for(int i = 0; i < chunkCount; ++i) {
+        const int begin = (i * lineCount) / chunkCount;
+        const int end = ((i + 1) * lineCount) / chunkCount;
+        chunks.append(createChunk(lines.mid(begin, end - begin)));
+    }
+}
+
+void DocumentSnapshot::updateChunkStartLines()
+{
+    m_chunkStartLines.resize(m_chunks.size());
+    int line = 0;
+    for(int i = 0; i < m_chunks.size(); ++i) {
+        m_chunkStartLines[i] = line;
+        line += m_chunks[i]->lines.size();
+    }
+    Q_ASSERT(line == m_lineCount);
+}
+
+int DocumentSnapshot::chunkIndexFor(int line) const
+{
+    QVector<int>::const_iterator it = std::upper_bound(m_chunkStartLines.constBegin(), m_chunkStartLines.constEnd(), line);
+    return (it - m_chunkStartLines.constBegin()) - 1;
+}
+
+const QString& DocumentSnapshot::at(int line) const
+{
+    Q_ASSERT(line >= 0 && line < m_lineCount);
+    const int index = chunkIndexFor(line);
+    return m_chunks[index]->lines[line - m_chunkStartLines[index]];
+}
+
+QStringList DocumentSnapshot::toStringList() const
+{
+    QStringList toReturn;
+    toReturn.reserve(m_lineCount);
+    for(const QSharedPointer<const Chunk>& chunk : m_chunks) {
+        for(const QString& line : chunk->lines) {
+            toReturn.append(line);
+        }
+    }
+    return toReturn;
+}
+
+QByteArray DocumentSnapshot::hash() const
+{
+    QCryptographicHash cryptographicHash(QCryptographicHash::Sha1);
+    for(const QSharedPointer<const Chunk>& chunk : m_chunks) {
+        cryptographicHash.addData(chunk->hash);
+    }
+    return cryptographicHash.result();
+}
+
+QByteArray DocumentSnapshot::contentHash() const
+{
+    QCryptographicHash cryptographicHash(QCryptographicHash::Sha1);
+    for(const QSharedPointer<const Chunk>& chunk : m_chunks) {
+        for(const QString& line : chunk->lines) {
+            cryptographicHash.addData(reinterpret_cast<const char*>(line.constData()), line.length() * sizeof(QChar));
+            cryptographicHash.addData("\n", 1);
+        }
+    }
+    return cryptographicHash.result();
+}
+
+DocumentSnapshot DocumentSnapshot::withReplacedLines(int first, int removeCount, const QStringList& lines) const
+{
+    Q_ASSERT(first >= 0 && removeCount >= 0 && first + removeCount <= m_lineCount);
+
+    if(m_chunks.isEmpty()) {
+        return DocumentSnapshot(lines);
+    }
+
+    // the chunks from 'firstChunk' to 'lastChunk' (inclusive) are replaced
+    const int firstChunk = (first < m_lineCount) ? chunkIndexFor(first) : m_chunks.size() - 1;
+    const int lastChunk = (removeCount > 0) ? chunkIndexFor(first + removeCount - 1) : firstChunk;
+
+    QVector<QString> newLines;
+    const int firstChunkStartLine = m_chunkStartLines[firstChunk];
+    const QVector<QString>& firstChunkLines = m_chunks[firstChunk]->lines;
+    const QVector<QString>& lastChunkLines = m_chunks[lastChunk]->lines;
+    const int lastChunkStartLine = m_chunkStartLines[lastChunk];
+    const int suffixStart = first + removeCount - lastChunkStartLine;
+    newLines.reserve((first - firstChunkStartLine) + lines.size() + (lastChunkLines.size() - suffixStart));
+    for(int i = 0; i < first - firstChunkStartLine; ++i) {
+        newLines.append(firstChunkLines[i]);
+    }
+    for(const QString& line : lines) {
+        newLines.append(line);
+    }
+    for(int i = suffixStart; i < lastChunkLines.size(); ++i) {
+        newLines.append(lastChunkLines[i]);
+    }
+
+    DocumentSnapshot toReturn;
+    toReturn.m_lineCount = m_lineCount - removeCount + lines.size();
+    toReturn.m_chunks.reserve(m_chunks.size() + newLines.size() / chunkSize + 1);
+    for(int i = 0; i < firstChunk; ++i) {
+        toReturn.m_chunks.append(m_chunks[i]);
+    }
+    // chunks are only split once they have grown to twice the preferred size
+    if(newLines.size() <= 2 * chunkSize) {
+        if(!newLines.isEmpty()) {
+            toReturn.m_chunks.append(createChunk(newLines));
+        }
+    }
+    else {
+        appendChunks(toReturn.m_chunks, newLines);
+    }
+    for(int i = lastChunk + 1; i < m_chunks.size(); ++i) {
+        toReturn.m_chunks.append(m_chunks[i]);
+    }
+    toReturn.updateChunkStartLines();
+    return toReturn;
+}
+
+}
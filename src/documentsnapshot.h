@@ -0,0 +1,93 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DOCUMENTSNAPSHOT_H
+#define DOCUMENTSNAPSHOT_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace KileDocument {
+
+/**
+ * An immutable copy of the lines of a document, which can be copied in constant time and
+ * passed to other threads.
+ *
+ * The lines are stored in chunks that are shared between the snapshots of a document, i.e.
+ * the snapshot of the next revision of a document is created by only replacing the chunks
+ * that contain edited lines (see @ref withReplacedLines).
+ **/
+class DocumentSnapshot
+{
+public:
+    DocumentSnapshot();
+    explicit DocumentSnapshot(const QStringList& lines);
+
+    int size() const {
+        return m_lineCount;
+    }
+
+    bool isEmpty() const {
+        return m_lineCount == 0;
+    }
+
+    const QString& at(int line) const;
+
+    const QString& operator[](int line) const {
+        return at(line);
+    }
+
+    QStringList toStringList() const;
+
+    /**
+     * Returns a hash of the contents, which is computed from the hashes of the chunks.
+     * As a consequence, snapshots with the same contents but a different history of edits
+     * might have different hashes.
+     **/
+    QByteArray hash() const;
+
+    /**
+     * Returns a hash of the lines that only depends on the contents, i.e. it is the same for
+     * all the snapshots with the same lines. Unlike @ref hash, all the lines are hashed again.
+     **/
+    QByteArray contentHash() const;
+
+    /**
+     * Returns a snapshot in which the 'removeCount' lines starting at line 'first' have been
+     * replaced by 'lines'. Only the chunks containing the replaced lines are copied.
+     **/
+    DocumentSnapshot withReplacedLines(int first, int removeCount, const QStringList& lines) const;
+
+private:
+    struct Chunk {
+        QVector<QString> lines;
+        QByteArray hash;
+    };
+
+    QVector<QSharedPointer<const Chunk> > m_chunks;
+    // the number of the first line of every chunk
+    QVector<int> m_chunkStartLines;
+    int m_lineCount;
+
+    static QSharedPointer<const Chunk> createChunk(const QVector<QString>& lines);
+    static void appendChunks(QVector<QSharedPointer<const Chunk> > &chunks, const QVector<QString>& lines);
+    int chunkIndexFor(int line) const;
+    void updateChunkStartLines();
+};
+
+}
+
+#endif
@@ -3247,8 +3247,7 @@ bool EditorExtension::insertSpecialCharacter(const QString& texString, KTextEdit
 
     // Check dependency
     if (!dep.isEmpty()) {
-        QStringList packagelist = m_ki->allPackages();
-        if(!packagelist.contains(dep)) {
+        if(!m_ki->isSymbolDefined(KileDocument::SymbolIndex::Packages, dep)) {
             m_ki->errorHandler()->printMessage(KileTool::Error, i18n("You have to include the package %1 to use %2.", dep, texString), i18n("Missing Package"));
             KILE_DEBUG_MAIN << "Need package "<< dep;
         }
@@ -351,9 +351,7 @@ void KileErrorHandler::displayProblemsInLogWidget(KileWidget::LogWidget *logWidg
 {
     QString message;
     int type = KileTool::Info;
-
-    //print detailed error info
-    logWidget->setUpdatesEnabled(false);
+    QList<KileWidget::LogWidget::ProblemInformation> problems;
 
     for(QList<LatexOutputInfo>::const_iterator i = infoList.begin();
             i != infoList.end(); ++i) {
@@ -393,11 +391,11 @@ void KileErrorHandler::displayProblemsInLogWidget(KileWidget::LogWidget *logWidg
         problem.type = type;
         problem.message = message;
         problem.outputInfo = info;
-        logWidget->printMessage(type, message, QString(), info, false, false);
+        problems.append(problem);
     }
 
-    logWidget->setUpdatesEnabled(true);
-    logWidget->scrollToBottom();
+    //print detailed error info
+    logWidget->printProblems(problems);
 }
 
 void KileErrorHandler::printNoInformationAvailable()
@@ -25,10 +25,13 @@
 #include <QHideEvent>
 #include <QMenuBar>
 #include <QPointer>
+#include <QSharedPointer>
 #include <QShowEvent>
 #include <QSplashScreen>
 #include <QStandardPaths>
 #include <QStatusBar>
+#include <QTextCodec>
+#include <QTimer>
 #include <QXmlStreamWriter>
 
 #include <KAboutApplicationDialog>
@@ -99,6 +102,7 @@
 #include "dialogs/usermenu/usermenudialog.h"
 #include "usermenu/usermenudata.h"
 #include "usermenu/usermenu.h"
+#include "startupprofiler.h"
 #include "utilities.h"
 
 #define LOG_TAB     0
@@ -153,8 +157,11 @@ Kile::Kile(bool allowRestore, QWidget *parent)
       m_buildMenuOther(Q_NULLPTR),
       m_buildMenuQuickPreview(Q_NULLPTR),
       m_actRecentProjects(Q_NULLPTR),
-      m_lyxserver(Q_NULLPTR)
+      m_lyxserver(Q_NULLPTR),
+      m_deferredInitializationDone(false)
 {
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("document, parser and template managers"));
+
     setObjectName("Kile");
 
     m_config = KSharedConfig::openConfig();
@@ -165,6 +172,7 @@ Kile::Kile(bool allowRestore, QWidget *parent)
 
     m_viewManager= new KileView::Manager(this, actionCollection(), parent, "KileView::Manager");
     viewManager()->setClient(this);
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("view manager and document viewer"));
 
     // fail gracefully if we cannot instantiate Okular part correctly
     if(!m_viewManager->viewerPart()) {
@@ -194,6 +202,7 @@ Kile::Kile(bool allowRestore, QWidget *parent)
     m_bWatchFile = false;
 
     setStatusBar(new KileWidget::StatusBar(m_errorHandler, parent));
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("editor extensions and script manager"));
 
     // process events for correctly displaying the splash screen
     qApp->processEvents();
@@ -240,6 +249,7 @@ Kile::Kile(bool allowRestore, QWidget *parent)
     m_verticalSplitter->addWidget(m_bottomBar);
     m_topWidgetStack->addWidget(m_horizontalSplitter);
     setCentralWidget(m_topWidgetStack);
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("side bar and bottom bar"));
 
     // Parser manager and view manager must be created before the tool manager!
     m_manager = new KileTool::Manager(this, m_config.data(), m_outputWidget, m_topWidgetStack, 10000, actionCollection()); //FIXME make timeout configurable
@@ -262,6 +272,7 @@ Kile::Kile(bool allowRestore, QWidget *parent)
     setupActions();
 
     initSelectActions();
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("tool manager, live preview and actions"));
 
     newCaption();
 
@@ -314,6 +325,7 @@ Kile::Kile(bool allowRestore, QWidget *parent)
     readGUISettings();
     readRecentFileSettings();
     readConfig();
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("reading the configuration"));
 
     createToolActions(); // this creates the actions for the tools and user tags, which is required before 'activePartGUI' is called
 
@@ -325,6 +337,7 @@ Kile::Kile(bool allowRestore, QWidget *parent)
     connect(m_userMenu, &KileMenu::UserMenu::updateStatus, this, &Kile::slotUpdateUserMenuStatus);
 
     updateUserDefinedMenus();
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("creating the GUI and the user menu"));
 
     // we can only do this here after the main GUI has been set up
     {
@@ -370,6 +383,7 @@ Kile::Kile(bool allowRestore, QWidget *parent)
     if(KileConfig::showSplashScreen()) {
         splashScreen.finish(this);
     }
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("showing the main window"));
 
     // Due to 'processEvents' being called earlier we only create the DBUS adaptor and
     // the LyX server when all of Kile's structures have been set up.
@@ -400,6 +414,7 @@ Kile::Kile(bool allowRestore, QWidget *parent)
     }
 
     restoreFilesAndProjects(allowRestore);
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("restoring the files and projects"));
     initMenu();
     updateModeStatus();
 
@@ -430,12 +445,38 @@ Kile::Kile(bool allowRestore, QWidget *parent)
         m_livePreviewManager->buildLivePreviewMenu(m_config.data());
         m_livePreviewManager->disableBootUpMode();
     }
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("remaining initialization"));
+
+    // the timer fires once the events that are pending after the constructor has finished, like
+    // the first paint events of the main window, have been processed
+    QTimer::singleShot(0, this, &Kile::initializeDeferredSubsystems);
+}
+
+void Kile::initializeDeferredSubsystems()
+{
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("first paint of the main window"));
+
+    m_deferredInitializationDone = true;
+    m_codeCompletionManager->readConfig(m_config.data());
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("reading the completion word lists"));
+
+    m_jScriptManager->readConfig();
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("scanning the script directories"));
+
+    m_commandViewToolBox->readCommandViewFiles();
+    abbreviationManager()->readAbbreviationFiles();
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("reading the command view and abbreviation files"));
+
+    KileUtilities::StartupProfiler::report();
 }
 
 Kile::~Kile()
 {
     KILE_DEBUG_MAIN << "cleaning up..." << endl;
 
+    // the files that are being converted must not be left half-written
+    m_conversionThreadPool.waitForDone();
+
     guiFactory()->removeClient(viewManager()->viewerPart());
 
     delete m_userMenu;
@@ -869,6 +910,7 @@ void Kile::setupActions()
     // tbraun
     createAction(i18n("Open All &Project Files"), "project_openallfiles", docManager(), [this]() { docManager()->projectOpenAllFiles(); });
     createAction(i18n("Find in &Project..."), "project_findfiles", "projectgrep", this, &Kile::findInProjects);
+    createAction(i18n("Convert Project Files to &ASCII"), "project_convert_ascii", this, [this]() { convertProjectToASCII(); });
 
     //build actions
     act = createAction(i18n("Clean"), "CleanAll", "user-trash", this, [this]() { cleanAll(); });
@@ -1666,6 +1708,77 @@ void Kile::convertToEnc(KTextEditor::Document *doc)
     }
 }
 
+void Kile::convertProjectToASCII()
+{
+    KileProject *project = docManager()->activeProject();
+    if(!project) {
+        return;
+    }
+
+    // the open documents are converted in the editor such that the conversion can be undone,
+    // the remaining files are converted in the background
+    QList<KTextEditor::Document*> openDocuments;
+    QMap<QString, QList<QUrl> > filesByEncoding;
+    QStringList skippedFiles;
+    int fileCount = 0;
+    const QList<KileProjectItem*> items = project->items();
+    for(KileProjectItem *item : items) {
+        if(item->type() != KileProjectItem::Source && item->type() != KileProjectItem::Package
+                && item->type() != KileProjectItem::Bibliography) {
+            continue;
+        }
+        KTextEditor::Document *doc = docManager()->docFor(item->url());
+        QString encoding = doc ? doc->encoding() : item->encoding();
+        if(encoding.isEmpty()) {
+            encoding = QString::fromLatin1(QTextCodec::codecForLocale()->name());
+        }
+        // encodings without a conversion map, like UTF-8, are left alone
+        if(!ConvertMap::create(encoding)) {
+            skippedFiles.append(item->url().toLocalFile());
+        }
+        else if(doc) {
+            openDocuments.append(doc);
+        }
+        else {
+            filesByEncoding[encoding].append(item->url());
+            ++fileCount;
+        }
+    }
+
+    if(fileCount > 0 && KMessageBox::warningContinueCancel(this,
+            i18np("One project file that is not open will be converted to ASCII on disk.\nThis cannot be undone.",
+                  "%1 project files that are not open will be converted to ASCII on disk.\nThis cannot be undone.",
+                  fileCount),
+            i18n("Convert Project Files to ASCII"), KStandardGuiItem::cont(), KStandardGuiItem::cancel(),
+            QString(), KMessageBox::Notify | KMessageBox::Dangerous) != KMessageBox::Continue) {
+        return;
+    }
+
+    for(KTextEditor::Document *doc : openDocuments) {
+        convertToASCII(doc);
+    }
+
+    if(!skippedFiles.isEmpty()) {
+        KMessageBox::informationList(this, i18n("The following files were not converted as there is no conversion map for their encoding:"),
+                                     skippedFiles, i18n("Files Not Converted"));
+    }
+
+    // the failures are reported once all the encodings have been processed
+    QSharedPointer<QStringList> failedFiles(new QStringList);
+    QSharedPointer<int> remainingEncodings(new int(filesByEncoding.size()));
+    for(QMap<QString, QList<QUrl> >::const_iterator it = filesByEncoding.constBegin(); it != filesByEncoding.constEnd(); ++it) {
+        ConvertEncToASCII::convertFiles(*it, it.key(), &m_conversionThreadPool, this, [=](const QList<QUrl> &failedUrls) {
+            for(const QUrl &url : failedUrls) {
+                failedFiles->append(url.toLocalFile());
+            }
+            if(--(*remainingEncodings) == 0 && !failedFiles->isEmpty()) {
+                KMessageBox::errorList(this, i18n("The following files could not be converted to ASCII:"), *failedFiles,
+                                       i18n("Conversion Failed"));
+            }
+        });
+    }
+}
+
 KileWidget::StatusBar * Kile::statusBar()
 {
     return static_cast<KileWidget::StatusBar *>(KXmlGuiWindow::statusBar());
@@ -1840,6 +1953,7 @@ void Kile::initMenu()
             << "project_showfiles"
             << "project_buildtree" << "project_options" << "project_findfiles"
             << "project_archive" << "project_close" << "project_openallfiles"
+            << "project_convert_ascii"
             ;
 
     filelist
@@ -2143,12 +2257,12 @@ void Kile::insertTag(const KileAction::TagData& data,const QStringList &pkgs)
 
     KileDocument::TextInfo *docinfo = docManager()->textInfoFor(getCompileName());
     if(docinfo) {
-        QStringList packagelist = allPackages(docinfo);
+        const KileDocument::SymbolScope scope = symbolScope(docinfo);
         QStringList::const_iterator it;
         QStringList warnPkgs;
 
         for ( it = pkgs.begin(); it != pkgs.end(); ++it) {
-            if(!packagelist.contains(*it)) {
+            if(!docManager()->symbolIndex()->contains(KileDocument::SymbolIndex::Packages, *it, scope)) {
                 warnPkgs.append(*it);
             }
         }
@@ -2471,7 +2585,10 @@ void Kile::readRecentFileSettings()
 
 void Kile::readConfig()
 {
-    m_codeCompletionManager->readConfig(m_config.data());
+    // during the start-up the slow parts are done later by 'initializeDeferredSubsystems'
+    if(m_deferredInitializationDone) {
+        m_codeCompletionManager->readConfig(m_config.data());
+    }
 
     if(m_livePreviewManager) {
         m_livePreviewManager->readConfig(m_config.data());
@@ -2480,10 +2597,22 @@ void Kile::readConfig()
     //m_edit->initDoubleQuotes();
     m_edit->readConfig();
     docManager()->updateInfos();
-    m_jScriptManager->readConfig();
+    if(m_deferredInitializationDone) {
+        m_jScriptManager->readConfig();
+    }
     docManager()->readConfig();
     viewManager()->readConfig(m_horizontalSplitter);
 
+    // the dependencies of the project items might be found elsewhere now
+    const QString projectInputPaths = KileConfig::teXPaths() + '\n' + KileConfig::bibInputPaths();
+    if(projectInputPaths != m_projectInputPaths) {
+        m_projectInputPaths = projectInputPaths;
+        const QList<KileProject*> projects = docManager()->projects();
+        for(KileProject *project : projects) {
+            project->buildProjectTree();
+        }
+    }
+
     // set visible views in sidebar
     m_sideBar->setPageVisible(m_scriptsManagementWidget, KileConfig::scriptingEnabled());
     m_sideBar->setPageVisible(m_commandViewToolBox, KileConfig::showCwlCommands());
@@ -2497,8 +2626,10 @@ void Kile::readConfig()
     else {
         disableSymbolViewMFUS();
     }
-    m_commandViewToolBox->readCommandViewFiles();
-    abbreviationManager()->readAbbreviationFiles();
+    if(m_deferredInitializationDone) {
+        m_commandViewToolBox->readCommandViewFiles();
+        abbreviationManager()->readAbbreviationFiles();
+    }
 }
 
 void Kile::saveSettings()
@@ -23,6 +23,7 @@
 #include <QStackedWidget>
 #include <QString>
 #include <QStringList>
+#include <QThreadPool>
 #include <QToolBox>
 #include <QWidget>
 
@@ -212,6 +213,15 @@ private:
 
     KileLyxServer                  *m_lyxserver;
 
+    // the word lists, scripts and abbreviations are only read once the main window has been shown
+    bool                           m_deferredInitializationDone;
+
+    // converts the project files that aren't open to ASCII in the background
+    QThreadPool                    m_conversionThreadPool;
+
+    // the TeX and BibTeX input paths the project trees have been built with
+    QString                        m_projectInputPaths;
+
     /* actions */
     void initSelectActions();
     void setupSideBar();
@@ -308,6 +318,7 @@ private Q_SLOTS:
     void saveSettings();
 
     void readConfig();
+    void initializeDeferredSubsystems();
 
     void generalOptions();
     void configureKeys();
@@ -333,6 +344,7 @@ private Q_SLOTS:
     void showDocInfo(KTextEditor::View *view = Q_NULLPTR);
     void convertToASCII(KTextEditor::Document *doc = Q_NULLPTR);
     void convertToEnc(KTextEditor::Document *doc = Q_NULLPTR);
+    void convertProjectToASCII();
 
     void cleanAll(KileDocument::TextInfo *docinfo = Q_NULLPTR);
     void cleanBib();
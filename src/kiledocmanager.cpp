@@ -44,6 +44,7 @@
 #include <KTextEditor/Editor>
 #include <KTextEditor/View>
 
+#include "codecompletion.h"
 #include "dialogs/cleandialog.h"
 #include "dialogs/listselector.h"
 #include "dialogs/managetemplatesdialog.h"
@@ -129,7 +130,7 @@ void Manager::trashDoc(TextInfo *docinfo, KTextEditor::Document *doc /*= Q_NULLP
     }
 
     KILE_DEBUG_MAIN << "DETACHING " << docinfo;
-    docinfo->detach();
+    detachDocument(docinfo);
 
     KILE_DEBUG_MAIN << "\tTRASHING " <<  doc;
     if(!doc) {
@@ -170,7 +171,7 @@ KTextEditor::Editor* Manager::getEditor()
 
 KTextEditor::Document* Manager::docFor(const QUrl &url)
 {
-    for(QList<TextInfo*>::iterator it = m_textInfoList.begin(); it != m_textInfoList.end(); ++it) {
+    for(QHash<KTextEditor::Document*, TextInfo*>::iterator it = m_textInfoForDocument.begin(); it != m_textInfoForDocument.end(); ++it) {
         TextInfo *info = *it;
 
         if(m_ki->similarOrEqualURL(info->url(), url)) {
@@ -200,7 +201,8 @@ TextInfo* Manager::textInfoFor(const QUrl &url)
 
     KILE_DEBUG_MAIN << "==KileInfo::textInfoFor(" << url << ")==========================";
 
-    for(QList<TextInfo*>::iterator it = m_textInfoList.begin(); it != m_textInfoList.end(); ++it) {
+    // only infos that are open in the editor have a URL
+    for(QHash<KTextEditor::Document*, TextInfo*>::iterator it = m_textInfoForDocument.begin(); it != m_textInfoForDocument.end(); ++it) {
         TextInfo *info = *it;
 
         if (info->url() == url) {
@@ -235,10 +237,9 @@ TextInfo* Manager::textInfoFor(KTextEditor::Document* doc) const
 
     // TextInfo* objects that contain KTextEditor::Document* pointers must be open in the editor, i.e.
     // we don't have to look through the project items
-    for(QList<TextInfo*>::const_iterator it = m_textInfoList.begin(); it != m_textInfoList.end(); ++it) {
-        if((*it)->getDoc() == doc) {
-            return (*it);
-        }
+    TextInfo *info = m_textInfoForDocument.value(doc);
+    if(info) {
+        return info;
     }
 
     KILE_DEBUG_MAIN << "\tCOULD NOT find info for" << doc->url() << "by searching via a KTextEditor::Document*";
@@ -467,7 +468,7 @@ void Manager::recreateTextDocumentInfo(TextInfo *oldinfo)
     QUrl url = oldinfo->url();
     TextInfo *newinfo = createTextDocumentInfo(m_ki->extensions()->determineDocumentType(url), url, oldinfo->getBaseDirectory());
 
-    newinfo->setDoc(oldinfo->getDoc());
+    attachDocument(newinfo, oldinfo->getDoc());
 
     for(QList<KileProjectItem*>::iterator it = list.begin(); it != list.end(); ++it) {
         (*it)->setInfo(newinfo);
@@ -478,6 +479,25 @@ void Manager::recreateTextDocumentInfo(TextInfo *oldinfo)
     emit(updateStructure(false, newinfo));
 }
 
+void Manager::attachDocument(TextInfo *docinfo, KTextEditor::Document *doc)
+{
+    if(docinfo->getDoc() && m_textInfoForDocument.value(docinfo->getDoc()) == docinfo) {
+        m_textInfoForDocument.remove(docinfo->getDoc());
+    }
+    docinfo->setDoc(doc);
+    if(doc) {
+        m_textInfoForDocument.insert(doc, docinfo);
+    }
+}
+
+void Manager::detachDocument(TextInfo *docinfo)
+{
+    if(docinfo->getDoc() && m_textInfoForDocument.value(docinfo->getDoc()) == docinfo) {
+        m_textInfoForDocument.remove(docinfo->getDoc());
+    }
+    docinfo->detach();
+}
+
 bool Manager::removeTextDocumentInfo(TextInfo *docinfo, bool closingproject /* = false */)
 {
     KILE_DEBUG_MAIN << "==Manager::removeTextDocumentInfo(Info *docinfo)=====";
@@ -497,6 +517,10 @@ bool Manager::removeTextDocumentInfo(TextInfo *docinfo, bool closingproject /* =
         }
 
         m_textInfoList.removeAll(docinfo);
+        if(m_textInfoForDocument.value(docinfo->getDoc()) == docinfo) {
+            m_textInfoForDocument.remove(docinfo->getDoc());
+        }
+        m_symbolIndex.remove(docinfo);
 
         emit(closingDocument(docinfo));
 
@@ -541,7 +565,7 @@ KTextEditor::Document* Manager::createDocument(const QUrl &url, TextInfo *docinf
         }
     });
 
-    docinfo->setDoc(doc); // do this here to set up all the signals correctly in 'TextInfo'
+    attachDocument(docinfo, doc); // do this here to set up all the signals correctly in 'TextInfo'
     doc->setEncoding(encoding);
 
     KILE_DEBUG_MAIN << "url is = " << docinfo->url();
@@ -550,7 +574,7 @@ KTextEditor::Document* Manager::createDocument(const QUrl &url, TextInfo *docinf
         bool r = doc->openUrl(url);
         if(!r) {
             KILE_WARNING_MAIN << "couldn't open the url" << url;
-            docinfo->detach();
+            detachDocument(docinfo);
             delete doc;
             return Q_NULLPTR;
         }
@@ -615,7 +639,7 @@ KTextEditor::View* Manager::loadItem(KileDocument::Type type, KileProjectItem *i
         TextInfo *docinfo = item->getInfo();
 
         if(!docFor(item->url())) {
-            docinfo->detach();
+            detachDocument(docinfo);
             KILE_DEBUG_MAIN << "\t\t\tdetached";
         }
     }
@@ -2056,7 +2080,12 @@ void Manager::handleParsingComplete(const QUrl &url, KileParser::ParserOutput* o
         }
     }
     textInfo->installParserOutput(output);
-    m_ki->structureWidget()->updateAfterParsing(textInfo, output->structureViewItems);
+    m_symbolIndex.update(textInfo);
+    if(KileConfig::completePackageLists()) {
+        // the command lists are ready by the time the user starts typing
+        m_ki->codeCompletionManager()->loadPackageLists(textInfo->packages());
+    }
+    m_ki->structureWidget()->updateAfterParsing(textInfo, output->structureViewItems, output->onlyStructurePositionsChanged);
     delete(output);
 }
 
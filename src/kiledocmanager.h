@@ -16,6 +16,7 @@
 #define KILEDOCUMENTKILEDOCMANAGER_H
 
 #include <QDropEvent>
+#include <QHash>
 #include <QObject>
 #include <QPointer>
 #include <QStringList>
@@ -25,6 +26,7 @@
 
 #include "kileconstants.h"
 #include "kileproject.h"
+#include "symbolindex.h"
 #include "widgets/progressdialog.h"
 
 class QUrl;
@@ -216,6 +218,10 @@ public:
 
     QUrl urlFor(TextInfo* textInfo);
 
+    SymbolIndex* symbolIndex() {
+        return &m_symbolIndex;
+    }
+
     void updateInfos();
 
     KileProject* projectForMember(const QUrl &memberUrl);
@@ -280,12 +286,18 @@ protected:
 private:
     KTextEditor::Editor			*m_editor;
     QList<TextInfo*>			m_textInfoList;
+    // the infos that are associated with a document that is open in the editor
+    QHash<KTextEditor::Document*, TextInfo*>	m_textInfoForDocument;
+    SymbolIndex				m_symbolIndex;
     KileInfo				*m_ki;
     QList<KileProject*>			m_projects;
     QPointer<KileWidget::ProgressDialog>	m_progressDialog;
     unsigned int				m_autoSaveLock;
     bool					m_currentlySavingAll, m_currentlyOpeningFile;
 
+    void attachDocument(TextInfo *docinfo, KTextEditor::Document *doc);
+    void detachDocument(TextInfo *docinfo);
+
     void dontOpenWarning(KileProjectItem *item, const QString &action, const QString &filetype);
     void cleanupDocumentInfoForProjectItems(KileDocument::Info *info);
 
@@ -248,88 +248,72 @@ QList<QUrl> KileInfo::getParentsFor(KileDocument::Info *info)
     return list;
 }
 
-QStringList KileInfo::retrieveList(QStringList (KileDocument::Info::*getit)() const, KileDocument::TextInfo *docinfo)
+KileDocument::SymbolScope KileInfo::symbolScope(KileDocument::TextInfo *docinfo)
 {
     if(!docinfo) {
         docinfo = docManager()->getInfo();
     }
     KileProjectItem *item = docManager()->itemFor(docinfo, docManager()->activeProject());
 
-    KILE_DEBUG_MAIN << "Kile::retrieveList()";
     if (item) {
         KileProject *project = item->project();
         KileProjectItem *root = project->rootItem(item);
         if (root) {
             KILE_DEBUG_MAIN << "\tusing root item " << root->url().fileName();
-
-            QList<KileProjectItem*> children;
-            children.append(root);
-            root->allChildren(&children);
-
-            QStringList toReturn;
-            for(QList<KileProjectItem*>::iterator it = children.begin(); it != children.end(); ++it) {
-                const KileProjectItem *item = *it;
-                KileDocument::TextInfo *textInfo = item->getInfo();
-                KILE_DEBUG_MAIN << "\t" << item->url();
-
-                if(textInfo) {
-                    toReturn << (textInfo->*getit)();
-                }
-            }
-            return toReturn;
-        }
-        else {
-            return QStringList();
+            return project->symbolScope(root);
         }
     }
     else if (docinfo) {
-        return (docinfo->*getit)();
-    }
-    else {
-        return QStringList();
+        return KileDocument::SymbolScope(QList<KileDocument::TextInfo*>() << docinfo);
     }
+    return KileDocument::SymbolScope();
+}
+
+bool KileInfo::isSymbolDefined(KileDocument::SymbolIndex::SymbolType type, const QString& symbol, KileDocument::TextInfo *info)
+{
+    return docManager()->symbolIndex()->contains(type, symbol, symbolScope(info));
 }
 
 QStringList KileInfo::allLabels(KileDocument::TextInfo *info)
 {
     KILE_DEBUG_MAIN << "Kile::allLabels()" << endl;
-    return retrieveList(&KileDocument::Info::labels, info);
+    return docManager()->symbolIndex()->symbols(KileDocument::SymbolIndex::Labels, symbolScope(info));
 }
 
 QStringList KileInfo::allBibItems(KileDocument::TextInfo *info)
 {
     KILE_DEBUG_MAIN << "Kile::allBibItems()" << endl;
-    return retrieveList(&KileDocument::Info::bibItems, info);
+    return docManager()->symbolIndex()->symbols(KileDocument::SymbolIndex::BibItems, symbolScope(info));
 }
 
 QStringList KileInfo::allBibliographies(KileDocument::TextInfo *info)
 {
     KILE_DEBUG_MAIN << "Kile::bibliographies()" << endl;
-    return retrieveList(&KileDocument::Info::bibliographies, info);
+    return docManager()->symbolIndex()->symbols(KileDocument::SymbolIndex::Bibliographies, symbolScope(info));
 }
 
 QStringList KileInfo::allDependencies(KileDocument::TextInfo *info)
 {
     KILE_DEBUG_MAIN << "Kile::dependencies()" << endl;
-    return retrieveList(&KileDocument::Info::dependencies, info);
+    return docManager()->symbolIndex()->symbols(KileDocument::SymbolIndex::Dependencies, symbolScope(info));
 }
 
 QStringList KileInfo::allNewCommands(KileDocument::TextInfo *info)
 {
     KILE_DEBUG_MAIN << "Kile::newCommands()" << endl;
-    return retrieveList(&KileDocument::Info::newCommands, info);
+    return docManager()->symbolIndex()->symbols(KileDocument::SymbolIndex::NewCommands, symbolScope(info));
 }
 
 QStringList KileInfo::allAsyFigures(KileDocument::TextInfo *info)
 {
     KILE_DEBUG_MAIN << "Kile::asyFigures()" << endl;
-    return retrieveList(&KileDocument::Info::asyFigures, info);
+    return docManager()->symbolIndex()->symbols(KileDocument::SymbolIndex::AsyFigures, symbolScope(info));
 }
 
 QStringList KileInfo::allPackages(KileDocument::TextInfo *info)
 {
     KILE_DEBUG_MAIN << "Kile::allPackages()" << endl;
-    return retrieveList(&KileDocument::Info::packages, info);
+    return docManager()->symbolIndex()->symbols(KileDocument::SymbolIndex::Packages, symbolScope(info));
 }
 
 QString KileInfo::lastModifiedFile(KileDocument::TextInfo* info)
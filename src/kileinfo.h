@@ -31,6 +31,7 @@
 #include "outputinfo.h"
 #include "latexcmd.h"
 #include "kileconfig.h"
+#include "symbolindex.h"
 
 class QWidget;
 
@@ -144,6 +145,14 @@ public:
     virtual QStringList allAsyFigures(KileDocument::TextInfo *info = Q_NULLPTR);
     virtual QStringList allPackages(KileDocument::TextInfo *info = Q_NULLPTR);
 
+    /**
+     * Returns the documents whose symbols are visible in 'info', i.e. all the documents of the
+     * project tree that 'info' belongs to, or only 'info' if it isn't part of the active project.
+     * If 'info' is Q_NULLPTR, the current document is used.
+     **/
+    KileDocument::SymbolScope symbolScope(KileDocument::TextInfo *info = Q_NULLPTR);
+    bool isSymbolDefined(KileDocument::SymbolIndex::SymbolType type, const QString& symbol, KileDocument::TextInfo *info = Q_NULLPTR);
+
     QString lastModifiedFile(KileDocument::TextInfo *info = Q_NULLPTR);
 
     static QString documentTypeToString(KileDocument::Type type);
@@ -154,9 +163,6 @@ public:
     virtual void focusEditor() = 0;
     virtual void focusPreview() = 0;
 
-private:
-    QStringList retrieveList(QStringList (KileDocument::Info::*getit)() const, KileDocument::TextInfo *docinfo = Q_NULLPTR);
-
 public:
     bool similarOrEqualURL(const QUrl &validurl, const QUrl &testurl);
     bool isOpen(const QUrl &url);
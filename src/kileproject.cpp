@@ -217,11 +217,15 @@ void KileProjectItem::allChildren(QList<KileProjectItem*> *list) const
 
 void KileProjectItem::setInfo(KileDocument::TextInfo *docinfo)
 {
+    KileDocument::TextInfo *previousInfo = m_docinfo;
     m_docinfo = docinfo;
+    if(m_project) {
+        m_project->itemInfoChanged(this, previousInfo);
+    }
     if(docinfo)
     {
         connect(docinfo,SIGNAL(urlChanged(KileDocument::Info*,QUrl)), this, SLOT(slotChangeURL(KileDocument::Info*,QUrl)));
-        connect(docinfo,SIGNAL(depChanged()), m_project, SLOT(buildProjectTree()));
+        connect(docinfo,SIGNAL(depChanged()), m_project, SLOT(updateProjectTree()));
     }
 }
 
@@ -674,12 +678,16 @@ void KileProject::buildProjectTree()
 {
     KILE_DEBUG_MAIN << "==KileProject::buildProjectTree==========================";
 
-    //determine the parent doc for each item (TODO:an item can only have one parent, not necessarily true for LaTeX docs)
+    // files might have been created or deleted in the meantime
+    m_resolvedPaths.clear();
+    m_itemDependencies.clear();
 
-    QStringList deps;
-    QString dep;
-    KileProjectItem *itm;
-    QUrl url;
+    updateProjectTree();
+}
+
+void KileProject::updateProjectTree()
+{
+    //determine the parent doc for each item (TODO:an item can only have one parent, not necessarily true for LaTeX docs)
 
     //clean first
     for(QList<KileProjectItem*>::iterator it = m_projectItems.begin(); it != m_projectItems.end(); ++it) {
@@ -690,37 +698,20 @@ void KileProject::buildProjectTree()
     for(QList<KileProjectItem*>::iterator it = m_projectItems.begin(); it != m_projectItems.end(); ++it) {
         //set the type correctly (changing m_extensions causes a call to buildProjectTree)
         setType(*it);
-        KileDocument::Info *docinfo = (*it)->getInfo();
 
-        if(docinfo) {
-            QUrl parentUrl = docinfo->url();
-            if(parentUrl.isLocalFile()) {
-                // strip the file name from 'parentUrl'
-                parentUrl = QUrl::fromUserInput(QFileInfo(parentUrl.path()).path());
-            }
-            else {
-                parentUrl = m_baseurl;
-            }
-            deps = docinfo->dependencies();
-            for(int i = 0; i < deps.count(); ++i) {
-                dep = deps[i];
-
-                if(m_extmanager->isTexFile(dep)) {
-                    url = QUrl::fromLocalFile(KileInfo::checkOtherPaths(parentUrl, dep, KileInfo::texinputs));
-                }
-                else if(m_extmanager->isBibFile(dep)) {
-                    url = QUrl::fromLocalFile(KileInfo::checkOtherPaths(parentUrl, dep, KileInfo::bibinputs));
-                }
-                itm = item(url);
-                if(itm && (itm->parent() == 0)
-                        && !isAncestorOf(itm, *it)) { // avoid circular references if a file should
-                    // include itself in a circular way
-                    itm->setParent(*it);
-                }
+        const QList<QUrl> &urls = dependencyUrls(*it);
+        for(QList<QUrl>::const_iterator urlIt = urls.begin(); urlIt != urls.end(); ++urlIt) {
+            KileProjectItem *itm = item(*urlIt);
+            if(itm && (itm->parent() == 0)
+                    && !isAncestorOf(itm, *it)) { // avoid circular references if a file should
+                // include itself in a circular way
+                itm->setParent(*it);
             }
         }
     }
 
+    m_symbolScopes.clear();
+
     //make a list of all the root items (items with parent == 0)
     m_rootItems.clear();
     for(QList<KileProjectItem*>::iterator it = m_projectItems.begin(); it != m_projectItems.end(); ++it) {
@@ -732,28 +723,78 @@ void KileProject::buildProjectTree()
     emit(projectTreeChanged(this));
 }
 
-KileProjectItem* KileProject::item(const QUrl &url)
+const QList<QUrl>& KileProject::dependencyUrls(KileProjectItem *item)
 {
-    for(QList<KileProjectItem*>::iterator it = m_projectItems.begin(); it != m_projectItems.end(); ++it) {
-        if((*it)->url() == url) {
-            return *it;
+    KileDocument::Info *docinfo = item->getInfo();
+    QUrl baseUrl = m_baseurl;
+    QStringList deps;
+    if(docinfo) {
+        const QUrl url = docinfo->url();
+        if(url.isLocalFile()) {
+            // strip the file name from 'url'
+            baseUrl = QUrl::fromUserInput(QFileInfo(url.path()).path());
+        }
+        deps = docinfo->dependencies();
+    }
+
+    QHash<KileProjectItem*, ItemDependencies>::iterator cached = m_itemDependencies.find(item);
+    // dependencies that couldn't be found are looked up again, as the files might have been created since
+    if(cached != m_itemDependencies.end() && cached->allResolved
+            && cached->baseUrl == baseUrl && cached->dependencies == deps) {
+        return cached->urls;
+    }
+
+    ItemDependencies &itemDependencies = m_itemDependencies[item];
+    itemDependencies.baseUrl = baseUrl;
+    itemDependencies.dependencies = deps;
+    itemDependencies.urls.clear();
+    itemDependencies.allResolved = true;
+    for(QStringList::const_iterator it = deps.constBegin(); it != deps.constEnd(); ++it) {
+        const QString &dep = *it;
+        QString path;
+        if(m_extmanager->isTexFile(dep)) {
+            path = resolveDependency(baseUrl, dep, KileInfo::texinputs);
+        }
+        else if(m_extmanager->isBibFile(dep)) {
+            path = resolveDependency(baseUrl, dep, KileInfo::bibinputs);
+        }
+        else {
+            continue;
+        }
+        if(path.isEmpty()) {
+            itemDependencies.allResolved = false;
         }
+        itemDependencies.urls.append(QUrl::fromLocalFile(path));
     }
+    return itemDependencies.urls;
+}
 
-    return Q_NULLPTR;
+QString KileProject::resolveDependency(const QUrl &baseUrl, const QString &dependency, int type)
+{
+    const QString key = QString::number(type) + '\n' + baseUrl.toLocalFile() + '\n' + dependency;
+    QHash<QString, QString>::const_iterator it = m_resolvedPaths.constFind(key);
+    if(it != m_resolvedPaths.constEnd()) {
+        return *it;
+    }
+    const QString path = KileInfo::checkOtherPaths(baseUrl, dependency, type);
+    // failed lookups aren't cached
+    if(!path.isEmpty()) {
+        m_resolvedPaths.insert(key, path);
+    }
+    return path;
 }
 
-KileProjectItem* KileProject::item(const KileDocument::Info *info)
+KileProjectItem* KileProject::item(const QUrl &url)
 {
-    for(QList<KileProjectItem*>::iterator it = m_projectItems.begin(); it != m_projectItems.end(); ++it) {
-        KileProjectItem *current = *it;
+    return m_itemsByUrl.value(url);
+}
 
-        if (current->getInfo() == info) {
-            return current;
-        }
+KileProjectItem* KileProject::item(const KileDocument::Info *info)
+{
+    if(!info) {
+        return Q_NULLPTR;
     }
-
-    return Q_NULLPTR;
+    return m_itemsByInfo.value(info);
 }
 
 void KileProject::add(KileProjectItem* item)
@@ -766,6 +807,11 @@ void KileProject::add(KileProjectItem* item)
     connect(item, SIGNAL(urlChanged(KileProjectItem*)), this, SLOT(itemRenamed(KileProjectItem*)) );
 
     m_projectItems.append(item);
+    m_symbolScopes.clear();
+    m_itemsByUrl.insert(item->url(), item);
+    if(item->getInfo()) {
+        m_itemsByInfo.insert(item->getInfo(), item);
+    }
 
     emit projectItemAdded(this, item);
 
@@ -777,6 +823,14 @@ void KileProject::remove(KileProjectItem* item)
     KILE_DEBUG_MAIN << item->path();
     removeConfigGroupsForItem(item);
     m_projectItems.removeAll(item);
+    m_itemDependencies.remove(item);
+    m_symbolScopes.clear();
+    if(m_itemsByUrl.value(item->url()) == item) {
+        m_itemsByUrl.remove(item->url());
+    }
+    if(item->getInfo() && m_itemsByInfo.value(item->getInfo()) == item) {
+        m_itemsByInfo.remove(item->getInfo());
+    }
 
     emit projectItemRemoved(this, item);
 
@@ -789,9 +843,31 @@ void KileProject::itemRenamed(KileProjectItem *item)
     KILE_DEBUG_MAIN << "\t" << item->url().fileName();
     removeConfigGroupsForItem(item);
 
+    // the item is still indexed under its previous URL
+    for(QHash<QUrl, KileProjectItem*>::iterator it = m_itemsByUrl.begin(); it != m_itemsByUrl.end();) {
+        if(*it == item) {
+            it = m_itemsByUrl.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    m_itemsByUrl.insert(item->url(), item);
+
     item->changePath(findRelativePath(item->url()));
 }
 
+void KileProject::itemInfoChanged(KileProjectItem *item, const KileDocument::Info *previousInfo)
+{
+    m_symbolScopes.clear();
+    if(previousInfo && m_itemsByInfo.value(previousInfo) == item) {
+        m_itemsByInfo.remove(previousInfo);
+    }
+    if(item->getInfo()) {
+        m_itemsByInfo.insert(item->getInfo(), item);
+    }
+}
+
 QString KileProject::findRelativePath(const QString &path)
 {
     return this->findRelativePath(QUrl::fromLocalFile(path));
@@ -811,23 +887,33 @@ QString KileProject::findRelativePath(const QUrl &url)
 
 bool KileProject::contains(const QUrl &url)
 {
-    for(QList<KileProjectItem*>::iterator it = m_projectItems.begin(); it != m_projectItems.end(); ++it) {
-        if((*it)->url() == url) {
-            return true;
-        }
-    }
-
-    return false;
+    return m_itemsByUrl.contains(url);
 }
 
 bool KileProject::contains(const KileDocument::Info *info)
 {
-    for(QList<KileProjectItem*>::iterator it = m_projectItems.begin(); it != m_projectItems.end(); ++it) {
-        if((*it)->getInfo() == info) {
-            return true;
+    return info && m_itemsByInfo.contains(info);
+}
+
+const KileDocument::SymbolScope& KileProject::symbolScope(KileProjectItem *root)
+{
+    QHash<KileProjectItem*, KileDocument::SymbolScope>::const_iterator it = m_symbolScopes.constFind(root);
+    if(it != m_symbolScopes.constEnd()) {
+        return *it;
+    }
+
+    QList<KileProjectItem*> children;
+    children.append(root);
+    root->allChildren(&children);
+
+    QList<KileDocument::TextInfo*> documents;
+    for(QList<KileProjectItem*>::iterator childIt = children.begin(); childIt != children.end(); ++childIt) {
+        KileDocument::TextInfo *textInfo = (*childIt)->getInfo();
+        if(textInfo) {
+            documents.append(textInfo);
         }
     }
-    return false;
+    return *m_symbolScopes.insert(root, KileDocument::SymbolScope(documents));
 }
 
 KileProjectItem *KileProject::rootItem(KileProjectItem *item) const
@@ -17,6 +17,7 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QList>
 #include <QObject>
 #include <QRegExp>
@@ -29,6 +30,7 @@
 #include "kileversion.h"
 #include "livepreview_utils.h"
 #include "outputinfo.h"
+#include "symbolindex.h"
 
 class QString;
 class QStringList;
@@ -283,6 +285,11 @@ public:
     bool contains(const QUrl&);
     bool contains(const KileDocument::Info *info);
     KileProjectItem *rootItem(KileProjectItem *) const;
+    /**
+     * Returns the documents of the tree below 'root' (including 'root'), which is only
+     * determined again when the project tree or the documents of the items change.
+     **/
+    const KileDocument::SymbolScope& symbolScope(KileProjectItem *root);
     const QList<KileProjectItem*>& rootItems() const {
         return m_rootItems;
     }
@@ -352,6 +359,11 @@ public Q_SLOTS:
     void itemRenamed(KileProjectItem*);
 
     void buildProjectTree(); // moved to slots by tbraun
+    /**
+     * Like 'buildProjectTree', but only the dependencies of those items whose list of
+     * dependencies has changed are resolved again.
+     **/
+    void updateProjectTree();
 
     //debugging
     void dump();
@@ -382,6 +394,12 @@ private:
 
     void removeConfigGroupsForItem(KileProjectItem *item);
 
+    // called by 'KileProjectItem::setInfo'
+    void itemInfoChanged(KileProjectItem *item, const KileDocument::Info *previousInfo);
+
+    const QList<QUrl>& dependencyUrls(KileProjectItem *item);
+    QString resolveDependency(const QUrl &baseUrl, const QString &dependency, int type);
+
 private:
 
     QString		m_name, m_quickBuildConfig, m_defGraphicExt;
@@ -389,6 +407,26 @@ private:
     bool		m_invalid;
     QList<KileProjectItem*> m_rootItems;
     QList<KileProjectItem*>	m_projectItems;
+    // the items are looked up very often, which is why they are also indexed by their URLs and their infos
+    QHash<QUrl, KileProjectItem*> m_itemsByUrl;
+    QHash<const KileDocument::Info*, KileProjectItem*> m_itemsByInfo;
+
+    // the resolved dependencies of an item remain valid as long as its list of dependencies
+    // and the directory they are relative to don't change, and all of them have been found
+    struct ItemDependencies {
+        ItemDependencies() : allResolved(false) {}
+
+        QUrl baseUrl;
+        QStringList dependencies;
+        QList<QUrl> urls;
+        bool allResolved;
+    };
+    QHash<KileProjectItem*, ItemDependencies> m_itemDependencies;
+    // the documents of the trees below the root items that have been looked up
+    QHash<KileProjectItem*, KileDocument::SymbolScope> m_symbolScopes;
+    // maps the input paths to the files they have been found at (failed lookups are not stored);
+    // cleared by 'buildProjectTree', e.g. when the configured input paths change
+    QHash<QString, QString> m_resolvedPaths;
 
     QString		m_extensions[4];
     QRegExp		m_reExtensions[4];
@@ -15,8 +15,14 @@
 
 #include "kilestdtools.h"
 
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QRegExp>
+#include <QSet>
+#include <QSharedPointer>
 
 #include <QAction>
 #include <KActionCollection>
@@ -24,6 +30,7 @@
 #include <KLocalizedString>
 
 #include <KProcess>
+#include <KShell>
 
 #include "dialogs/listselector.h"
 #include "kileconfig.h"
@@ -32,6 +39,7 @@
 #include "kiletool_enums.h"
 #include "kileinfo.h"
 #include "kiledocmanager.h"
+#include "kileproject.h"
 #include "documentinfo.h"
 #include "outputinfo.h"
 #include "parser/parsermanager.h"
@@ -234,25 +242,158 @@ bool LaTeX::determineSource()
 
 int LaTeX::m_reRun = 0;
 
+namespace {
+
+// the hashes of the inputs of the auxiliary tools for documents that don't belong to a project
+QHash<QString, QByteArray> inputHashesOutsideProjects;
+
+const char *inputHashGroup = "ToolInputHashes";
+
+void writeInputHash(KileProject *project, bool partOfLivePreview, const QString& target, const QString& key, const QByteArray& hash)
+{
+    // the hashes for the temporary files of the live preview aren't kept in the project
+    if(!project || !project->guiConfig() || partOfLivePreview) {
+        inputHashesOutsideProjects.insert(target + ':' + key, hash);
+        return;
+    }
+    const QString entry = QDir(project->baseURL().toLocalFile()).relativeFilePath(target) + ':' + key;
+    KConfigGroup group = project->guiConfig()->group(inputHashGroup);
+    if(QByteArray::fromHex(group.readEntry(entry, QByteArray())) != hash) {
+        group.writeEntry(entry, hash.toHex());
+    }
+}
+
+void addFileContents(const QString& fileName, QCryptographicHash& hash)
+{
+    // a file that appears or disappears changes the hash as well
+    hash.addData(fileName.toUtf8());
+    QFile file(fileName);
+    if(file.open(QIODevice::ReadOnly)) {
+        hash.addData(&file);
+    }
+    else {
+        static const char missing[] = "\0missing";
+        hash.addData(missing, sizeof(missing) - 1);
+    }
+}
+
+// adds the lines of an .aux file that are read by BibTeX, including the ones
+// of the .aux files it includes, to 'hash'; returns true if a \bibdata line was found
+bool addBibTeXAuxLines(const QString& auxFile, QCryptographicHash& hash, int depth = 0)
+{
+    QFile file(auxFile);
+    if(depth > 16 || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    bool bibDataFound = false;
+    while(!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if(line.startsWith("\\citation") || line.startsWith("\\bibstyle")) {
+            hash.addData(line);
+        }
+        else if(line.startsWith("\\bibdata")) {
+            hash.addData(line);
+            bibDataFound = true;
+        }
+        else if(line.startsWith("\\@input{")) {
+            const int end = line.indexOf('}');
+            if(end > 8) {
+                const QString includedFile = QFileInfo(auxFile).absoluteDir().filePath(QString::fromLocal8Bit(line.mid(8, end - 8)));
+                bibDataFound = addBibTeXAuxLines(includedFile, hash, depth + 1) || bibDataFound;
+            }
+        }
+    }
+    return bibDataFound;
+}
+
+}
+
+QByteArray LaTeX::storedInputHash(KileDocument::TextInfo *docinfo, const QString& key)
+{
+    const QString target = QFileInfo(targetDir() + '/' + S()).absoluteFilePath();
+    KileProject *project = manager()->info()->docManager()->projectForMember(docinfo->url());
+    if(!project || !project->guiConfig() || isPartOfLivePreview()) {
+        return inputHashesOutsideProjects.value(target + ':' + key);
+    }
+    const QString entry = QDir(project->baseURL().toLocalFile()).relativeFilePath(target) + ':' + key;
+    return QByteArray::fromHex(project->guiConfig()->group(inputHashGroup).readEntry(entry, QByteArray()));
+}
+
+void LaTeX::storeInputHash(KileDocument::TextInfo *docinfo, const QString& key, const QByteArray& hash)
+{
+    const QString target = QFileInfo(targetDir() + '/' + S()).absoluteFilePath();
+    KileProject *project = manager()->info()->docManager()->projectForMember(docinfo->url());
+    writeInputHash(project, isPartOfLivePreview(), target, key, hash);
+}
+
+void LaTeX::storeInputHashWhenDone(const QList<KileTool::Base*>& tools, KileDocument::TextInfo *docinfo, const QString& key)
+{
+    if(!m_pendingInputHashes.contains(key) || tools.isEmpty()) {
+        return;
+    }
+    // this tool might already be gone when the auxiliary tools have finished
+    KileTool::Manager *toolManager = manager();
+    const QUrl url = docinfo->url();
+    const bool partOfLivePreview = isPartOfLivePreview();
+    const QString target = QFileInfo(targetDir() + '/' + S()).absoluteFilePath();
+    const QByteArray hash = m_pendingInputHashes.take(key);
+    QSharedPointer<int> remainingTools(new int(tools.size()));
+    for(KileTool::Base *tool : tools) {
+        connect(tool, &KileTool::Base::done, toolManager, [=](KileTool::Base*, int result, bool) {
+            if(result == Success && --(*remainingTools) == 0) {
+                KileProject *project = toolManager->info()->docManager()->projectForMember(url);
+                writeInputHash(project, partOfLivePreview, target, key, hash);
+            }
+        });
+    }
+}
+
 // FIXME don't hardcode bbl and ind suffix here.
 bool LaTeX::updateBibs(bool checkOnlyBibDependencies)
 {
     KileDocument::TextInfo *docinfo = manager()->info()->docManager()->textInfoFor(source());
     if(docinfo) {
         QFileInfo fileinfo(docinfo->url().toLocalFile());
-        QStringList dependencies;
+        const QStringList bibliographies = manager()->info()->allBibliographies(docinfo);
+
+        // BibTeX reads the citations and the database names from the .aux files, Biber reads
+        // the .bcf file; both read the bibliography files
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        const bool bibDataFound = addBibTeXAuxLines(targetDir() + '/' + S() + ".aux", hash);
+        const QString bcfFile = targetDir() + '/' + S() + ".bcf";
+        if(!bibDataFound && bibliographies.isEmpty() && !QFileInfo::exists(bcfFile)) {
+            return false;
+        }
+        addFileContents(bcfFile, hash);
+        const QDir basePath(fileinfo.absolutePath());
+        for(const QString& bibliography : bibliographies) {
+            addFileContents(basePath.absoluteFilePath(bibliography), hash);
+        }
 
+        const QByteArray previousHash = storedInputHash(docinfo, "bib");
+        // the new hash is only stored once the bibliography tool has been run successfully
+        m_pendingInputHashes.insert("bib", hash.result());
+        const QString bblFile = targetDir() + '/' + S() + ".bbl";
+        if(!QFileInfo::exists(bblFile)) {
+            return true;
+        }
+        if(!previousHash.isEmpty()) {
+            return (previousHash != hash.result());
+        }
+
+        QStringList dependencies;
         if (checkOnlyBibDependencies) {
-            dependencies = manager()->info()->allBibliographies(docinfo);
+            dependencies = bibliographies;
         }
         else {
             dependencies = manager()->info()->allDependencies(docinfo);
             dependencies.append(fileinfo.fileName());
         }
-        if (!dependencies.empty()) {
-            return needsUpdate(targetDir() + '/' + S() + ".bbl",
-                               KileUtilities::lastModifiedFile(dependencies, fileinfo.absolutePath()));
+        if (!dependencies.empty() && needsUpdate(bblFile, KileUtilities::lastModifiedFile(dependencies, fileinfo.absolutePath()))) {
+            return true;
         }
+        // the .bbl file is up to date
+        storeInputHash(docinfo, "bib", m_pendingInputHashes.take("bib"));
     }
 
     return false;
@@ -262,9 +403,34 @@ bool LaTeX::updateIndex()
 {
     KileDocument::TextInfo *docinfo = manager()->info()->docManager()->textInfoFor(source());
     if(docinfo) {
-        QStringList pckgs = manager()->info()->allPackages(docinfo);
-        if(pckgs.contains("makeidx") || pckgs.contains("imakeidx") || pckgs.contains("splitidx")) {
-            return needsUpdate(targetDir() + '/' + S() + ".ind", manager()->info()->lastModifiedFile(docinfo));
+        const KileDocument::SymbolScope scope = manager()->info()->symbolScope(docinfo);
+        const KileDocument::SymbolIndex *symbolIndex = manager()->info()->docManager()->symbolIndex();
+        if(symbolIndex->contains(KileDocument::SymbolIndex::Packages, "makeidx", scope)
+                || symbolIndex->contains(KileDocument::SymbolIndex::Packages, "imakeidx", scope)
+                || symbolIndex->contains(KileDocument::SymbolIndex::Packages, "splitidx", scope)) {
+            // MakeIndex only reads the .idx file
+            const QString idxFile = targetDir() + '/' + S() + ".idx";
+            if(!QFileInfo::exists(idxFile)) {
+                return false;
+            }
+            QCryptographicHash hash(QCryptographicHash::Sha1);
+            addFileContents(idxFile, hash);
+
+            const QByteArray previousHash = storedInputHash(docinfo, "idx");
+            // the new hash is only stored once MakeIndex has been run successfully
+            m_pendingInputHashes.insert("idx", hash.result());
+            const QString indFile = targetDir() + '/' + S() + ".ind";
+            if(!QFileInfo::exists(indFile)) {
+                return true;
+            }
+            if(!previousHash.isEmpty()) {
+                return (previousHash != hash.result());
+            }
+            if(needsUpdate(indFile, manager()->info()->lastModifiedFile(docinfo))) {
+                return true;
+            }
+            // the .ind file is up to date
+            storeInputHash(docinfo, "idx", m_pendingInputHashes.take("idx"));
         }
     }
 
@@ -275,11 +441,40 @@ bool LaTeX::updateAsy()
 {
     KileDocument::TextInfo *docinfo = manager()->info()->docManager()->textInfoFor(source());
     if(docinfo) {
-        QStringList pckgs = manager()->info()->allPackages(docinfo);
-        // As asymptote doesn't properly notify the user when it needs to be rerun, we run
-        // it every time LaTeX is run (but only for m_reRun == 0 if LaTeX has to be rerun).
-        if(pckgs.contains("asymptote")) {
-            return true;
+        if(manager()->info()->isSymbolDefined(KileDocument::SymbolIndex::Packages, "asymptote", docinfo)) {
+            // LaTeX writes the figures into the files '<source>-<n>.asy'; as asymptote doesn't
+            // notify the user when it needs to be rerun, it is run whenever one of them has changed
+            // (but only for m_reRun == 0 if LaTeX has to be rerun)
+            QCryptographicHash hash(QCryptographicHash::Sha1);
+            const int figureCount = manager()->info()->allAsyFigures(docinfo).size();
+            for(int i = 1; i <= figureCount; ++i) {
+                addFileContents(targetDir() + '/' + S() + '-' + QString::number(i) + ".asy", hash);
+            }
+
+            const QByteArray previousHash = storedInputHash(docinfo, "asy");
+            // the new hash is only stored once Asymptote has been run successfully
+            m_pendingInputHashes.insert("asy", hash.result());
+            if(previousHash.isEmpty() || previousHash != hash.result()) {
+                return true;
+            }
+
+            // Asymptote also has to be run if one of the figures hasn't been generated; depending on
+            // the LaTeX engine, a figure '<source>-<n>.asy' is compiled into a .pdf or an .eps file
+            const QStringList generatedFiles = QDir(targetDir()).entryList(QStringList() << S() + "-*", QDir::Files);
+            QSet<QString> generatedFigures;
+            for(const QString& fileName : generatedFiles) {
+                const QFileInfo fileInfo(fileName);
+                if(fileInfo.suffix() != QLatin1String("asy")) {
+                    generatedFigures.insert(fileInfo.completeBaseName());
+                }
+            }
+            for(int i = 1; i <= figureCount; ++i) {
+                if(!generatedFigures.contains(S() + '-' + QString::number(i))) {
+                    return true;
+                }
+            }
+            // the figures are up to date
+            storeInputHash(docinfo, "asy", m_pendingInputHashes.take("asy"));
         }
     }
     return false;
@@ -303,6 +498,33 @@ bool LaTeX::finish(int r)
     return true;
 }
 
+void LaTeX::prepareToRun()
+{
+    Compile::prepareToRun();
+    if(!isPrepared() || m_precompiledFormat.isEmpty()) {
+        return;
+    }
+    ProcessLauncher *processLauncher = dynamic_cast<ProcessLauncher*>(launcher());
+    if(processLauncher) {
+        processLauncher->setOptions("-fmt=" + KShell::quoteArg(m_precompiledFormat) + ' ' + readEntry("options"));
+    }
+}
+
+int LaTeX::run()
+{
+    const int result = Compile::run();
+    if(result == Running && followsLogFile()) {
+        const QString log = targetDir() + '/' + S() + ".log";
+        manager()->parserManager()->followOutput(this, log, source());
+    }
+    return result;
+}
+
+bool LaTeX::followsLogFile() const
+{
+    return KileConfig::followLaTeXLog() && !isPartOfLivePreview();
+}
+
 void LaTeX::latexOutputParserResultInstalled()
 {
     KILE_DEBUG_MAIN;
@@ -341,6 +563,10 @@ void LaTeX::checqCriticals()
 void LaTeX::configureLaTeX(KileTool::Base *tool, const QString& source)
 {
     tool->setSource(source, workingDir());
+    LaTeX *latex = dynamic_cast<LaTeX*>(tool);
+    if(latex) {
+        latex->setPrecompiledFormat(m_precompiledFormat);
+    }
 }
 
 void LaTeX::configureBibTeX(KileTool::Base *tool, const QString& source)
@@ -471,19 +697,22 @@ void LaTeX::checkAutoRun()
         }
     }
 
+    m_pendingInputHashes.clear();
     bool asy = (m_reRun == 0) && updateAsy();
     // We run bibtool in the following cases:
     // 1. Biblatex said that we have to (in this case bibToolInLaTexOutput is not empty), OR
-    // 2. There are no undefined citations and at least one of the .bib files has a younger modification
-    //    date than the .bbl file, OR
-    // 3. We have undefined citations and at least one of the source files (including .bib and .tex) is
-    //    younger than .bbl.
+    // 2. The citations or databases listed in the .aux files, the .bcf file or one of the .bib files
+    //    have changed since the bibliography tool was run last, OR
+    // 3. This isn't known yet, and there are no undefined citations and at least one of the .bib files
+    //    has a younger modification date than the .bbl file, OR
+    // 4. This isn't known yet, and we have undefined citations and at least one of the source files
+    //    (including .bib and .tex) is younger than .bbl.
     //    (If the .bbl file is younger than all of them, the next rerun will not change anything)
-    bool bibs = !bibToolInLaTexOutput.isEmpty() || updateBibs(!haveUndefinedCitations);
+    // (updateBibs is always called such that the hashes of the inputs are kept up to date)
+    bool bibs = updateBibs(!haveUndefinedCitations) || !bibToolInLaTexOutput.isEmpty();
     bool index = updateIndex();
     KILE_DEBUG_MAIN << "asy:" << asy << "bibs:" << bibs << "index:" << index << "reRunWarningFound:" << reRunWarningFound;
-    // Currently, we don't properly detect yet whether asymptote has to be run.
-    // So, if asymtote figures are present, we run it each time after the first LaTeX run.
+    // Asymptote is run after the first LaTeX run if one of the figures has changed.
     bool reRun = (asy || bibs || index || reRunWarningFound);
     KILE_DEBUG_MAIN << "reRun:" << reRun;
 
@@ -502,6 +731,9 @@ void LaTeX::checkAutoRun()
         m_reRun = 0;
     }
 
+    // the bibliography tool, MakeIndex and Asymptote don't depend on each other; they are run
+    // at the same time, and the rerun of LaTeX only starts once all of them are done
+    KileDocument::TextInfo *docinfo = manager()->info()->docManager()->textInfoFor(source());
     if(bibs) {
         KILE_DEBUG_MAIN << "need to run the bibliography tool " << bibToolInLaTexOutput;
         ToolConfigPair bibTool = determineBibliographyBackend(bibToolInLaTexOutput);
@@ -510,7 +742,10 @@ void LaTeX::checkAutoRun()
             configureBibTeX(tool, targetDir() + '/' + S() + '.' + tool->from());
             // e.g. for LivePreview, it is necessary that the paths are copied to child processes
             tool->copyPaths(this);
-            runChildNext(tool);
+            if(docinfo) {
+                storeInputHashWhenDone(QList<Base*>() << tool, docinfo, "bib");
+            }
+            runChildNext(tool, false, true);
         }
     }
 
@@ -522,13 +757,17 @@ void LaTeX::checkAutoRun()
             configureMakeIndex(tool, targetDir() + '/' + S() + '.' + tool->from());
             // e.g. for LivePreview, it is necessary that the paths are copied to child processes
             tool->copyPaths(this);
-            runChildNext(tool);
+            if(docinfo) {
+                storeInputHashWhenDone(QList<Base*>() << tool, docinfo, "idx");
+            }
+            runChildNext(tool, false, true);
         }
     }
 
     if(asy) {
         KILE_DEBUG_MAIN << "need to run asymptote";
         int sz = manager()->info()->allAsyFigures().size();
+        QList<Base*> asyTools;
         for(int i = sz -1; i >= 0; --i) {
             Base *tool = manager()->createTool("Asymptote", QString());
 
@@ -536,9 +775,16 @@ void LaTeX::checkAutoRun()
                 configureAsymptote(tool, targetDir() + '/' + S() + '-' + QString::number(i + 1) + '.' + tool->from());
                 // e.g. for LivePreview, it is necessary that the paths are copied to child processes
                 tool->copyPaths(this);
-                runChildNext(tool);
+                asyTools << tool;
             }
         }
+        // the connections have to be made before the tools are started
+        if(docinfo) {
+            storeInputHashWhenDone(asyTools, docinfo, "asy");
+        }
+        for(Base *tool : asyTools) {
+            runChildNext(tool, false, true);
+        }
     }
 }
 
@@ -569,6 +815,11 @@ bool PreviewLaTeX::finish(int r)
     return true;
 }
 
+bool PreviewLaTeX::followsLogFile() const
+{
+    return false;
+}
+
 void PreviewLaTeX::setPreviewInfo(const QString &filename, int selrow,int docrow)
 {
     m_filename = filename;
@@ -14,6 +14,8 @@
 #ifndef KILESTDTOOLS_H
 #define KILESTDTOOLS_H
 
+#include <QHash>
+#include <QList>
 #include <QString>
 
 #include "kiledebug.h"
@@ -65,6 +67,17 @@ public:
     LaTeXOutputHandler* latexOutputHandler();
     void setLaTeXOutputHandler(LaTeXOutputHandler *h);
 
+    /**
+     * Compile the document with the precompiled preamble 'format' (see @ref PreambleFormat);
+     * the setting is passed on to the reruns of LaTeX.
+     **/
+    void setPrecompiledFormat(const QString& format) {
+        m_precompiledFormat = format;
+    }
+
+    virtual void prepareToRun() override;
+    virtual int run() override;
+
 Q_SIGNALS:
     void jumpToFirstError();
 
@@ -73,17 +86,43 @@ public Q_SLOTS:
 
 protected:
     LaTeXOutputHandler *m_latexOutputHandler;
+    QString m_precompiledFormat;
 
     virtual bool determineSource() override;
 
+    /**
+     * Returns true if the log file should be parsed while LaTeX is still running.
+     **/
+    virtual bool followsLogFile() const;
+
     void checqCriticals();
     void checkAutoRun();
     virtual void latexOutputParserResultInstalled() override;
 
+    /**
+     * The auxiliary tools are only run again if the contents of their inputs have changed since
+     * they were run last. If that is not known yet, the modification times are compared instead,
+     * where 'checkOnlyBibDependencies' indicates whether only the bibliography files are considered.
+     **/
     virtual bool updateBibs(bool checkOnlyBibDependencies);
     virtual bool updateIndex();
     virtual bool updateAsy();
 
+    /**
+     * Returns the hash of the inputs of the auxiliary tool 'key' that has been stored when it was
+     * run for the current target, or an empty array if none is known.
+     * The hashes are kept in the GUI settings of the project the document belongs to.
+     **/
+    QByteArray storedInputHash(KileDocument::TextInfo *docinfo, const QString& key);
+    void storeInputHash(KileDocument::TextInfo *docinfo, const QString& key, const QByteArray& hash);
+
+    /**
+     * The input hash of 'key' that has been computed for a rerun of the auxiliary tool is only
+     * stored once all the 'tools' run for it have finished successfully. Otherwise, the tool
+     * wouldn't be run again after it has failed or has been stopped.
+     **/
+    void storeInputHashWhenDone(const QList<KileTool::Base*>& tools, KileDocument::TextInfo *docinfo, const QString& key);
+
     virtual void configureLaTeX(KileTool::Base *tool, const QString& source);
     virtual void configureBibTeX(KileTool::Base *tool, const QString& source);
     virtual void configureMakeIndex(KileTool::Base *tool, const QString& source);
@@ -102,6 +141,10 @@ protected:
 
     //FIXME: this is a little 'hackish'
     static int m_reRun;
+
+private:
+    // the input hashes of the auxiliary tools that have to be run again
+    QHash<QString, QByteArray> m_pendingInputHashes;
 };
 
 class PreviewLaTeX : public LaTeX
@@ -118,6 +161,10 @@ public:
 public Q_SLOTS:
     virtual bool finish(int) override;
 
+protected:
+    // the problems are only mapped back to the original document after LaTeX has finished
+    virtual bool followsLogFile() const override;
+
 private:
     QString m_filename;
     int m_selrow;
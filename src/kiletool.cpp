@@ -282,13 +282,13 @@ bool Base::checkSource()
     return true;
 }
 
-void Base::runChildNext(Base *tool, bool block /*= false*/)
+void Base::runChildNext(Base *tool, bool block /*= false*/, bool parallel /*= false*/)
 {
     m_childToolSpawned = true;
     if(isPartOfLivePreview()) {
         tool->setPartOfLivePreview();
     }
-    manager()->runChildNext(this, tool, block);
+    manager()->runChildNext(this, tool, block, parallel);
 }
 
 void Base::setSource(const QString &source, const QString& workingDir)
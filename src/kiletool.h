@@ -331,7 +331,11 @@ protected:
 
     virtual bool checkSource();
 
-    void runChildNext(Base *tool, bool block = false);
+    /**
+     * Runs 'tool' directly after this one. Consecutive children for which 'parallel' is true are
+     * independent of each other and are run at the same time.
+     **/
+    void runChildNext(Base *tool, bool block = false, bool parallel = false);
 
     void setToolConfig(const QString& config) {
         m_toolConfig = config;
@@ -19,6 +19,7 @@
 #include <QFileInfo>
 #include <QMenu>
 #include <QRegExp>
+#include <QThread>
 #include <QTimer>
 
 #include <KActionCollection>
@@ -44,7 +45,7 @@
 
 namespace KileTool
 {
-QueueItem::QueueItem(Base *tool, bool block) : m_tool(tool), m_bBlock(block)
+QueueItem::QueueItem(Base *tool, bool block, bool parallel) : m_tool(tool), m_bBlock(block), m_bParallel(parallel), m_bStarted(false)
 {
 }
 
@@ -74,23 +75,29 @@ bool Queue::shouldBlock() const
 
 void Queue::enqueueNext(QueueItem *item)
 {
-    if(count() < 2) {
-        enqueue(item);
-    }
-    else {
-        QueueItem *headitem = dequeue();
-        Queue *oldqueue = new Queue(*this);
-
-        clear();
-        KILE_DEBUG_MAIN << "\tenqueueing: " << headitem->tool()->name() << endl;
-        enqueue(headitem);
-        KILE_DEBUG_MAIN << "\tenqueueing: " << item->tool()->name() << endl;
-        enqueue(item);
-        while(!oldqueue->isEmpty()) {
-            KILE_DEBUG_MAIN << "\tenqueueing: " << oldqueue->head()->tool()->name() << endl;
-            enqueue(oldqueue->dequeue());
+    // the head is about to be run even if it hasn't been started yet
+    const int position = qMin(count(), qMax(1, startedCount()));
+    KILE_DEBUG_MAIN << "\tenqueueing: " << item->tool()->name() << "at position" << position;
+    insert(position, item);
+}
+
+int Queue::indexOf(Base *tool) const
+{
+    for(int i = 0; i < count(); ++i) {
+        if(at(i)->tool() == tool) {
+            return i;
         }
     }
+    return -1;
+}
+
+int Queue::startedCount() const
+{
+    int started = 0;
+    while(started < count() && at(started)->isStarted()) {
+        ++started;
+    }
+    return started;
 }
 
 Manager::Manager(KileInfo *ki, KConfig *config, KileWidget::OutputView *output, QStackedWidget *stack, uint to, KActionCollection *ac) :
@@ -102,6 +109,7 @@ Manager::Manager(KileInfo *ki, KConfig *config, KileWidget::OutputView *output,
     m_bClear(true),
     m_nLastResult(Success),
     m_nTimeout(to),
+    m_maximumParallelTools(qMax(1, QThread::idealThreadCount())),
     m_bibliographyBackendSelectAction(Q_NULLPTR)
 {
     connect(m_ki->parserManager(), SIGNAL(documentParsingComplete()), this, SLOT(handleDocumentParsingComplete()));
@@ -189,7 +197,7 @@ void Manager::handleDocumentParsingComplete()
     m_toolsScheduledAfterParsingList.clear();
 }
 
-int Manager::runImmediately(Base *tool, bool insertNext /*= false*/, bool block /*= false*/, Base *parent /*= Q_NULLPTR*/)
+int Manager::runImmediately(Base *tool, bool insertNext /*= false*/, bool block /*= false*/, Base *parent /*= Q_NULLPTR*/, bool parallel /*= false*/)
 {
     KILE_DEBUG_MAIN << "==KileTool::Manager::runImmediately(Base *)============" << endl;
     if(m_bClear && (m_queue.count() == 0)) {
@@ -212,10 +220,10 @@ int Manager::runImmediately(Base *tool, bool insertNext /*= false*/, bool block
     m_timer->start(m_nTimeout);
 
     if(insertNext) {
-        m_queue.enqueueNext(new QueueItem(tool, block));
+        m_queue.enqueueNext(new QueueItem(tool, block, parallel));
     }
     else {
-        m_queue.enqueue(new QueueItem(tool, block));
+        m_queue.enqueue(new QueueItem(tool, block, parallel));
     }
 
     if(parent) {
@@ -234,43 +242,113 @@ int Manager::runImmediately(Base *tool, bool insertNext /*= false*/, bool block
     }
 }
 
-int Manager::runChildNext(Base *parent, Base *tool, bool block /*= false*/)
+int Manager::runChildNext(Base *parent, Base *tool, bool block /*= false*/, bool parallel /*= false*/)
 {
     parent->setupAsChildTool(tool);
 
-    return runImmediately(tool, true, block, parent);
+    return runImmediately(tool, true, block, parent, parallel);
 }
 
 int Manager::runNextInQueue()
 {
-    Base *head = m_queue.tool();
-    if(head) {
-        if (m_ki->errorHandler()->areMessagesShown()) {
-            m_ki->errorHandler()->addEmptyLineToMessages();
-        }
+    if(m_queue.isEmpty()) {
+        return ConfigureFailed;
+    }
 
-        if(!head->isPrepared()) {
-            head->prepareToRun();
+    while(QueueItem *item = nextItemToStart()) {
+        Base *tool = item->tool();
+        const int status = startTool(item);
+        if(status != Running) {
+            return status;
+        }
+        // viewers remove themselves from the queue when they are started, and the tools
+        // after them are only run a little later (see 'started')
+        if(m_queue.indexOf(tool) < 0) {
+            break;
         }
+    }
 
-        int status;
-        if((status=head->run()) != Running) { //tool did not even start, clear queue
-            stop();
-            for(QQueue<QueueItem*>::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
-                (*i)->tool()->deleteLater();
-                delete (*i);
+    return Running;
+}
+
+// Returns the item whose tool has to be started next, if any. Consecutive tools that may run in
+// parallel are started together, but not more of them than there are processor cores, and the
+// tools after them have to wait until all of them are done.
+QueueItem* Manager::nextItemToStart() const
+{
+    int runningTools = 0;
+    for(QueueItem *item : m_queue) {
+        if(!item->isStarted()) {
+            if(runningTools == 0 || (item->runsInParallel() && runningTools < m_maximumParallelTools)) {
+                return item;
             }
-            m_queue.clear();
-            return status;
+            return Q_NULLPTR;
+        }
+        if(!item->runsInParallel()) {
+            return Q_NULLPTR;
         }
+        ++runningTools;
+    }
+    return Q_NULLPTR;
+}
+
+int Manager::startTool(QueueItem *item)
+{
+    Base *tool = item->tool();
+    if (m_ki->errorHandler()->areMessagesShown()) {
+        m_ki->errorHandler()->addEmptyLineToMessages();
+    }
+
+    if(!tool->isPrepared()) {
+        tool->prepareToRun();
+    }
+
+    // tools running in parallel share the log, in which the first error of all of them is highlighted
+    const bool firstRunningTool = (m_queue.startedCount() == 0);
+    if(!firstRunningTool) {
+        m_bufferedToolOutput.insert(tool, QString());
+    }
 
+    // must be set before running as the tool might already be done when 'run' returns
+    item->setStarted();
+    int status;
+    if((status=tool->run()) != Running) { //tool did not even start, clear queue
+        stop();
+        deleteQueuedTools();
+        return status;
+    }
+
+    if(firstRunningTool) {
         m_ki->errorHandler()->startToolLogOutput();
-        emit(toolStarted());
+    }
+    emit(toolStarted());
 
-        return Running;
+    return Running;
+}
+
+void Manager::deleteQueuedTools()
+{
+    // tools that are still running are stopped when they are deleted
+    for(QQueue<QueueItem*>::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
+        const QString bufferedOutput = m_bufferedToolOutput.take((*i)->tool());
+        if(!bufferedOutput.isEmpty()) {
+            m_output->receive(bufferedOutput);
+        }
+        (*i)->tool()->deleteLater();
+        delete (*i);
     }
+    m_queue.clear();
+}
 
-    return ConfigureFailed;
+void Manager::receiveToolOutput(Base *tool, const QString &text)
+{
+    QHash<Base*, QString>::iterator it = m_bufferedToolOutput.find(tool);
+    if(it != m_bufferedToolOutput.end()) {
+        *it += text;
+    }
+    else {
+        m_output->receive(text);
+    }
 }
 
 Base* Manager::createTool(const QString& name, const QString &cfg, bool prepare)
@@ -295,7 +373,9 @@ void Manager::initTool(Base *tool)
     tool->setConfig(m_config);
 
     connect(tool, SIGNAL(message(int,QString,QString)), m_ki->errorHandler(), SLOT(printMessage(int,QString,QString)));
-    connect(tool, SIGNAL(output(QString)), m_output, SLOT(receive(QString)));
+    connect(tool, &Base::output, this, [this, tool](const QString &text) {
+        receiveToolOutput(tool, text);
+    });
     connect(tool, SIGNAL(done(KileTool::Base*,int,bool)), this, SLOT(done(KileTool::Base*,int)));
     connect(tool, SIGNAL(start(KileTool::Base*)), this, SLOT(started(KileTool::Base*)));
 }
@@ -306,8 +386,9 @@ void Manager::started(Base *tool)
     setEnabledStopButton(true);
 
     if (tool->isViewer()) {
-        if(tool == m_queue.tool()) {
-            m_queue.dequeue();
+        const int index = m_queue.indexOf(tool);
+        if(index >= 0) {
+            delete m_queue.takeAt(index);
         }
         setEnabledStopButton(false);
         QTimer::singleShot(100, this, SLOT(runNextInQueue()));
@@ -317,6 +398,7 @@ void Manager::started(Base *tool)
 void Manager::stop()
 {
     setEnabledStopButton(false);
+    // stopping the first tool clears the queue, which also stops the tools running in parallel with it
     if(m_queue.tool()) {
         m_queue.tool()->stop();
     }
@@ -326,6 +408,7 @@ void Manager::stopLivePreview()
 {
     KILE_DEBUG_MAIN;
 
+    // tools running in parallel either all belong to the live preview or none of them does
     Base *tool = m_queue.tool();
 
     if(tool && tool->isPartOfLivePreview()) {
@@ -348,13 +431,18 @@ void Manager::done(KileTool::Base *tool, int result)
     m_nLastResult = result;
 
     m_ki->errorHandler()->endToolLogOutput();
+    const QString bufferedOutput = m_bufferedToolOutput.take(tool);
+    if(!bufferedOutput.isEmpty()) {
+        m_output->receive(bufferedOutput);
+    }
 
-    if(tool != m_queue.tool()) { //oops, tool finished async, could happen with view tools
+    const int index = m_queue.indexOf(tool);
+    if(index < 0 || !m_queue.at(index)->isStarted()) { //oops, tool finished async, could happen with view tools
         tool->deleteLater();
         return;
     }
 
-    QueueItem *item = m_queue.dequeue();
+    QueueItem *item = m_queue.takeAt(index);
     item->tool()->deleteLater();
     delete item;
 
@@ -369,15 +457,15 @@ void Manager::done(KileTool::Base *tool, int result)
             runNextInQueue();
         }
         else {
-            for(QQueue<QueueItem*>::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
-                (*i)->tool()->deleteLater();
-                delete (*i);
-            }
-            m_queue.clear();
+            deleteQueuedTools();
             m_ki->focusLog();
         }
     }
     else { //continue
+        // other tools might still be running in parallel
+        if(m_queue.startedCount() > 0) {
+            setEnabledStopButton(true);
+        }
         runNextInQueue();
     }
 }
@@ -388,6 +476,7 @@ void Manager::deleteLivePreviewToolsFromQueue()
         QueueItem *item = *i;
         if(item->tool()->isPartOfLivePreview()) {
             i = m_queue.erase(i);
+            m_bufferedToolOutput.remove(item->tool());
             item->tool()->deleteLater();
             delete item;
         }
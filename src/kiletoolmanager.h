@@ -15,6 +15,7 @@
 #ifndef KILETOOLMANAGER_H
 #define KILETOOLMANAGER_H
 
+#include <QHash>
 #include <QList>
 #include <QObject>
 #include <QQueue>
@@ -67,7 +68,7 @@ class LivePreviewManager;
 class QueueItem
 {
 public:
-    explicit QueueItem(Base *tool, bool block = false);
+    explicit QueueItem(Base *tool, bool block = false, bool parallel = false);
     ~QueueItem();
 
     Base* tool() const {
@@ -76,10 +77,25 @@ public:
     bool shouldBlock() {
         return m_bBlock;
     }
+    /**
+     * Whether the tool may run at the same time as the adjacent items in the queue
+     * that may also run in parallel.
+     **/
+    bool runsInParallel() const {
+        return m_bParallel;
+    }
+    bool isStarted() const {
+        return m_bStarted;
+    }
+    void setStarted() {
+        m_bStarted = true;
+    }
 
 private:
     Base *m_tool;
     bool m_bBlock;
+    bool m_bParallel;
+    bool m_bStarted;
 };
 
 class Queue : public QQueue<QueueItem*>
@@ -88,7 +104,16 @@ public:
     Base* tool() const;
     bool shouldBlock() const;
 
+    /**
+     * Inserts 'item' directly after the tools that are running at the moment.
+     **/
     void enqueueNext(QueueItem *);
+
+    int indexOf(Base *tool) const;
+    /**
+     * Returns the number of tools at the head of the queue that have been started.
+     **/
+    int startedCount() const;
 };
 
 class Manager : public QObject
@@ -156,7 +181,7 @@ private:
     void initTool(Base*);
 
 private Q_SLOTS:
-    int runImmediately(Base *tool, bool insertAtTop = false, bool block = false, Base *parent = Q_NULLPTR);
+    int runImmediately(Base *tool, bool insertAtTop = false, bool block = false, Base *parent = Q_NULLPTR, bool parallel = false);
     int runNextInQueue();
     void enableClear();
 
@@ -167,7 +192,8 @@ private Q_SLOTS:
     void stopActionDestroyed();
 
     // must be used when a child tool is launched from within another tool!
-    int runChildNext(Base *parent, Base *tool, bool block = false);
+    // Consecutive children for which 'parallel' is true are run at the same time.
+    int runChildNext(Base *parent, Base *tool, bool block = false, bool parallel = false);
 
     void toolScheduledAfterParsingDestroyed(KileTool::Base *tool);
     void handleDocumentParsingComplete();
@@ -198,7 +224,11 @@ private:
     bool				m_bClear;
     int				m_nLastResult;
     uint				m_nTimeout;
+    int				m_maximumParallelTools;
     QQueue<Base*>			m_toolsScheduledAfterParsingList;
+    // the output of tools that have been started while another tool was running is collected
+    // and shown at once when they are done, such that it isn't interleaved with the other output
+    QHash<Base*, QString>		m_bufferedToolOutput;
     KSelectAction			*m_bibliographyBackendSelectAction;
     QAction				*m_bibliographyBackendAutodetectAction;
     QAction *m_bibliographyBackendResetAutodetectedAction;
@@ -207,6 +237,11 @@ private:
 
     void createActions(KActionCollection *ac);
 
+    QueueItem* nextItemToStart() const;
+    int startTool(QueueItem *item);
+    void receiveToolOutput(Base *tool, const QString &text);
+    void deleteQueuedTools();
+
     void deleteLivePreviewToolsFromQueue();
     void deleteLivePreviewToolsFromRunningAfterParsingQueue();
 };
@@ -46,6 +46,7 @@
 #include "kiletool_enums.h"
 #include "kiledocmanager.h"
 #include "kileviewmanager.h"
+#include "preambleformat.h"
 
 //TODO: it still has to be checked whether it is necessary to use LaTeXInfo objects
 
@@ -58,9 +59,11 @@ public:
         : lastSynchronizationCursor(-1, -1)
     {
         initTemporaryDirectory();
+        preambleFormat = new PreambleFormat(m_tempDir->path(), QStringLiteral("kile-preamble"));
     }
 
     ~PreviewInformation() {
+        delete preambleFormat;
         delete m_tempDir;
     }
 
@@ -124,6 +127,7 @@ public:
     QString previewFile;
     QHash<KileDocument::TextInfo*, QByteArray> textHash;
     KTextEditor::Cursor lastSynchronizationCursor;
+    PreambleFormat *preambleFormat;
 };
 
 LivePreviewManager::LivePreviewManager(KileInfo *ki, KActionCollection *ac)
@@ -787,14 +791,16 @@ void LivePreviewManager::reloadDocumentInViewer()
 }
 
 
-static QByteArray computeHashOfDocument(KTextEditor::Document *doc)
+// the hash of the snapshot is computed from the hashes of the unchanged parts of the document,
+// which are shared with the previous snapshots; hence, only the edited lines have to be hashed again
+static QByteArray computeHashOfDocument(KileDocument::TextInfo *textInfo)
 {
     QCryptographicHash cryptographicHash(QCryptographicHash::Sha1);
-    cryptographicHash.addData(doc->text().toUtf8());
+    cryptographicHash.addData(textInfo->documentSnapshot().hash());
     // allows to catch situations when the URL of the document has changed,
     // e.g. after a save-as operation, which breaks the handling of source
     // references for the displayed document
-    cryptographicHash.addData(doc->url().toEncoded());
+    cryptographicHash.addData(textInfo->url().toEncoded());
 
     return cryptographicHash.result();
 }
@@ -813,7 +819,7 @@ static void fillTextHashForProject(KileProject *project, QHash<KileDocument::Tex
         if(!document) {
             continue;
         }
-        textHash[textInfo] = computeHashOfDocument(document);
+        textHash[textInfo] = computeHashOfDocument(textInfo);
     }
 }
 
@@ -830,7 +836,7 @@ void LivePreviewManager::fillTextHashForMasterDocument(QHash<KileDocument::TextI
         if(!document) {
             continue;
         }
-        textHash[textInfo] = computeHashOfDocument(document);
+        textHash[textInfo] = computeHashOfDocument(textInfo);
     }
 }
 
@@ -871,7 +877,7 @@ void LivePreviewManager::showPreviewCompileIfNecessary(KileDocument::LaTeXInfo *
             fillTextHashForProject(project, newHash);
         }
         else {
-            newHash[latexInfo] = computeHashOfDocument(view->document());
+            newHash[latexInfo] = computeHashOfDocument(latexInfo);
         }
 
         if(newHash != previewInformation->textHash || !QFile::exists(previewInformation->previewFile)) {
@@ -1013,6 +1019,11 @@ void LivePreviewManager::compilePreview(KileDocument::LaTeXInfo *latexInfo, KTex
     }
     latex->setBstInputPaths(bstInputPath);
 
+    if(KileConfig::livePreviewPrecompilePreamble()) {
+        latex->setPrecompiledFormat(precompiledPreambleFormat(previewInformation, latex->readEntry("command"),
+                                                              fileInfo.absoluteFilePath(), texInputPath));
+    }
+
 // 	m_runningPathToPreviewPathHash[fileInfo.absoluteFilePath()] = tempFile;
 // 	m_runningPreviewPathToPathHash[tempFile] = fileInfo.absoluteFilePath();
 
@@ -1039,7 +1050,7 @@ void LivePreviewManager::compilePreview(KileDocument::LaTeXInfo *latexInfo, KTex
         fillTextHashForProject(project, m_runningTextHash);
     }
     else {
-        m_runningTextHash[latexInfo] = computeHashOfDocument(latexInfo->getDoc());
+        m_runningTextHash[latexInfo] = computeHashOfDocument(latexInfo);
     }
     m_runningPreviewInformation = previewInformation;
     showPreviewRunning();
@@ -1049,6 +1060,23 @@ void LivePreviewManager::compilePreview(KileDocument::LaTeXInfo *latexInfo, KTex
     emit(livePreviewRunning());
 }
 
+QString LivePreviewManager::precompiledPreambleFormat(PreviewInformation *previewInformation, const QString& command,
+                                                      const QString& fileName, const QString& teXInputPaths)
+{
+    if(!PreambleFormat::isSupportedCommand(command)) {
+        return QString();
+    }
+    // the preamble found by the parser can only be used if it is still the beginning of the
+    // document that is about to be compiled; a pending parsing run, e.g. the one that is started
+    // whenever the document is saved, doesn't matter as long as the preamble hasn't changed
+    KileDocument::LaTeXInfo *latexInfo = dynamic_cast<KileDocument::LaTeXInfo*>(m_ki->docManager()->textInfoFor(fileName));
+    if(!latexInfo || !PreambleFormat::preambleMatchesDocument(latexInfo->preamble(), latexInfo->documentSnapshot())) {
+        KILE_DEBUG_MAIN << "preamble of" << fileName << "is not known yet";
+        return QString();
+    }
+    return previewInformation->preambleFormat->format(latexInfo->preamble(), command, fileName, teXInputPaths);
+}
+
 bool LivePreviewManager::isLivePreviewActive() const
 {
     KParts::ReadOnlyPart *viewerPart = m_ki->viewManager()->viewerPart();
@@ -1148,6 +1176,12 @@ void LivePreviewManager::recompileLivePreview()
         KILE_DEBUG_MAIN << "no text view is shown; hence, no preview can be shown";
         return;
     }
+    // the files loaded in the preamble might have changed
+    KileDocument::LaTeXInfo *latexInfo = dynamic_cast<KileDocument::LaTeXInfo*>(m_ki->docManager()->textInfoFor(textView->document()));
+    PreviewInformation *previewInformation = latexInfo ? findPreviewInformation(latexInfo) : Q_NULLPTR;
+    if(previewInformation) {
+        previewInformation->preambleFormat->discard();
+    }
     handleTextViewActivated(textView, false, true); // don't automatically clear the preview but force compilation
 }
 
@@ -153,6 +153,13 @@ private:
 
     void updatePreviewInformationAfterCompilationFinished();
 
+    /**
+     * Returns the precompiled preamble that can be used for compiling 'fileName', or an
+     * empty string if there is none (yet).
+     **/
+    QString precompiledPreambleFormat(PreviewInformation *previewInformation, const QString& command,
+                                      const QString& fileName, const QString& teXInputPaths);
+
     void displayErrorMessage(const QString &text, bool clearFirst = false);
 
     void createActions(KActionCollection *ac);
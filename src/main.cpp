@@ -36,6 +36,7 @@
 #include "kileversion.h"
 #include "kiledebug.h"
 #include "kileviewmanager.h"
+#include "startupprofiler.h"
 
 Q_LOGGING_CATEGORY(LOG_KILE_MAIN, "org.kde.kile.main", QtWarningMsg)
 Q_LOGGING_CATEGORY(LOG_KILE_PARSER, "org.kde.kile.parser", QtWarningMsg)
@@ -92,6 +93,8 @@ inline void initQtResources() {
 
 extern "C" Q_DECL_EXPORT int kdemain(int argc, char **argv)
 {
+    KileUtilities::StartupProfiler::start();
+
     // enable high dpi support
     QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps, true);
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling, true);
@@ -141,12 +144,16 @@ extern "C" Q_DECL_EXPORT int kdemain(int argc, char **argv)
 
     parser.addOption(QCommandLineOption(QStringList() <<  QLatin1String("line"), i18n("Jump to line"), QLatin1String("line")));
     parser.addOption(QCommandLineOption(QStringList() <<  QLatin1String("new"), i18n("Start a new Kile mainwindow")));
+    parser.addOption(QCommandLineOption(QStringList() <<  QLatin1String("profile-startup"), i18n("Print how long the phases of the start-up take")));
 //TODO KF5 VERIFY THAT '-' STILL WORKS
     parser.addPositionalArgument("urls", i18n("Files to open / specify '-' to read from standard input"), QLatin1String("[urls...]"));
 
     parser.process(app);
     aboutData.processCommandLine(&parser);
 
+    KileUtilities::StartupProfiler::setEnabled(parser.isSet("profile-startup"));
+    KileUtilities::StartupProfiler::finishPhase(QStringLiteral("application set-up"));
+
     bool running = false;
 
     {
@@ -199,6 +206,7 @@ extern "C" Q_DECL_EXPORT int kdemain(int argc, char **argv)
             QString line = parser.value("line");
             kile->setLine(line);
         }
+        KileUtilities::StartupProfiler::finishPhase(QStringLiteral("opening the files given on the command line"));
 
         return app.exec();
     }
@@ -154,6 +154,8 @@ public:
  **/
 typedef QList<LatexOutputInfo> LatexOutputInfoArray;
 
+Q_DECLARE_METATYPE(LatexOutputInfoArray)
+
 
 class LaTeXOutputHandler
 {
@@ -27,7 +27,7 @@
 
 namespace KileParser {
 
-BibTeXParserInput::BibTeXParserInput(const QUrl &url, QStringList textLines)
+BibTeXParserInput::BibTeXParserInput(const QUrl &url, const KileDocument::DocumentSnapshot& textLines)
     : ParserInput(url),
       textLines(textLines)
 {
@@ -59,8 +59,8 @@ ParserOutput* BibTeXParser::parse()
 
     qCDebug(LOG_KILE_PARSER);
 
-    static QRegExp reItem("^(\\s*)@([a-zA-Z]+)");
-    static QRegExp reSpecial("string|preamble|comment");
+    QRegExp reItem("^(\\s*)@([a-zA-Z]+)");
+    QRegExp reSpecial("string|preamble|comment");
 
     QString s, key;
     int col = 0, startcol, startline = 0;
@@ -26,9 +26,9 @@ namespace KileParser {
 class BibTeXParserInput : public ParserInput
 {
 public:
-    BibTeXParserInput(const QUrl &url, QStringList textLines);
+    BibTeXParserInput(const QUrl &url, const KileDocument::DocumentSnapshot& textLines);
 
-    QStringList textLines;
+    KileDocument::DocumentSnapshot textLines;
 };
 
 class BibTeXParserOutput : public ParserOutput {
@@ -51,7 +51,7 @@ public:
     ParserOutput* parse() override;
 
 protected:
-    QStringList m_textLines;
+    KileDocument::DocumentSnapshot m_textLines;
 };
 
 }
@@ -16,6 +16,12 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QMutex>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QThread>
+
+#include <cstring>
 
 #include <KLocalizedString>
 
@@ -25,6 +31,22 @@
 
 namespace KileParser {
 
+namespace {
+// the minimal time between two reports of partial results (in ms)
+const int partialResultInterval = 250;
+// the time between two checks for new lines in a log file that is being followed (in ms)
+const int followInterval = 100;
+
+// the listings of the directories in which files have been looked up
+struct DirectoryListing {
+    QDateTime lastModified;
+    QSet<QString> fileNames;
+};
+QMutex s_directoryListingMutex;
+QHash<QString, DirectoryListing> s_directoryListingHash;
+const int maximalDirectoryListingCount = 1024;
+}
+
 LaTeXOutputParserInput::LaTeXOutputParserInput(const QUrl &url, KileDocument::Extensions *extensions,
                                                                 const QString& sourceFile,
                                                                 const QString &texfilename,
@@ -35,7 +57,9 @@ LaTeXOutputParserInput::LaTeXOutputParserInput(const QUrl &url, KileDocument::Ex
       sourceFile(sourceFile),
       texfilename(texfilename),
       selrow(selrow),
-      docrow(docrow)
+      docrow(docrow),
+      followOutput(false),
+      previousLogSize(-1)
 {
 }
 
@@ -53,13 +77,22 @@ LaTeXOutputParser::LaTeXOutputParser(ParserThread *parserThread, LaTeXOutputPars
       m_extensions(input->extensions),
       m_infoList(Q_NULLPTR),
       m_logFile(input->url.toLocalFile()),
+      m_logUrl(input->url),
+      m_nReportedItems(0),
+      m_errorReported(false),
       texfilename(input->texfilename),
       selrow(input->selrow),
-      docrow(input->docrow)
+      docrow(input->docrow),
+      m_followOutput(input->followOutput),
+      m_previousLogSize(input->previousLogSize),
+      m_previousLogModified(input->previousLogModified)
 {
     m_nErrors = 0;
     m_nWarnings = 0;
     m_nBadBoxes = 0;
+    m_nOutputLines = 0;
+    m_currentCookie = Start;
+    m_latexDocumentExtensions = m_extensions->latexDocuments().split(' ', QString::SkipEmptyParts);
     setSource(input->sourceFile);
 }
 
@@ -70,38 +103,86 @@ LaTeXOutputParser::~LaTeXOutputParser()
 
 bool LaTeXOutputParser::fileExists(const QString & name)
 {
-    static QFileInfo fi;
+    QHash<QString, bool>::const_iterator it = m_fileExistsHash.constFind(name);
+    if(it != m_fileExistsHash.constEnd()) {
+        return *it;
+    }
 
-    if (QDir::isAbsolutePath(name)) {
-        fi.setFile(name);
-        if(fi.exists() && !fi.isDir()) {
-            return true;
-        }
-        else {
-            return false;
+    bool exists = false;
+    if(QDir::isAbsolutePath(name)) {
+        exists = isExistingFile(name);
+    }
+    else {
+        const QString fileName = path() + '/' + name;
+        exists = isExistingFile(fileName) || isExistingFile(fileName + m_extensions->latexDocumentDefault());
+
+        // try to determine the LaTeX source file
+        for(QStringList::const_iterator it = m_latexDocumentExtensions.constBegin();
+                !exists && it != m_latexDocumentExtensions.constEnd(); ++it) {
+            exists = isExistingFile(fileName + (*it));
         }
     }
+    m_fileExistsHash.insert(name, exists);
+    return exists;
+}
 
-    fi.setFile(path() + '/' + name);
-    if(fi.exists() && !fi.isDir()) {
+// instead of checking every candidate file name separately, the contents of its directory are listed;
+// the results are cached per parsing run by 'fileExists'
+bool LaTeXOutputParser::isExistingFile(const QString & fileName)
+{
+    const QString cleanFileName = QDir::cleanPath(fileName);
+    const int separatorIndex = cleanFileName.lastIndexOf('/');
+    if(separatorIndex < 0 || separatorIndex == cleanFileName.length() - 1) {
+        return false;
+    }
+    const QString directory = (separatorIndex == 0) ? QStringLiteral("/") : cleanFileName.left(separatorIndex);
+    if(filesInDirectory(directory).contains(cleanFileName.mid(separatorIndex + 1))) {
         return true;
     }
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    // the file systems are usually case-insensitive here, i.e. the name in the log file
+    // might differ from the listed one in case only
+    return QFileInfo::exists(cleanFileName);
+#else
+    return false;
+#endif
+}
 
-    fi.setFile(path() + '/' + name + m_extensions->latexDocumentDefault());
-    if(fi.exists() && !fi.isDir()) {
-        return true;
+// returns the names of the files (but not of the subdirectories) in 'directory'; the listings are shared
+// between all the parsing runs and are only read again when the modification time of the directory changes
+QSet<QString> LaTeXOutputParser::filesInDirectory(const QString & directory)
+{
+    QHash<QString, QSet<QString> >::const_iterator it = m_directoryFilesHash.constFind(directory);
+    if(it != m_directoryFilesHash.constEnd()) {
+        return *it;
     }
 
-    // try to determine the LaTeX source file
-    QStringList extlist = m_extensions->latexDocuments().split(' ');
-    for(QStringList::Iterator it = extlist.begin(); it!=extlist.end(); ++it) {
-        fi.setFile(path() + '/' + name + (*it));
-        if(fi.exists() && !fi.isDir()) {
-            return true;
+    QSet<QString> fileNames;
+    const QFileInfo directoryInfo(directory);
+    if(directoryInfo.isDir()) {
+        const QDateTime lastModified = directoryInfo.lastModified();
+
+        QMutexLocker locker(&s_directoryListingMutex);
+        QHash<QString, DirectoryListing>::const_iterator listingIt = s_directoryListingHash.constFind(directory);
+        if(listingIt != s_directoryListingHash.constEnd() && listingIt->lastModified == lastModified) {
+            fileNames = listingIt->fileNames;
+        }
+        else {
+            const QStringList entryList = QDir(directory).entryList(QDir::Files | QDir::Hidden | QDir::System);
+            for(const QString& entry : entryList) {
+                fileNames.insert(entry);
+            }
+            if(s_directoryListingHash.size() >= maximalDirectoryListingCount) {
+                s_directoryListingHash.clear();
+            }
+            DirectoryListing listing;
+            listing.lastModified = lastModified;
+            listing.fileNames = fileNames;
+            s_directoryListingHash.insert(directory, listing);
         }
     }
-
-    return false;
+    m_directoryFilesHash.insert(directory, fileNames);
+    return fileNames;
 }
 
 // There are basically two ways to detect the current file TeX is processing:
@@ -634,34 +715,49 @@ ParserOutput* LaTeXOutputParser::parse()
     m_stackFile.clear();
     m_stackFile.push(LOFStackItem(QFileInfo(source()).fileName(), true));
 
-    short sCookie = 0;
-    QString s;
     QFile f(m_logFile);
 
-    m_log.clear();
     m_nOutputLines = 0;
+    m_nReportedItems = 0;
+    m_errorReported = false;
+    m_currentCookie = Start;
 
-    if(!f.open(QIODevice::ReadOnly)) {
+    if(m_followOutput && !waitForFollowedLog()) {
+        qCDebug(LOG_KILE_PARSER) << "stopping...";
+        delete(parserOutput);
+        return Q_NULLPTR;
+    }
+
+    // a log file that is still being written is read without buffering to see the new lines
+    if(!f.open(m_followOutput ? QIODevice::ReadOnly | QIODevice::Unbuffered : QIODevice::ReadOnly)) {
         parserOutput->problem = i18n("Cannot open log file; did you run LaTeX?");
         return parserOutput;
     }
-    m_infoList = &parserOutput->infoList;
-    QTextStream t(&f);
-    while(!t.atEnd()) {
-        if(!m_parserThread->shouldContinueDocumentParsing()) {
-            qCDebug(LOG_KILE_PARSER) << "stopping...";
-            delete(parserOutput);
-            f.close();
-            return Q_NULLPTR;
-        }
-        s = t.readLine();
-        sCookie = parseLine(s.trimmed(), sCookie);
-        ++m_nOutputLines;
+    m_reportTimer.start();
 
-        m_log += s + '\n';
+    // log files can become very large, so we avoid reading them into memory if possible
+    bool completed = false;
+    const qint64 size = f.size();
+    uchar *data = (size > 0 && !m_followOutput) ? f.map(0, size) : Q_NULLPTR;
+    if(m_followOutput) {
+        completed = parseFollowedLog(f);
+    }
+    else if(data) {
+        completed = parseMappedLog(data, size);
+        f.unmap(data);
+    }
+    else {
+        QTextStream t(&f);
+        completed = parseLogStream(t);
     }
     f.close();
 
+    if(!completed) {
+        qCDebug(LOG_KILE_PARSER) << "stopping...";
+        delete(parserOutput);
+        return Q_NULLPTR;
+    }
+
     parserOutput->nWarnings = m_nWarnings;
     parserOutput->nErrors = m_nErrors;
     parserOutput->nBadBoxes = m_nBadBoxes;
@@ -675,6 +771,142 @@ ParserOutput* LaTeXOutputParser::parse()
     return parserOutput;
 }
 
+bool LaTeXOutputParser::parseMappedLog(const uchar *data, qint64 size)
+{
+    // 'QTextStream' uses the locale codec as well
+    QTextCodec *codec = QTextCodec::codecForLocale();
+    const char *begin = reinterpret_cast<const char*>(data);
+    const char *end = begin + size;
+
+    for(const char *lineStart = begin; lineStart < end;) {
+        if(!m_parserThread->shouldContinueDocumentParsing()) {
+            return false;
+        }
+        const char *lineEnd = static_cast<const char*>(std::memchr(lineStart, '\n', end - lineStart));
+        if(!lineEnd) {
+            lineEnd = end;
+        }
+        const char *nextLineStart = lineEnd + 1;
+        if(lineEnd > lineStart && *(lineEnd - 1) == '\r') {
+            --lineEnd;
+        }
+        processLogLine(codec->toUnicode(lineStart, lineEnd - lineStart));
+        lineStart = nextLineStart;
+    }
+    return true;
+}
+
+bool LaTeXOutputParser::parseLogStream(QTextStream &stream)
+{
+    QString s;
+    while(!stream.atEnd()) {
+        if(!m_parserThread->shouldContinueDocumentParsing()) {
+            return false;
+        }
+        s = stream.readLine();
+        processLogLine(s);
+    }
+    return true;
+}
+
+bool LaTeXOutputParser::isFollowingLog() const
+{
+    OutputParserThread *outputParserThread = dynamic_cast<OutputParserThread*>(m_parserThread);
+    return outputParserThread && outputParserThread->isFollowingLaTeXLogFile(m_logUrl);
+}
+
+// LaTeX only truncates the log file of the previous run once it has started to process
+// the document, so we wait until the log file differs from the one that existed when LaTeX
+// was launched; comparing the modification time with the launch time would fail on file
+// systems that only store whole seconds
+bool LaTeXOutputParser::waitForFollowedLog()
+{
+    while(isFollowingLog()) {
+        if(!m_parserThread->shouldContinueDocumentParsing()) {
+            return false;
+        }
+        const QFileInfo fileInfo(m_logFile);
+        if(fileInfo.exists() && (m_previousLogSize < 0 || fileInfo.size() != m_previousLogSize
+                                 || fileInfo.lastModified() != m_previousLogModified)) {
+            break;
+        }
+        QThread::msleep(followInterval);
+    }
+    return true;
+}
+
+bool LaTeXOutputParser::parseFollowedLog(QFile &file)
+{
+    QTextCodec *codec = QTextCodec::codecForLocale();
+    // the last line that hasn't been completed yet
+    QByteArray pendingData;
+
+    while(true) {
+        if(!m_parserThread->shouldContinueDocumentParsing()) {
+            return false;
+        }
+        // this has to be checked before reading, as otherwise lines that are written
+        // shortly before LaTeX exits could be missed
+        const bool following = isFollowingLog();
+        const QByteArray data = file.readAll();
+        if(data.isEmpty()) {
+            if(!following) {
+                break;
+            }
+            reportPartialResult();
+            QThread::msleep(followInterval);
+            continue;
+        }
+        pendingData += data;
+
+        int lineStart = 0;
+        for(int lineEnd = pendingData.indexOf('\n'); lineEnd >= 0; lineEnd = pendingData.indexOf('\n', lineStart)) {
+            if(!m_parserThread->shouldContinueDocumentParsing()) {
+                return false;
+            }
+            const int length = (lineEnd > lineStart && pendingData.at(lineEnd - 1) == '\r') ? lineEnd - lineStart - 1 : lineEnd - lineStart;
+            processLogLine(codec->toUnicode(pendingData.constData() + lineStart, length));
+            lineStart = lineEnd + 1;
+        }
+        pendingData.remove(0, lineStart);
+    }
+
+    if(!pendingData.isEmpty()) {
+        if(pendingData.endsWith('\r')) {
+            pendingData.chop(1);
+        }
+        processLogLine(codec->toUnicode(pendingData));
+    }
+    return true;
+}
+
+void LaTeXOutputParser::processLogLine(const QString &strLine)
+{
+    m_currentCookie = parseLine(strLine.trimmed(), m_currentCookie);
+    ++m_nOutputLines;
+    reportPartialResult();
+}
+
+void LaTeXOutputParser::reportPartialResult()
+{
+    // the source lines of QuickPreview are only adjusted once all the items are known
+    if(!texfilename.isEmpty() || m_infoList->size() <= m_nReportedItems) {
+        return;
+    }
+    // the first error is shown as soon as it has been found
+    const bool isFirstError = (!m_errorReported && m_nErrors > 0);
+    if(!isFirstError && !m_reportTimer.hasExpired(partialResultInterval)) {
+        return;
+    }
+    OutputParserThread *outputParserThread = dynamic_cast<OutputParserThread*>(m_parserThread);
+    if(outputParserThread) {
+        outputParserThread->reportPartialResult(m_logUrl, m_infoList->mid(m_nReportedItems));
+    }
+    m_nReportedItems = m_infoList->size();
+    m_errorReported = (m_nErrors > 0);
+    m_reportTimer.restart();
+}
+
 void LaTeXOutputParser::updateInfoLists(const QString &texfilename, int selrow, int docrow)
 {
     // get a short name for the original tex file
@@ -15,9 +15,16 @@
 #ifndef LATEXOUTPUTPARSER_H
 #define LATEXOUTPUTPARSER_H
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QLinkedList>
+#include <QSet>
 #include <QStack>
 
+class QFile;
+class QTextStream;
+
 #include "kileconstants.h"
 #include "kileextensions.h"
 #include "outputinfo.h"
@@ -38,6 +45,12 @@ public:
     QString texfilename;
     int selrow;
     int docrow;
+    // if true, the log file is read while LaTeX is still writing it (see 'OutputParserThread::followLaTeXLogFile')
+    bool followOutput;
+    // the size and the modification time of the log file before LaTeX was launched; the size
+    // is -1 if there was no log file
+    qint64 previousLogSize;
+    QDateTime previousLogModified;
 };
 
 class LaTeXOutputParserOutput : public ParserOutput {
@@ -91,10 +104,6 @@ public:
 
     enum {Start = 0, FileName, FileNameHeuristic, Error, Warning, BadBox, LineNumber};
 
-    const QString& log() const {
-        return m_log;
-    }
-
     const QString& source() const  {
         return m_source;
     }
@@ -132,6 +141,29 @@ protected:
     bool detectBadBoxLineNumber(QString & strLine, short & dwCookie, int len);
 
     bool fileExists(const QString & name);
+    bool isExistingFile(const QString & fileName);
+    QSet<QString> filesInDirectory(const QString & directory);
+
+    /**
+    Reads the log file line by line from the memory mapping 'data' of length 'size'.
+    Returns false if the parsing has been interrupted.
+    */
+    bool parseMappedLog(const uchar *data, qint64 size);
+    bool parseLogStream(QTextStream &stream);
+    /**
+    Reads the lines that have been appended to the log file until LaTeX has finished
+    writing it.
+    */
+    bool parseFollowedLog(QFile &file);
+    bool waitForFollowedLog();
+    bool isFollowingLog() const;
+    void processLogLine(const QString &strLine);
+
+    /**
+    Passes the items that have been found since the last call to the parser thread,
+    which forwards them to the error handler before the whole log file has been read.
+    */
+    void reportPartialResult();
 
 protected:
     /**
@@ -161,18 +193,34 @@ private:
     int m_nParens;
 
     int m_nOutputLines;
-    QString m_log, m_source, m_srcPath;
+    short m_currentCookie;
+    QString m_source, m_srcPath;
 
     /** Pointer to list of Latex output information */
     LatexOutputInfoArray *m_infoList;
 
     QString m_logFile;
+    QUrl m_logUrl;
+
+    // the number of items in 'm_infoList' that have been reported already
+    int m_nReportedItems;
+    bool m_errorReported;
+    QElapsedTimer m_reportTimer;
 
     // for QuickPreview
     QString texfilename;
     int selrow;
     int docrow;
 
+    bool m_followOutput;
+    qint64 m_previousLogSize;
+    QDateTime m_previousLogModified;
+
+    // avoids looking up the same files and directories again during one parsing run
+    QStringList m_latexDocumentExtensions;
+    QHash<QString, bool> m_fileExistsHash;
+    QHash<QString, QSet<QString> > m_directoryFilesHash;
+
     /**
     Stack containing the files parsed by the compiler. The top-most
     element is the currently parsed file.
@@ -16,20 +16,21 @@
 #include "latexparser.h"
 
 #include <QFileInfo>
-#include <QRegExp>
 
 #include <KLocalizedString>
 
 #include "codecompletion.h"
+#include "latextokenizer.h"
 #include "parserthread.h"
 
 namespace KileParser {
 
-LaTeXParserInput::LaTeXParserInput(const QUrl &url, QStringList textLines,
+LaTeXParserInput::LaTeXParserInput(const QUrl &url, const KileDocument::DocumentSnapshot& textLines,
                                    KileDocument::Extensions *extensions,
                                    const QMap<QString, KileStructData>& dictStructLevel,
                                    bool showSectioningLabels,
-                                   bool showStructureTodo)
+                                   bool showStructureTodo,
+                                   const KileDocument::EditedLineRange& editedLineRange)
     : ParserInput(url),
       textLines(textLines),
       extensions(extensions),
@@ -37,12 +38,28 @@ LaTeXParserInput::LaTeXParserInput(const QUrl &url, QStringList textLines,
       // can lead to a crash:
       dictStructLevel(dictStructLevel),
       showSectioningLabels(showSectioningLabels),
-      showStructureTodo(showStructureTodo)
+      showStructureTodo(showStructureTodo),
+      editedLineRange(editedLineRange)
 {
 }
 
+LaTeXParserSegmentResult::LaTeXParserSegmentResult()
+    : bIsRoot(false),
+      beginDocumentLine(-1),
+      beginDocumentColumn(-1)
+{
+}
+
+bool LaTeXParserSegmentResult::isEmpty() const
+{
+    return labels.isEmpty() && bibItems.isEmpty() && deps.isEmpty() && bibliography.isEmpty()
+           && packages.isEmpty() && newCommands.isEmpty() && asyFigures.isEmpty()
+           && structureViewItems.isEmpty() && !bIsRoot && beginDocumentLine < 0;
+}
+
 LaTeXParserOutput::LaTeXParserOutput()
-    : bIsRoot(false)
+    : bIsRoot(false),
+      isIncremental(false)
 {
 }
 
@@ -58,8 +75,14 @@ LaTeXParser::LaTeXParser(ParserThread *parserThread, LaTeXParserInput *input,
       m_textLines(input->textLines),
       m_dictStructLevel(input->dictStructLevel),
       m_showSectioningLabels(input->showSectioningLabels),
-      m_showStructureTodo(input->showStructureTodo)
+      m_showStructureTodo(input->showStructureTodo),
+      m_editedLineRange(input->editedLineRange),
+      m_previousState(input->previousState)
 {
+    // allows to look up control sequences without creating strings for them
+    for(QMap<QString, KileStructData>::const_iterator it = m_dictStructLevel.constBegin(); it != m_dictStructLevel.constEnd(); ++it) {
+        m_commandHash.insert(QStringView(it.key()), it);
+    }
 }
 
 LaTeXParser::~LaTeXParser()
@@ -67,16 +90,15 @@ LaTeXParser::~LaTeXParser()
     qCDebug(LOG_KILE_PARSER);
 }
 
-BracketResult LaTeXParser::matchBracket(const QStringList& textLines, int &l, int &pos)
+BracketResult LaTeXParser::matchBracket(const KileDocument::DocumentSnapshot& textLines, int &l, int &pos)
 {
     BracketResult result;
-    TodoResult todo;
 
     if((getTextLine(textLines, l))[pos] == '[') {
         result.option = Parser::matchBracket(textLines, '[', l, pos);
         int p = 0;
         while(l < textLines.size()) {
-            if((p = processTextline(getTextLine(textLines, l), todo).indexOf('{', pos)) != -1) {
+            if((p = LaTeXTokenizer(textLines[l]).indexOf('{', pos)) != -1) {
                 pos = p;
                 break;
             }
@@ -96,333 +118,492 @@ BracketResult LaTeXParser::matchBracket(const QStringList& textLines, int &l, in
     return result;
 }
 
-//FIXME: this has to be completely rewritten!
-ParserOutput* LaTeXParser::parse()
+bool LaTeXParser::canParseIncrementally() const
 {
-    LaTeXParserOutput *parserOutput = new LaTeXParserOutput();
+    if(!m_previousState || !m_editedLineRange.isValid() || m_previousState->segments.isEmpty()) {
+        return false;
+    }
+    return m_previousState->revision == m_editedLineRange.baseRevision
+           && m_previousState->lineCount + m_editedLineRange.lineDelta == m_textLines.size()
+           && m_previousState->showSectioningLabels == m_showSectioningLabels
+           && m_previousState->showStructureTodo == m_showStructureTodo;
+}
 
-    qCDebug(LOG_KILE_PARSER) << m_textLines;
+static bool haveSameStructureViewItems(const QVector<LaTeXParserSegment>& segments1, int begin1, int end1,
+                                       const QVector<LaTeXParserSegment>& segments2, int begin2, int end2)
+{
+    QList<const StructureViewItem*> items1, items2;
+    for(int i = begin1; i < end1; ++i) {
+        if(segments1[i].result) {
+            for(const StructureViewItem &item : segments1[i].result->structureViewItems) {
+                items1.append(&item);
+            }
+        }
+    }
+    for(int i = begin2; i < end2; ++i) {
+        if(segments2[i].result) {
+            for(const StructureViewItem &item : segments2[i].result->structureViewItems) {
+                items2.append(&item);
+            }
+        }
+    }
+    if(items1.size() != items2.size()) {
+        return false;
+    }
+    for(int i = 0; i < items1.size(); ++i) {
+        const StructureViewItem *item1 = items1[i], *item2 = items2[i];
+        if(item1->type != item2->type || item1->level != item2->level || item1->title != item2->title
+                || item1->pix != item2->pix || item1->folder != item2->folder) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    QMap<QString,KileStructData>::const_iterator it;
-    static QRegExp reCommand("(\\\\[a-zA-Z]+)\\s*\\*?\\s*(\\{|\\[)");
-    static QRegExp reRoot("\\\\documentclass|\\\\documentstyle");
-    static QRegExp reBD("\\\\begin\\s*\\{\\s*document\\s*\\}");
-    static QRegExp reReNewCommand("\\\\renewcommand.*$");
-    static QRegExp reNumOfParams("\\s*\\[([1-9]+)\\]");
-    static QRegExp reNumOfOptParams("\\s*\\[([1-9]+)\\]\\s*\\[([^\\{]*)\\]"); // the quantifier * isn't used by mistake, because also emtpy optional brackets are correct.
-
-    int tagStart, bd = 0;
-    int tagEnd, tagLine = 0, tagCol = 0;
-    int tagStartLine = 0, tagStartCol = 0;
-    BracketResult result;
-    QString m, s, shorthand;
+// The document is split into segments (see 'LaTeXParserSegment') whose results are cached in a
+// 'LaTeXParserState' object. If the previous state is available, only the segments that contain
+// edited lines are parsed again, and the remaining segments are taken over from the previous state
+// as soon as the parsing is synchronised again with it.
+ParserOutput* LaTeXParser::parse()
+{
+    qCDebug(LOG_KILE_PARSER) << m_textLines.size() << "lines";
+
+    const int lineCount = m_textLines.size();
+    QSharedPointer<LaTeXParserState> state(new LaTeXParserState());
+    state->revision = m_editedLineRange.revision;
+    state->lineCount = lineCount;
+    state->showSectioningLabels = m_showSectioningLabels;
+    state->showStructureTodo = m_showStructureTodo;
+
+    const bool incremental = canParseIncrementally();
+    const QVector<LaTeXParserSegment> previousSegments = (incremental ? m_previousState->segments : QVector<LaTeXParserSegment>());
+    int previousSegmentIndex = 0; // first previous segment that hasn't been taken over or replaced
+    int replacedSegmentsBegin = 0, replacedSegmentsEnd = previousSegments.size();
+    int reparsedSegmentsBegin = 0;
+    int lastEditedLine = -1;
+
+    int i = 0;
     bool foundBD = false; // found \begin { document }
-    bool fire = true; //whether or not we should emit a foundItem signal
-    bool fireSuspended; // found an item, but it should not be fired (this time)
-    TodoResult todo;
 
-// 	emit(parsingStarted(m_doc->lines()));
-    for(int i = 0; i < m_textLines.size(); ++i) {
+    if(incremental) {
+        // an empty range only requires the last segment to be parsed again
+        const int firstEditedLine = m_editedLineRange.isEmpty() ? lineCount : m_editedLineRange.firstLine;
+        lastEditedLine = m_editedLineRange.lastLine;
+        // the last segment is always parsed again as the brackets on it might not have been closed
+        while(previousSegmentIndex < previousSegments.size() - 1
+                && previousSegments[previousSegmentIndex].endLine < firstEditedLine) {
+            state->segments.append(previousSegments[previousSegmentIndex]);
+            ++previousSegmentIndex;
+        }
+        replacedSegmentsBegin = previousSegmentIndex;
+        reparsedSegmentsBegin = state->segments.size();
+        i = previousSegments[previousSegmentIndex].startLine;
+        foundBD = !previousSegments[previousSegmentIndex].startsInPreamble;
+        qCDebug(LOG_KILE_PARSER) << "parsing incrementally from line" << i;
+    }
+
+    while(i < lineCount) {
         if(!m_parserThread->shouldContinueDocumentParsing()) {
             qCDebug(LOG_KILE_PARSER) << "stopping...";
-            delete(parserOutput);
             return Q_NULLPTR;
         }
 
-//		emit(parsingUpdate(i));
+        if(incremental && i > lastEditedLine) {
+            // check whether we can take over the remaining segments of the previous parsing run
+            const int previousLine = i - m_editedLineRange.lineDelta;
+            while(previousSegmentIndex < previousSegments.size()
+                    && previousSegments[previousSegmentIndex].startLine < previousLine) {
+                ++previousSegmentIndex;
+            }
+            if(previousSegmentIndex < previousSegments.size()
+                    && previousSegments[previousSegmentIndex].startLine == previousLine
+                    && previousSegments[previousSegmentIndex].startsInPreamble == !foundBD) {
+                qCDebug(LOG_KILE_PARSER) << "synchronised at line" << i;
+                replacedSegmentsEnd = previousSegmentIndex;
+                for(int j = previousSegmentIndex; j < previousSegments.size(); ++j) {
+                    LaTeXParserSegment segment = previousSegments[j];
+                    segment.startLine += m_editedLineRange.lineDelta;
+                    segment.endLine += m_editedLineRange.lineDelta;
+                    state->segments.append(segment);
+                }
+                break;
+            }
+        }
+
+        LaTeXParserSegment segment;
+        segment.startLine = i;
+        segment.startsInPreamble = !foundBD;
+        LaTeXParserSegmentResult *result = new LaTeXParserSegmentResult();
+        parseSegment(i, foundBD, result);
+        segment.endLine = qMin(i, lineCount - 1);
+        if(result->isEmpty()) {
+            delete result;
+        }
+        else {
+            // make the positions relative to the start of the segment
+            for(StructureViewItem &item : result->structureViewItems) {
+                item.line -= segment.startLine;
+                item.startline -= segment.startLine;
+            }
+            if(result->beginDocumentLine >= 0) {
+                result->beginDocumentLine -= segment.startLine;
+            }
+            segment.result = QSharedPointer<const LaTeXParserSegmentResult>(result);
+        }
+        state->segments.append(segment);
+        ++i;
+    }
+
+    LaTeXParserOutput *parserOutput = createOutput(state);
+    if(incremental) {
+        const int reparsedSegmentsEnd = state->segments.size() - (previousSegments.size() - replacedSegmentsEnd);
+        parserOutput->isIncremental = true;
+        parserOutput->onlyStructurePositionsChanged = haveSameStructureViewItems(previousSegments, replacedSegmentsBegin, replacedSegmentsEnd,
+                                                                                 state->segments, reparsedSegmentsBegin, reparsedSegmentsEnd);
+    }
+
+    qCDebug(LOG_KILE_PARSER) << "done";
+    return parserOutput;
+}
 
-        tagStart = tagEnd = 0;
-        fire = true;
-        s = processTextline(getTextLine(m_textLines, i), todo);
-        if(todo.type != -1 && m_showStructureTodo) {
-            QString folder = (todo.type == KileStruct::ToDo) ? "todo" : "fixme";
-            parserOutput->structureViewItems.push_back(new StructureViewItem(todo.comment, i+1, todo.colComment, todo.type, KileStruct::Object, i+1, todo.colTag, QString(), folder));
+LaTeXParserOutput* LaTeXParser::createOutput(const QSharedPointer<const LaTeXParserState>& state)
+{
+    LaTeXParserOutput *parserOutput = new LaTeXParserOutput();
+    parserOutput->parserState = state;
+
+    for(const LaTeXParserSegment &segment : state->segments) {
+        if(!segment.result) {
+            continue;
+        }
+        const LaTeXParserSegmentResult &result = *segment.result;
+        parserOutput->labels += result.labels;
+        parserOutput->bibItems += result.bibItems;
+        parserOutput->deps += result.deps;
+        parserOutput->bibliography += result.bibliography;
+        parserOutput->packages += result.packages;
+        parserOutput->newCommands += result.newCommands;
+        parserOutput->asyFigures += result.asyFigures;
+        if(result.bIsRoot) {
+            parserOutput->bIsRoot = true;
         }
+        for(const StructureViewItem &item : result.structureViewItems) {
+            parserOutput->structureViewItems.push_back(new StructureViewItem(item.title, item.line + segment.startLine, item.column, item.type, item.level,
+                                                                             item.startline + segment.startLine, item.startcol, item.pix, item.folder));
+        }
+        if(result.beginDocumentLine >= 0) {
+            const int bdLine = segment.startLine + result.beginDocumentLine;
+            for(int j = 0; j < bdLine; ++j) {
+                parserOutput->preamble += getTextLine(m_textLines, j) + '\n';
+            }
+            if(result.beginDocumentColumn > 0) {
+                parserOutput->preamble += getTextLine(m_textLines, bdLine).left(result.beginDocumentColumn) + '\n';
+            }
+        }
+    }
 
+    return parserOutput;
+}
 
-        if(s.isEmpty()) {
+//FIXME: this has to be completely rewritten!
+void LaTeXParser::parseSegment(int &i, bool &foundBD, LaTeXParserSegmentResult *segmentResult)
+{
+    QMap<QString,KileStructData>::const_iterator it;
+    int tagEnd, tagLine = 0, tagCol = 0;
+    int tagStartLine = 0, tagStartCol = 0;
+    BracketResult result;
+    QString m, shorthand;
+    bool fire = true; //whether or not we should emit a foundItem signal
+    bool fireSuspended; // found an item, but it should not be fired (this time)
+    TodoResult todo;
+
+    QString s = getTextLine(m_textLines, i);
+    int lineOfS = i;
+    LaTeXTokenizer tokenizer(s);
+    const int commentPosition = tokenizer.commentPosition();
+    if(m_showStructureTodo && commentPosition >= 0 && LaTeXTokenizer::findTodoComment(s, commentPosition, todo)) {
+        QString folder = (todo.type == KileStruct::ToDo) ? "todo" : "fixme";
+        segmentResult->structureViewItems.append(StructureViewItem(todo.comment, i+1, todo.colComment, todo.type, KileStruct::Object, i+1, todo.colTag, QString(), folder));
+    }
+
+    //find all commands in this line
+    for(LaTeXTokenizer::Token token = tokenizer.nextToken(); token.type != LaTeXTokenizer::EndOfLine; token = tokenizer.nextToken()) {
+        if(token.type != LaTeXTokenizer::ControlSequence) {
             continue;
         }
+        const QStringView command = tokenizer.text(token);
 
         //ignore renewcommands
-        s.remove(reReNewCommand);
+        if(command == QStringView(u"\\renewcommand")) {
+            break;
+        }
 
-        //find all commands in this line
-        while(tagStart != -1) {
-            if((!foundBD) && ((bd = s.indexOf(reBD, tagEnd)) != -1)) {
+        if(!foundBD) {
+            if(tokenizer.isBeginDocument(token)) {
                 qCDebug(LOG_KILE_PARSER) << "\tfound \\begin{document}";
                 foundBD = true;
-                parserOutput->preamble.clear();
-//FIXME: improve this
-                if(bd == 0) {
-                    if(i - 1 >= 0) {
-                        for(int j = 0; j <= i - 1; ++j) {
-                            parserOutput->preamble += getTextLine(m_textLines, j) + '\n';
-                        }
-                    }
-                }
-                else {
-                    if(i - 1 >= 0) {
-                        for(int j = 0; j <= i - 1; ++j) {
-                            parserOutput->preamble += getTextLine(m_textLines, j) + '\n';
-                        }
-                    }
-                    parserOutput->preamble += getTextLine(m_textLines, i).left(bd) + '\n';
-                }
+                // the preamble itself is assembled in 'createOutput'
+                segmentResult->beginDocumentLine = i;
+                segmentResult->beginDocumentColumn = token.position;
             }
-
-            if((!foundBD) && (s.indexOf(reRoot, tagEnd) != -1)) {
+            else if(command == QStringView(u"\\documentclass") || command == QStringView(u"\\documentstyle")) {
                 qCDebug(LOG_KILE_PARSER) << "\tsetting m_bIsRoot to true";
-                tagEnd += reRoot.cap(0).length();
-                parserOutput->bIsRoot = true;
+                segmentResult->bIsRoot = true;
+                continue;
             }
+        }
 
-            tagStart = reCommand.indexIn(s, tagEnd);
-            m.clear();
-            shorthand.clear();
-
-            if(tagStart != -1) {
-                tagEnd = tagStart + reCommand.cap(0).length()-1;
-
-                //look up the command in the dictionary
-                it = m_dictStructLevel.constFind(reCommand.cap(1));
+        const int argumentPosition = tokenizer.argumentPosition(token);
+        if(argumentPosition < 0) {
+            continue;
+        }
+        tagEnd = argumentPosition;
+        m.clear();
+        shorthand.clear();
+
+        //look up the command in the dictionary
+        it = m_commandHash.value(command, m_dictStructLevel.constEnd());
+
+        //if it is was a structure element, find the title (or label)
+        if(it != m_dictStructLevel.constEnd()) {
+            tagLine = i+1;
+            tagCol = tagEnd+1;
+            tagStartLine = tagLine;
+            tagStartCol = token.position+1;
+
+            if(command != QStringView(u"\\frame")) {
+                result = matchBracket(m_textLines, i, tagEnd);
+                m = result.value.trimmed();
+                shorthand = result.option.trimmed();
+                if(i >= tagLine) { //matching brackets spanned multiple lines
+                    s = getTextLine(m_textLines, i);
+                    lineOfS = i;
+                    tokenizer = LaTeXTokenizer(s);
+                }
+                if(result.line > 0 || result.col > 0) {
+                    tagLine = result.line + 1;
+                    tagCol = result.col + 1;
+                }
+                //qCDebug(LOG_KILE_PARSER) << "\tgrabbed: " << command << "[" << shorthand << "]{" << m << "}";
+            }
+            else {
+                m = i18n("Frame");
+            }
+        }
 
-                //if it is was a structure element, find the title (or label)
-                if(it != m_dictStructLevel.constEnd()) {
-                    tagLine = i+1;
-                    tagCol = tagEnd+1;
-                    tagStartLine = tagLine;
-                    tagStartCol = tagStart+1;
+        //title (or label) found, add the element to the listview
+        if(!m.isNull()) {
+            // no problems so far ...
+            fireSuspended = false;
 
-                    if(reCommand.cap(1) != "\\frame") {
+            // remove trailing ./
+            if((*it).type & (KileStruct::Input | KileStruct::Graphics)) {
+                if(m.left(2) == "./") {
+                    m = m.mid(2, m.length() - 2);
+                }
+            }
+            // update parameter for environments, because only
+            // floating environments and beamer frames are passed
+            if ( (*it).type == KileStruct::BeginEnv )
+            {
+                if ( m=="figure" || m=="figure*" || m=="table" || m=="table*" )
+                {
+                    it = m_dictStructLevel.constFind("\\begin{" + m +'}');
+                }
+                else if(m == "asy") {
+                    it = m_dictStructLevel.constFind("\\begin{" + m +'}');
+                    segmentResult->asyFigures.append(m);
+                }
+                else if(m == "frame") {
+                    const QString untitledFrameDisplayName = i18n("Frame");
+                    it = m_dictStructLevel.constFind("\\begin{frame}");
+                    if(tagEnd+1 < s.size() && s.at(tagEnd+1) == '{') {
+                        tagEnd++;
                         result = matchBracket(m_textLines, i, tagEnd);
                         m = result.value.trimmed();
-                        shorthand = result.option.trimmed();
-                        if(i >= tagLine) { //matching brackets spanned multiple lines
-                            s = getTextLine(m_textLines, i);
-                        }
-                        if(result.line > 0 || result.col > 0) {
-                            tagLine = result.line + 1;
-                            tagCol = result.col + 1;
+                        if(m.isEmpty()) {
+                            m = untitledFrameDisplayName;
                         }
-                        //qCDebug(LOG_KILE_PARSER) << "\tgrabbed: " << reCommand.cap(1) << "[" << shorthand << "]{" << m << "}";
                     }
                     else {
-                        m = i18n("Frame");
+                        m = untitledFrameDisplayName;
                     }
                 }
-
-                //title (or label) found, add the element to the listview
-                if(!m.isNull()) {
-                    // no problems so far ...
-                    fireSuspended = false;
-
-                    // remove trailing ./
-                    if((*it).type & (KileStruct::Input | KileStruct::Graphics)) {
-                        if(m.left(2) == "./") {
-                            m = m.mid(2, m.length() - 2);
+                else if(m=="block" || m=="exampleblock" || m=="alertblock") {
+                    const QString untitledBlockDisplayName = i18n("Untitled Block");
+                    it = m_dictStructLevel.constFind("\\begin{block}");
+                    if(tagEnd+1 < s.size() && s.at(tagEnd+1) == '{') {
+                        tagEnd++;
+                        result = matchBracket(m_textLines, i, tagEnd);
+                        m = result.value.trimmed();
+                        if(m.isEmpty()) {
+                            m = untitledBlockDisplayName;
                         }
                     }
-                    // update parameter for environments, because only
-                    // floating environments and beamer frames are passed
-                    if ( (*it).type == KileStruct::BeginEnv )
-                    {
-                        if ( m=="figure" || m=="figure*" || m=="table" || m=="table*" )
-                        {
-                            it = m_dictStructLevel.constFind("\\begin{" + m +'}');
-                        }
-                        else if(m == "asy") {
-                            it = m_dictStructLevel.constFind("\\begin{" + m +'}');
-                            parserOutput->asyFigures.append(m);
-                        }
-                        else if(m == "frame") {
-                            const QString untitledFrameDisplayName = i18n("Frame");
-                            it = m_dictStructLevel.constFind("\\begin{frame}");
-                            if(tagEnd+1 < s.size() && s.at(tagEnd+1) == '{') {
-                                tagEnd++;
-                                result = matchBracket(m_textLines, i, tagEnd);
-                                m = result.value.trimmed();
-                                if(m.isEmpty()) {
-                                    m = untitledFrameDisplayName;
-                                }
-                            }
-                            else {
-                                m = untitledFrameDisplayName;
-                            }
-                        }
-                        else if(m=="block" || m=="exampleblock" || m=="alertblock") {
-                            const QString untitledBlockDisplayName = i18n("Untitled Block");
-                            it = m_dictStructLevel.constFind("\\begin{block}");
-                            if(tagEnd+1 < s.size() && s.at(tagEnd+1) == '{') {
-                                tagEnd++;
-                                result = matchBracket(m_textLines, i, tagEnd);
-                                m = result.value.trimmed();
-                                if(m.isEmpty()) {
-                                    m = untitledBlockDisplayName;
-                                }
-                            }
-                            else {
-                                m = untitledBlockDisplayName;
-                            }
-                        }
-                        else {
-                            fireSuspended = true;    // only floats and beamer frames, no other environments
-                        }
+                    else {
+                        m = untitledBlockDisplayName;
                     }
+                }
+                else {
+                    fireSuspended = true;    // only floats and beamer frames, no other environments
+                }
+            }
 
-                    // tell structure view that a floating environment or a beamer frame must be closed
-                    else if ( (*it).type == KileStruct::EndEnv )
-                    {
-                        if ( m=="figure" || m== "figure*" || m=="table" || m=="table*" || m=="asy")
-                        {
-                            it = m_dictStructLevel.constFind("\\end{float}");
-                        }
-                        else if(m == "frame") {
-                            it = m_dictStructLevel.constFind("\\end{frame}");
-                        }
-                        else {
-                            fireSuspended = true;          // only floats, no other environments
-                        }
-                    }
-                    // sectioning commands
-                    else if((*it).type == KileStruct::Sect) {
-                        if(!shorthand.isEmpty()) {
-                            m = shorthand;
-                        }
-                    }
+            // tell structure view that a floating environment or a beamer frame must be closed
+            else if ( (*it).type == KileStruct::EndEnv )
+            {
+                if ( m=="figure" || m== "figure*" || m=="table" || m=="table*" || m=="asy")
+                {
+                    it = m_dictStructLevel.constFind("\\end{float}");
+                }
+                else if(m == "frame") {
+                    it = m_dictStructLevel.constFind("\\end{frame}");
+                }
+                else {
+                    fireSuspended = true;          // only floats, no other environments
+                }
+            }
+            // sectioning commands
+            else if((*it).type == KileStruct::Sect) {
+                if(!shorthand.isEmpty()) {
+                    m = shorthand;
+                }
+            }
 
-                    // update the label list
-                    else if((*it).type == KileStruct::Label) {
-                        parserOutput->labels.append(m);
-                        // label entry as child of sectioning
-                        if(m_showSectioningLabels) {
-                            parserOutput->structureViewItems.push_back(new StructureViewItem(m, tagLine, tagCol, KileStruct::Label, KileStruct::Object, tagStartLine, tagStartCol, "label", "root"));
-                            fireSuspended = true;
-                        }
-                    }
+            // update the label list
+            else if((*it).type == KileStruct::Label) {
+                segmentResult->labels.append(m);
+                // label entry as child of sectioning
+                if(m_showSectioningLabels) {
+                    segmentResult->structureViewItems.append(StructureViewItem(m, tagLine, tagCol, KileStruct::Label, KileStruct::Object, tagStartLine, tagStartCol, "label", "root"));
+                    fireSuspended = true;
+                }
+            }
 
-                    // update the references list
-                    else if((*it).type == KileStruct::Reference) {
-                        // m_references.append(m);
-                        //fireSuspended = true;          // don't emit references
-                    }
+            // update the references list
+            else if((*it).type == KileStruct::Reference) {
+                // m_references.append(m);
+                //fireSuspended = true;          // don't emit references
+            }
+
+            // update the dependencies
+            else if((*it).type == KileStruct::Input) {
+                // \input- or \include-commands can be used without extension. So we check
+                // if an extension exists. If not the default extension is added
+                // ( LaTeX reference says that this is '.tex'). This assures that
+                // all files, which are listed in the structure view, have an extension.
+                QString ext = QFileInfo(m).completeSuffix();
+                if(ext.isEmpty()) {
+                    m += m_extensions->latexDocumentDefault();
+                }
+                segmentResult->deps.append(m);
+            }
 
-                    // update the dependencies
-                    else if((*it).type == KileStruct::Input) {
-                        // \input- or \include-commands can be used without extension. So we check
-                        // if an extension exists. If not the default extension is added
-                        // ( LaTeX reference says that this is '.tex'). This assures that
-                        // all files, which are listed in the structure view, have an extension.
-                        QString ext = QFileInfo(m).completeSuffix();
+            // update the referenced Bib files
+            else  if((*it).type == KileStruct::Bibliography) {
+                qCDebug(LOG_KILE_PARSER) << "===TeXInfo::updateStruct()===appending Bibiliograph file(s) " << m;
+
+                const QStringList bibs = m.split(',');
+                QString biblio;
+
+                // assure that all files have an extension
+                const QString bibtexExtension = m_extensions->bibtexDefault();
+                for(QString biblio : bibs) {
+                    biblio = biblio.trimmed();
+                    {
+                        QString ext = QFileInfo(biblio).suffix();
                         if(ext.isEmpty()) {
-                            m += m_extensions->latexDocumentDefault();
+                            biblio += m_extensions->bibtexDefault();
                         }
-                        parserOutput->deps.append(m);
                     }
+                    segmentResult->bibliography.append(biblio);
+                    if(biblio.left(2) == "./") {
+                        biblio = biblio.mid(2, biblio.length() - 2);
+                    }
+                    segmentResult->deps.append(biblio);
+                    segmentResult->structureViewItems.append(StructureViewItem(biblio, tagLine, tagCol, (*it).type, (*it).level, tagStartLine, tagStartCol, (*it).pix, (*it).folder));
+                }
+                fire = false;
+            }
 
-                    // update the referenced Bib files
-                    else  if((*it).type == KileStruct::Bibliography) {
-                        qCDebug(LOG_KILE_PARSER) << "===TeXInfo::updateStruct()===appending Bibiliograph file(s) " << m;
-
-                        const QStringList bibs = m.split(',');
-                        QString biblio;
-
-                        // assure that all files have an extension
-                        const QString bibtexExtension = m_extensions->bibtexDefault();
-                        for(QString biblio : bibs) {
-                            biblio = biblio.trimmed();
-                            {
-                                QString ext = QFileInfo(biblio).suffix();
-                                if(ext.isEmpty()) {
-                                    biblio += m_extensions->bibtexDefault();
-                                }
-                            }
-                            parserOutput->bibliography.append(biblio);
-                            if(biblio.left(2) == "./") {
-                                biblio = biblio.mid(2, biblio.length() - 2);
-                            }
-                            parserOutput->deps.append(biblio);
-                            parserOutput->structureViewItems.push_back(new StructureViewItem(biblio, tagLine, tagCol, (*it).type, (*it).level, tagStartLine, tagStartCol, (*it).pix, (*it).folder));
-                        }
-                        fire = false;
+            // update the bibitem list
+            else if((*it).type == KileStruct::BibItem) {
+                //qCDebug(LOG_KILE_PARSER) << "\tappending bibitem " << m;
+                segmentResult->bibItems.append(m);
+            }
+
+            // update the package list
+            else if((*it).type == KileStruct::Package) {
+                QStringList pckgs = m.split(',');
+                uint cumlen = 0;
+                for(int p = 0; p < pckgs.count(); ++p) {
+                    QString package = pckgs[p].trimmed();
+                    if(!package.isEmpty()) {
+                        segmentResult->packages.append(package);
+                        // hidden, so emit is useless
+                        // emit( foundItem(package, tagLine, tagCol+cumlen, (*it).type, (*it).level, tagStartLine, tagStartCol, (*it).pix, (*it).folder) );
+                        cumlen += package.length() + 1;
                     }
+                }
+                fire = false;
+            }
 
-                    // update the bibitem list
-                    else if((*it).type == KileStruct::BibItem) {
-                        //qCDebug(LOG_KILE_PARSER) << "\tappending bibitem " << m;
-                        parserOutput->bibItems.append(m);
+            // newcommand found, add it to the newCommands list
+            else if((*it).type & (KileStruct::NewCommand | KileStruct::NewEnvironment)) {
+                QString optArg, mandArgs;
+
+                //find how many parameters this command takes
+                int noo = 0;
+                bool hasOptArg = false;
+                QStringView optArgValue;
+                if(tokenizer.matchParameterSpecification(tagEnd + 1, noo, hasOptArg, optArgValue)) {
+                    if(hasOptArg) {
+                        qCDebug(LOG_KILE_PARSER) << "Opt param is " << optArgValue << "%EOL";
+                        noo--; // if we have an opt argument, we have one mandatory argument less, and noo=0 can't occur because then latex complains (and we don't match it either)
+                        optArg = '[' + optArgValue.toString() + ']';
                     }
 
-                    // update the package list
-                    else if((*it).type == KileStruct::Package) {
-                        QStringList pckgs = m.split(',');
-                        uint cumlen = 0;
-                        for(int p = 0; p < pckgs.count(); ++p) {
-                            QString package = pckgs[p].trimmed();
-                            if(!package.isEmpty()) {
-                                parserOutput->packages.append(package);
-                                // hidden, so emit is useless
-                                // emit( foundItem(package, tagLine, tagCol+cumlen, (*it).type, (*it).level, tagStartLine, tagStartCol, (*it).pix, (*it).folder) );
-                                cumlen += package.length() + 1;
-                            }
-                        }
-                        fire = false;
+                    for(int noo_index = 0; noo_index < noo; ++noo_index) {
+                        mandArgs +=  '{' + s_bullet + '}';
                     }
 
-                    // newcommand found, add it to the newCommands list
-                    else if((*it).type & (KileStruct::NewCommand | KileStruct::NewEnvironment)) {
-                        QString optArg, mandArgs;
-
-                        //find how many parameters this command takes
-                        if(s.indexOf(reNumOfParams, tagEnd + 1) != -1) {
-                            bool ok;
-                            int noo = reNumOfParams.cap(1).toInt(&ok);
-
-                            if(ok) {
-                                if(s.indexOf(reNumOfOptParams, tagEnd + 1) != -1) {
-                                    qCDebug(LOG_KILE_PARSER) << "Opt param is " << reNumOfOptParams.cap(2) << "%EOL";
-                                    noo--; // if we have an opt argument, we have one mandatory argument less, and noo=0 can't occur because then latex complains (and we don't macht them with reNumOfParams either)
-                                    optArg = '[' + reNumOfOptParams.cap(2) + ']';
-                                }
-
-                                for(int noo_index = 0; noo_index < noo; ++noo_index) {
-                                    mandArgs +=  '{' + s_bullet + '}';
-                                }
-
-                            }
-                            if(!optArg.isEmpty()) {
-                                if((*it).type == KileStruct::NewEnvironment) {
-                                    parserOutput->newCommands.append(QString("\\begin{%1}%2%3").arg(m).arg(optArg).arg(mandArgs));
-                                }
-                                else {
-                                    parserOutput->newCommands.append(m + optArg + mandArgs);
-                                }
-                            }
-                        }
+                    if(!optArg.isEmpty()) {
                         if((*it).type == KileStruct::NewEnvironment) {
-                            parserOutput->newCommands.append(QString("\\begin{%1}%3").arg(m).arg(mandArgs));
-                            parserOutput->newCommands.append(QString("\\end{%1}").arg(m));
+                            segmentResult->newCommands.append(QString("\\begin{%1}%2%3").arg(m).arg(optArg).arg(mandArgs));
                         }
                         else {
-                            parserOutput->newCommands.append(m + mandArgs);
+                            segmentResult->newCommands.append(m + optArg + mandArgs);
                         }
-                        //FIXME  set tagEnd to the end of the command definition
-                        break;
                     }
-                    // and some other commands, which don't need special actions:
-                    // \caption, ...
+                }
+                if((*it).type == KileStruct::NewEnvironment) {
+                    segmentResult->newCommands.append(QString("\\begin{%1}%3").arg(m).arg(mandArgs));
+                    segmentResult->newCommands.append(QString("\\end{%1}").arg(m));
+                }
+                else {
+                    segmentResult->newCommands.append(m + mandArgs);
+                }
+                //FIXME  set tagEnd to the end of the command definition
+                break;
+            }
+            // and some other commands, which don't need special actions:
+            // \caption, ...
 
-                    // qCDebug(LOG_KILE_PARSER) << "\t\temitting: " << m;
-                    if(fire && !fireSuspended) {
-                        parserOutput->structureViewItems.push_back(new StructureViewItem(m, tagLine, tagCol, (*it).type, (*it).level, tagStartLine, tagStartCol, (*it).pix, (*it).folder));
-                    }
-                } //if m
-            } // if tagStart
-        } // while tagStart
-    } //for
+            // qCDebug(LOG_KILE_PARSER) << "\t\temitting: " << m;
+            if(fire && !fireSuspended) {
+                segmentResult->structureViewItems.append(StructureViewItem(m, tagLine, tagCol, (*it).type, (*it).level, tagStartLine, tagStartCol, (*it).pix, (*it).folder));
+            }
+        } //if m
 
-    qCDebug(LOG_KILE_PARSER) << "done";
-    return parserOutput;
+        // continue after the arguments that have been consumed, which might end on another line
+        if(i != lineOfS) {
+            s = getTextLine(m_textLines, i);
+            lineOfS = i;
+            tokenizer = LaTeXTokenizer(s, tagEnd);
+        }
+        else {
+            tokenizer.setPosition(tagEnd);
+        }
+    }
 }
 
 
@@ -14,7 +14,11 @@
 #ifndef LATEXPARSER_H
 #define LATEXPARSER_H
 
+#include <QHash>
 #include <QLinkedList>
+#include <QSharedPointer>
+#include <QStringView>
+#include <QVector>
 
 #include "documentinfo.h"
 #include "kileconstants.h"
@@ -30,20 +34,79 @@ struct BracketResult
     int line, col;
 };
 
+/**
+ * The results that have been found in a segment of a LaTeX document. A segment starts at
+ * a line on which the parser begins to scan for commands and ends at the last line that has
+ * been consumed while matching brackets, which might span several lines.
+ * The line numbers of the structure view items are relative to the start of the segment.
+ **/
+class LaTeXParserSegmentResult
+{
+public:
+    LaTeXParserSegmentResult();
+
+    bool isEmpty() const;
+
+    QStringList labels;
+    QStringList bibItems;
+    QStringList deps;
+    QStringList bibliography;
+    QStringList packages;
+    QStringList newCommands;
+    QStringList asyFigures;
+    QList<StructureViewItem> structureViewItems;
+    bool bIsRoot;
+    // position of '\begin{document}' relative to the start of the segment, or -1
+    int beginDocumentLine;
+    int beginDocumentColumn;
+};
+
+class LaTeXParserSegment
+{
+public:
+    LaTeXParserSegment() : startLine(0), endLine(0), startsInPreamble(true) {}
+
+    int startLine;
+    int endLine;
+    bool startsInPreamble;
+    // Q_NULLPTR if nothing has been found in this segment
+    QSharedPointer<const LaTeXParserSegmentResult> result;
+};
+
+/**
+ * The cached per-segment results of a parsing run, which allow to only re-parse
+ * the edited lines of the next revision of the document.
+ **/
+class LaTeXParserState
+{
+public:
+    LaTeXParserState() : revision(0), lineCount(0), showSectioningLabels(false), showStructureTodo(false) {}
+
+    quint64 revision;
+    int lineCount;
+    bool showSectioningLabels;
+    bool showStructureTodo;
+    QVector<LaTeXParserSegment> segments;
+};
+
 class LaTeXParserInput : public ParserInput
 {
 public:
-    LaTeXParserInput(const QUrl &url, QStringList textLines,
+    LaTeXParserInput(const QUrl &url, const KileDocument::DocumentSnapshot& textLines,
                      KileDocument::Extensions *extensions,
                      const QMap<QString, KileStructData>& dictStructLevel,
                      bool showSectioningLabels,
-                     bool showStructureTodo);
+                     bool showStructureTodo,
+                     const KileDocument::EditedLineRange& editedLineRange = KileDocument::EditedLineRange());
 
-    QStringList textLines;
+    KileDocument::DocumentSnapshot textLines;
     KileDocument::Extensions *extensions;
     const QMap<QString, KileStructData> dictStructLevel;
     bool showSectioningLabels;
     bool showStructureTodo;
+    KileDocument::EditedLineRange editedLineRange;
+    // set by the parser thread if the results of the previous revision are available
+    QSharedPointer<const LaTeXParserState> previousState;
 };
 
 class LaTeXParserOutput : public ParserOutput {
@@ -60,6 +123,10 @@ public:
     QStringList asyFigures;
     QString preamble;
     bool bIsRoot;
+    // true if only the edited lines have been parsed again
+    bool isIncremental;
+    // only used by the parser thread
+    QSharedPointer<const LaTeXParserState> parserState;
 };
 
 
@@ -76,12 +143,24 @@ public:
 
 protected:
     KileDocument::Extensions *m_extensions;
-    QStringList m_textLines;
+    KileDocument::DocumentSnapshot m_textLines;
     const QMap<QString, KileStructData>& m_dictStructLevel;
     bool m_showSectioningLabels;
     bool m_showStructureTodo;
+    KileDocument::EditedLineRange m_editedLineRange;
+    QSharedPointer<const LaTeXParserState> m_previousState;
+
+    // maps the commands in 'm_dictStructLevel' to their entries
+    QHash<QStringView, QMap<QString, KileStructData>::const_iterator> m_commandHash;
+
+    BracketResult matchBracket(const KileDocument::DocumentSnapshot& textLines, int &l, int &pos);
 
-    BracketResult matchBracket(const QStringList& textLines, int &l, int &pos);
+    bool canParseIncrementally() const;
+    /**
+     * Parses the segment starting at line 'i', which is set to the last line of the segment.
+     **/
+    void parseSegment(int &i, bool &foundBD, LaTeXParserSegmentResult *result);
+    LaTeXParserOutput* createOutput(const QSharedPointer<const LaTeXParserState>& state);
 };
 
 }
@@ -0,0 +1,261 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "latextokenizer.h"
+
+#include "documentinfo.h"
+#include "parser.h"
+
+namespace KileParser {
+
+namespace {
+
+inline bool isAsciiLetter(QChar c)
+{
+    const ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z');
+}
+
+inline bool isWordCharacter(QChar c)
+{
+    return c.isLetterOrNumber() || c.isMark() || c == QLatin1Char('_');
+}
+
+inline bool isSpecialCharacter(QChar c)
+{
+    switch(c.unicode()) {
+    case '\\':
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// returns the length of 'tag' if it occurs as a whole word at 'position' in 'line', and 0 otherwise
+int matchWord(QStringView line, int position, QStringView tag)
+{
+    const int end = position + tag.size();
+    if(end > line.size() || line.mid(position, tag.size()) != tag) {
+        return 0;
+    }
+    if((position > 0 && isWordCharacter(line.at(position - 1))) || (end < line.size() && isWordCharacter(line.at(end)))) {
+        return 0;
+    }
+    return tag.size();
+}
+
+}
+
+LaTeXTokenizer::LaTeXTokenizer(QStringView line, int position)
+    : m_line(line),
+      m_codeLength(codeLength(line)),
+      m_position(0)
+{
+    setPosition(position);
+}
+
+void LaTeXTokenizer::setPosition(int position)
+{
+    m_position = qBound(0, position, m_codeLength);
+}
+
+LaTeXTokenizer::Token LaTeXTokenizer::nextToken()
+{
+    if(m_position >= m_codeLength) {
+        return Token(EndOfLine, m_codeLength, 0);
+    }
+
+    const int start = m_position;
+    const QChar c = m_line.at(start);
+    switch(c.unicode()) {
+    case '\\': {
+        int end = start + 1;
+        if(end < m_codeLength && isAsciiLetter(m_line.at(end))) {
+            while(end < m_codeLength && isAsciiLetter(m_line.at(end))) {
+                ++end;
+            }
+            m_position = end;
+            return Token(ControlSequence, start, end - start);
+        }
+        // a trailing backslash is returned as a control symbol of length one
+        m_position = qMin(end + 1, m_codeLength);
+        return Token(ControlSymbol, start, m_position - start);
+    }
+    case '{':
+        ++m_position;
+        return Token(OpeningBrace, start, 1);
+    case '}':
+        ++m_position;
+        return Token(ClosingBrace, start, 1);
+    case '[':
+        ++m_position;
+        return Token(OpeningBracket, start, 1);
+    case ']':
+        ++m_position;
+        return Token(ClosingBracket, start, 1);
+    default:
+        break;
+    }
+
+    int end = start + 1;
+    while(end < m_codeLength && !isSpecialCharacter(m_line.at(end))) {
+        ++end;
+    }
+    m_position = end;
+    return Token(Text, start, end - start);
+}
+
+int LaTeXTokenizer::skipWhitespace(int position) const
+{
+    while(position < m_codeLength && m_line.at(position).isSpace()) {
+        ++position;
+    }
+    return position;
+}
+
+int LaTeXTokenizer::argumentPosition(const Token &token) const
+{
+    int position = skipWhitespace(token.position + token.length);
+    if(position < m_codeLength && m_line.at(position) == QLatin1Char('*')) {
+        position = skipWhitespace(position + 1);
+    }
+    if(position < m_codeLength && (m_line.at(position) == QLatin1Char('{') || m_line.at(position) == QLatin1Char('['))) {
+        return position;
+    }
+    return -1;
+}
+
+int LaTeXTokenizer::indexOf(QChar c, int position) const
+{
+    for(int i = qMax(0, position); i < m_codeLength; ++i) {
+        if(m_line.at(i) == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool LaTeXTokenizer::isBeginDocument(const Token &token) const
+{
+    if(token.type != ControlSequence || text(token) != QStringView(u"\\begin")) {
+        return false;
+    }
+    int position = skipWhitespace(token.position + token.length);
+    if(position >= m_codeLength || m_line.at(position) != QLatin1Char('{')) {
+        return false;
+    }
+    position = skipWhitespace(position + 1);
+    const QStringView document(u"document");
+    if(position + document.size() > m_codeLength || m_line.mid(position, document.size()) != document) {
+        return false;
+    }
+    position = skipWhitespace(position + document.size());
+    return (position < m_codeLength && m_line.at(position) == QLatin1Char('}'));
+}
+
+bool LaTeXTokenizer::matchParameterSpecification(int position, int &numberOfParameters, bool &hasDefaultValue,
+                                                 QStringView &defaultValue) const
+{
+    position = skipWhitespace(position);
+    if(position >= m_codeLength || m_line.at(position) != QLatin1Char('[')) {
+        return false;
+    }
+    ++position;
+    int number = 0;
+    int digitCount = 0;
+    for(; position < m_codeLength; ++position, ++digitCount) {
+        const ushort u = m_line.at(position).unicode();
+        if(u < '1' || u > '9') {
+            break;
+        }
+        number = 10 * number + (u - '0');
+    }
+    if(digitCount == 0 || position >= m_codeLength || m_line.at(position) != QLatin1Char(']')) {
+        return false;
+    }
+    numberOfParameters = number;
+
+    // the default value extends up to the last ']' in front of the next '{'
+    hasDefaultValue = false;
+    position = skipWhitespace(position + 1);
+    if(position < m_codeLength && m_line.at(position) == QLatin1Char('[')) {
+        const int valueStart = position + 1;
+        int valueEnd = -1;
+        for(int i = valueStart; i < m_codeLength && m_line.at(i) != QLatin1Char('{'); ++i) {
+            if(m_line.at(i) == QLatin1Char(']')) {
+                valueEnd = i;
+            }
+        }
+        if(valueEnd >= 0) {
+            hasDefaultValue = true;
+            defaultValue = m_line.mid(valueStart, valueEnd - valueStart);
+        }
+    }
+    return true;
+}
+
+int LaTeXTokenizer::codeLength(QStringView line)
+{
+    const int length = line.size();
+    for(int i = 0; i < length; ++i) {
+        const QChar c = line.at(i);
+        if(c == QLatin1Char('\\')) {
+            ++i; // skip the escaped character
+        }
+        else if(c == QLatin1Char('%')) {
+            return i;
+        }
+    }
+    return length;
+}
+
+bool LaTeXTokenizer::findTodoComment(QStringView line, int position, TodoResult &todo)
+{
+    static const QStringView todoTag(u"TODO");
+    static const QStringView fixmeTag(u"FIXME");
+
+    const int length = line.size();
+    for(int i = qMax(0, position); i < length; ++i) {
+        int tagLength = 0;
+        const QChar c = line.at(i);
+        if(c == QLatin1Char('T')) {
+            tagLength = matchWord(line, i, todoTag);
+        }
+        else if(c == QLatin1Char('F')) {
+            tagLength = matchWord(line, i, fixmeTag);
+        }
+        if(tagLength == 0) {
+            continue;
+        }
+
+        int commentStart = i + tagLength;
+        if(commentStart < length && (line.at(commentStart) == QLatin1Char(':') || line.at(commentStart).isSpace())) {
+            ++commentStart;
+        }
+        while(commentStart < length && line.at(commentStart).isSpace()) {
+            ++commentStart;
+        }
+        todo.type = (c == QLatin1Char('T')) ? KileStruct::ToDo : KileStruct::FixMe;
+        todo.colTag = i;
+        todo.colComment = commentStart;
+        todo.comment = line.mid(commentStart).trimmed().toString();
+        return true;
+    }
+    return false;
+}
+
+}
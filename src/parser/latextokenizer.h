@@ -0,0 +1,136 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LATEXTOKENIZER_H
+#define LATEXTOKENIZER_H
+
+#include <QStringView>
+
+namespace KileParser {
+
+struct TodoResult;
+
+/**
+ * Splits a line of LaTeX source code into tokens in a single pass without allocating any memory.
+ * The comment of the line, i.e. everything starting from the first '%' that isn't escaped, is
+ * not part of the code that is tokenized; escaped characters like "\\", "\%" or "\{" are returned
+ * as control symbols.
+ * The line that is passed to the constructor has to outlive the tokenizer.
+ **/
+class LaTeXTokenizer
+{
+public:
+    enum TokenType {
+        EndOfLine = 0,
+        ControlSequence,  // '\' followed by letters, e.g. "\section"
+        ControlSymbol,    // '\' followed by any other character, e.g. "\\" or "\{"
+        OpeningBrace,
+        ClosingBrace,
+        OpeningBracket,
+        ClosingBracket,
+        Text              // any other characters
+    };
+
+    struct Token {
+        Token() : type(EndOfLine), position(0), length(0) {}
+        Token(TokenType type, int position, int length) : type(type), position(position), length(length) {}
+
+        TokenType type;
+        int position;
+        int length;
+    };
+
+    explicit LaTeXTokenizer(QStringView line, int position = 0);
+
+    QStringView line() const {
+        return m_line;
+    }
+
+    /**
+     * Returns the line without its comment.
+     **/
+    QStringView code() const {
+        return m_line.left(m_codeLength);
+    }
+
+    /**
+     * Returns the position of the '%' that starts the comment, or -1 if there is no comment.
+     **/
+    int commentPosition() const {
+        return (m_codeLength < m_line.size()) ? m_codeLength : -1;
+    }
+
+    int position() const {
+        return m_position;
+    }
+
+    void setPosition(int position);
+
+    Token nextToken();
+
+    QStringView text(const Token &token) const {
+        return m_line.mid(token.position, token.length);
+    }
+
+    /**
+     * Returns the position of the first character of the code at or after 'position' that isn't
+     * whitespace; the length of the code is returned if there is no such character.
+     **/
+    int skipWhitespace(int position) const;
+
+    /**
+     * Returns the position of the '{' or '[' that opens the first argument of the control sequence
+     * 'token', or -1 if the control sequence isn't followed by an argument. Whitespace and
+     * a star between the control sequence and its argument are skipped.
+     **/
+    int argumentPosition(const Token &token) const;
+
+    /**
+     * Returns the position of the first occurrence of 'c' in the code at or after 'position',
+     * or -1 if there is none.
+     **/
+    int indexOf(QChar c, int position) const;
+
+    /**
+     * Returns true if 'token' is the beginning of "\begin{document}".
+     **/
+    bool isBeginDocument(const Token &token) const;
+
+    /**
+     * Checks whether the number of parameters of a new command, e.g. "[2]", and optionally
+     * the default value of the first parameter, e.g. "[2][x]", follow on 'position' after
+     * skipping whitespace.
+     **/
+    bool matchParameterSpecification(int position, int &numberOfParameters, bool &hasDefaultValue,
+                                     QStringView &defaultValue) const;
+
+    /**
+     * Returns the position of the first unescaped '%' in 'line', or the length of 'line' if there
+     * is no comment.
+     **/
+    static int codeLength(QStringView line);
+
+    /**
+     * Searches for a "TODO" or "FIXME" tag in 'line', starting at 'position', and fills in 'todo'.
+     **/
+    static bool findTodoComment(QStringView line, int position, TodoResult &todo);
+
+private:
+    QStringView m_line;
+    int m_codeLength;
+    int m_position;
+};
+
+}
+
+#endif
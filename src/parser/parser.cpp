@@ -17,6 +17,7 @@
 
 #include <QStringList>
 
+#include "latextokenizer.h"
 #include "parserthread.h"
 
 namespace KileParser {
@@ -40,7 +41,8 @@ StructureViewItem::~StructureViewItem()
 }
 
 ParserInput::ParserInput(const QUrl &url)
-    : url(url)
+    : url(url),
+      isSaved(false)
 {
 }
 
@@ -48,6 +50,11 @@ ParserInput::~ParserInput()
 {
 }
 
+ParserOutput::ParserOutput()
+    : onlyStructurePositionsChanged(false)
+{
+}
+
 ParserOutput::~ParserOutput()
 {
     Q_FOREACH(StructureViewItem *item, structureViewItems) {
@@ -65,47 +72,9 @@ Parser::~Parser()
 {
 }
 
-QString Parser::processTextline(const QString &line, TodoResult &todo)
-{
-    static QRegExp reComments("[^\\\\](%.*$)");
-    QString s = line;
-    todo.type = -1;
-    if(!s.isEmpty()) {
-        // remove comment lines
-        if(s[0] == '%') {
-            searchTodoComment(s,0,todo);
-            s.clear();
-        }
-        else {
-            //remove escaped \ characters
-            s.replace("\\\\", "  ");
-
-            //remove comments
-            int pos = s.indexOf(reComments);
-            if(pos != -1) {
-                searchTodoComment(s, pos,todo);
-                s = s.left(reComments.pos(1));
-            }
-        }
-    }
-    return s;
-}
-
-void Parser::searchTodoComment(const QString &s, uint startpos, TodoResult &todo)
-{
-    static QRegExp reTodoComment("\\b(TODO|FIXME)\\b(:|\\s)?\\s*(.*)");
-
-    if(s.indexOf(reTodoComment, startpos) != -1) {
-        todo.type = (reTodoComment.cap(1) == "TODO") ? KileStruct::ToDo : KileStruct::FixMe;
-        todo.colTag = reTodoComment.pos(1);
-        todo.colComment = reTodoComment.pos(3);
-        todo.comment = reTodoComment.cap(3).trimmed();
-    }
-}
-
 // match a { with the corresponding }
 // pos is the position of the {
-QString Parser::matchBracket(const QStringList& textLines, QChar obracket, int &l, int &pos)
+QString Parser::matchBracket(const KileDocument::DocumentSnapshot& textLines, QChar obracket, int &l, int &pos)
 {
     QChar cbracket;
     if(obracket == '{') {
@@ -118,30 +87,41 @@ QString Parser::matchBracket(const QStringList& textLines, QChar obracket, int &
         cbracket = ')';
     }
 
-    QString line, grab = "";
-    int count=0, len;
+    QString grab = "";
+    int count = 0;
     ++pos;
 
-    TodoResult todo;
     while(l < textLines.size()) {
-        line = processTextline(textLines[l], todo);
-        len = line.length();
-        for (int i = pos; i < len; ++i) {
-            if(line[i] == '\\' && (line[i+1] == obracket || line[i+1] == cbracket)) {
-                ++i;
+        const QString& line = textLines[l];
+        // comments are not taken into account
+        const int len = LaTeXTokenizer::codeLength(line);
+        for(int i = pos; i < len; ++i) {
+            const QChar c = line[i];
+            if(c == '\\' && i + 1 < len) {
+                const QChar next = line[i + 1];
+                if(next == '\\') { // escaped backslashes are replaced by spaces
+                    grab += QLatin1String("  ");
+                    ++i;
+                    continue;
+                }
+                else if(next == obracket || next == cbracket) {
+                    grab += next;
+                    ++i;
+                    continue;
+                }
             }
-            else if(line[i] == obracket) {
+            else if(c == obracket) {
                 ++count;
             }
-            else if(line[i] == cbracket) {
+            else if(c == cbracket) {
                 --count;
-                if (count < 0) {
+                if(count < 0) {
                     pos = i;
                     return grab;
                 }
             }
 
-            grab += line[i];
+            grab += c;
         }
         ++l;
         pos = 0;
@@ -150,7 +130,7 @@ QString Parser::matchBracket(const QStringList& textLines, QChar obracket, int &
     return QString();
 }
 
-QString Parser::getTextLine(const QStringList& textLines, int line)
+QString Parser::getTextLine(const KileDocument::DocumentSnapshot& textLines, int line)
 {
     if(line < 0 || line >= textLines.size()) {
         return QString();
@@ -19,6 +19,8 @@
 
 #include <QUrl>
 
+#include "documentsnapshot.h"
+
 class KileInfo;
 
 namespace KileDocument {
@@ -61,13 +63,19 @@ public:
     virtual ~ParserInput();
 
     QUrl url;
+    // whether the input is the same as the contents of the file on disk
+    bool isSaved;
 };
 
 class ParserOutput {
 public:
+    ParserOutput();
     virtual ~ParserOutput();
 
     QLinkedList<StructureViewItem*> structureViewItems;
+    // true if 'structureViewItems' only differs from the items of the previous
+    // parsing run in the positions of the items
+    bool onlyStructurePositionsChanged;
 };
 
 class Parser : public QObject
@@ -83,12 +91,10 @@ public:
 protected:
     ParserThread *m_parserThread;
 
-    QString processTextline(const QString &line, TodoResult &todo);
-    void searchTodoComment(const QString &s, uint startpos, TodoResult &todo);
-    QString matchBracket(const QStringList& textLines, QChar obracket, int &l, int &pos);
+    QString matchBracket(const KileDocument::DocumentSnapshot& textLines, QChar obracket, int &l, int &pos);
     // for now, we have to emulate the behaviour of 'KTextEditor::Document::line':
     // we return an empty string if the given line number is invalid
-    QString getTextLine(const QStringList& textLines, int line);
+    QString getTextLine(const KileDocument::DocumentSnapshot& textLines, int line);
 };
 
 }
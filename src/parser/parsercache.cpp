@@ -0,0 +1,246 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "parsercache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "bibtexparser.h"
+#include "kiledebug.h"
+#include "latexparser.h"
+#include "utilities.h"
+
+// increase this number whenever the parsers produce different results or the format changes
+#define PARSER_CACHE_VERSION 3
+
+namespace KileParser {
+
+namespace {
+
+const quint32 parserCacheMagic = 0x4b505243; // "KPRC"
+// entries that haven't been written for this number of days are deleted
+const int maximumEntryAge = 90;
+
+enum CachedOutputType { LaTeXOutput = 0, BibTeXOutput };
+
+void addStringToHash(QCryptographicHash &hash, const QString& s)
+{
+    hash.addData(reinterpret_cast<const char*>(s.constData()), s.length() * sizeof(QChar));
+    hash.addData("\n", 1);
+}
+
+void writeStructureViewItems(QDataStream &stream, const QLinkedList<StructureViewItem*>& items)
+{
+    stream << qint32(items.size());
+    Q_FOREACH(const StructureViewItem *item, items) {
+        stream << item->title << item->line << item->column << qint32(item->type) << qint32(item->level)
+               << item->startline << item->startcol << item->pix << item->folder;
+    }
+}
+
+bool readStructureViewItems(QDataStream &stream, QLinkedList<StructureViewItem*>& items)
+{
+    qint32 count = 0;
+    stream >> count;
+    for(qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString title, pix, folder;
+        uint line, column, startline, startcol;
+        qint32 type, level;
+        stream >> title >> line >> column >> type >> level >> startline >> startcol >> pix >> folder;
+        items.push_back(new StructureViewItem(title, line, column, type, level, startline, startcol, pix, folder));
+    }
+    return (stream.status() == QDataStream::Ok);
+}
+
+}
+
+ParserCache::ParserCache()
+    : m_directory(KileUtilities::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/parsercache"))
+{
+}
+
+ParserCache::~ParserCache()
+{
+}
+
+QString ParserCache::fileNameFor(const QUrl &url) const
+{
+    const QByteArray urlHash = QCryptographicHash::hash(url.toString().toUtf8(), QCryptographicHash::Sha1);
+    return m_directory + '/' + QString::fromLatin1(urlHash.toHex());
+}
+
+QByteArray ParserCache::keyFor(const ParserInput *input)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const KileDocument::DocumentSnapshot *textLines = Q_NULLPTR;
+
+    if(const LaTeXParserInput *latexInput = dynamic_cast<const LaTeXParserInput*>(input)) {
+        // the results also depend on the settings of the parser
+        hash.addData(latexInput->showSectioningLabels ? "1" : "0", 1);
+        hash.addData(latexInput->showStructureTodo ? "1" : "0", 1);
+        addStringToHash(hash, latexInput->extensions->latexDocumentDefault());
+        addStringToHash(hash, latexInput->extensions->bibtexDefault());
+        for(QMap<QString, KileStructData>::const_iterator it = latexInput->dictStructLevel.constBegin();
+                it != latexInput->dictStructLevel.constEnd(); ++it) {
+            addStringToHash(hash, it.key());
+            addStringToHash(hash, QString::number(it->level) + ',' + QString::number(it->type));
+            addStringToHash(hash, it->pix);
+            addStringToHash(hash, it->folder);
+        }
+        textLines = &latexInput->textLines;
+    }
+    else if(const BibTeXParserInput *bibtexInput = dynamic_cast<const BibTeXParserInput*>(input)) {
+        textLines = &bibtexInput->textLines;
+    }
+    else {
+        return QByteArray();
+    }
+
+    hash.addData("\f", 1);
+    addStringToHash(hash, QString::number(textLines->size()));
+    // unlike 'DocumentSnapshot::hash()', this doesn't depend on the edits of the document
+    hash.addData(textLines->contentHash());
+    return hash.result();
+}
+
+ParserOutput* ParserCache::lookup(const ParserInput *input, const QByteArray& key) const
+{
+    if(key.isEmpty()) {
+        return Q_NULLPTR;
+    }
+    QFile file(fileNameFor(input->url));
+    if(!file.open(QIODevice::ReadOnly)) {
+        return Q_NULLPTR;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic = 0, version = 0;
+    QUrl url;
+    QByteArray storedKey;
+    qint32 type = -1;
+    stream >> magic >> version;
+    if(magic != parserCacheMagic || version != PARSER_CACHE_VERSION) {
+        qCDebug(LOG_KILE_PARSER) << "ignoring cache entry with wrong version for" << input->url;
+        return Q_NULLPTR;
+    }
+    stream >> url >> storedKey >> type;
+    if(stream.status() != QDataStream::Ok || url != input->url || storedKey != key) {
+        return Q_NULLPTR;
+    }
+
+    ParserOutput *output = Q_NULLPTR;
+    if(type == LaTeXOutput && dynamic_cast<const LaTeXParserInput*>(input)) {
+        LaTeXParserOutput *latexOutput = new LaTeXParserOutput();
+        stream >> latexOutput->labels >> latexOutput->bibItems >> latexOutput->deps
+               >> latexOutput->bibliography >> latexOutput->packages >> latexOutput->newCommands
+               >> latexOutput->asyFigures >> latexOutput->preamble >> latexOutput->bIsRoot;
+        output = latexOutput;
+    }
+    else if(type == BibTeXOutput && dynamic_cast<const BibTeXParserInput*>(input)) {
+        BibTeXParserOutput *bibtexOutput = new BibTeXParserOutput();
+        stream >> bibtexOutput->bibItems;
+        output = bibtexOutput;
+    }
+    else {
+        return Q_NULLPTR;
+    }
+
+    if(!readStructureViewItems(stream, output->structureViewItems)) {
+        qCDebug(LOG_KILE_PARSER) << "corrupted cache entry for" << input->url;
+        delete output;
+        return Q_NULLPTR;
+    }
+    qCDebug(LOG_KILE_PARSER) << "using cached results for" << input->url;
+    return output;
+}
+
+void ParserCache::store(const ParserInput *input, const QByteArray& key, const ParserOutput *output)
+{
+    if(key.isEmpty() || !output) {
+        return;
+    }
+    const LaTeXParserOutput *latexOutput = dynamic_cast<const LaTeXParserOutput*>(output);
+    const BibTeXParserOutput *bibtexOutput = dynamic_cast<const BibTeXParserOutput*>(output);
+    if(!latexOutput && !bibtexOutput) {
+        return;
+    }
+    if(!QDir().mkpath(m_directory)) {
+        qCDebug(LOG_KILE_PARSER) << "cannot create" << m_directory;
+        return;
+    }
+
+    QSaveFile file(fileNameFor(input->url));
+    if(!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    stream << parserCacheMagic << quint32(PARSER_CACHE_VERSION) << input->url << key;
+    if(latexOutput) {
+        stream << qint32(LaTeXOutput)
+               << latexOutput->labels << latexOutput->bibItems << latexOutput->deps
+               << latexOutput->bibliography << latexOutput->packages << latexOutput->newCommands
+               << latexOutput->asyFigures << latexOutput->preamble << latexOutput->bIsRoot;
+    }
+    else {
+        stream << qint32(BibTeXOutput) << bibtexOutput->bibItems;
+    }
+    writeStructureViewItems(stream, output->structureViewItems);
+
+    if(stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+    }
+    if(!file.commit()) {
+        qCDebug(LOG_KILE_PARSER) << "cannot write cache entry for" << input->url;
+    }
+}
+
+void ParserCache::removeStaleEntries()
+{
+    const QDateTime oldestModificationTime = QDateTime::currentDateTime().addDays(-maximumEntryAge);
+    const QFileInfoList entries = QDir(m_directory).entryInfoList(QDir::Files);
+    for(const QFileInfo& entry : entries) {
+        bool stale = (entry.lastModified() < oldestModificationTime);
+        if(!stale) {
+            QFile file(entry.absoluteFilePath());
+            if(!file.open(QIODevice::ReadOnly)) {
+                continue;
+            }
+            QDataStream stream(&file);
+            stream.setVersion(QDataStream::Qt_5_6);
+            quint32 magic = 0, version = 0;
+            QUrl url;
+            stream >> magic >> version;
+            if(magic == parserCacheMagic && version == PARSER_CACHE_VERSION) {
+                stream >> url;
+            }
+            // entries of older versions are never used again either
+            stale = (stream.status() != QDataStream::Ok || !url.isValid()
+                     || (url.isLocalFile() && !QFile::exists(url.toLocalFile())));
+        }
+        if(stale) {
+            qCDebug(LOG_KILE_PARSER) << "removing stale cache entry" << entry.fileName();
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
+
+}
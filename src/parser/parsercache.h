@@ -0,0 +1,77 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PARSERCACHE_H
+#define PARSERCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+
+namespace KileParser {
+
+class ParserInput;
+class ParserOutput;
+
+/**
+ * Stores the results of document parsing runs on disk, so that the files of a project don't
+ * have to be parsed again when the project is reopened in a later session.
+ *
+ * There is one entry per file, which is keyed by the URL of the file, a hash of the parsed
+ * contents and a hash of the parser settings. The entries are only valid for the cache
+ * format version they have been written with, i.e. 'PARSER_CACHE_VERSION' has to be
+ * increased whenever the output of the document parsers changes.
+ *
+ * The methods of this class can be called from several threads at the same time as long
+ * as they are not called for the same URL concurrently.
+ **/
+class ParserCache
+{
+public:
+    /**
+     * Uses the directory 'parsercache' in the cache location of the application.
+     **/
+    ParserCache();
+    ~ParserCache();
+
+    /**
+     * Computes the key under which the output of parsing 'input' is stored; an empty key
+     * is returned if the results of 'input' cannot be cached.
+     **/
+    static QByteArray keyFor(const ParserInput *input);
+
+    /**
+     * Returns the stored output for 'input' if there is a valid entry for the URL of 'input'
+     * whose key is equal to 'key', or Q_NULLPTR otherwise.
+     * The ownership of the returned object is transferred to the caller.
+     **/
+    ParserOutput* lookup(const ParserInput *input, const QByteArray& key) const;
+
+    void store(const ParserInput *input, const QByteArray& key, const ParserOutput *output);
+
+    /**
+     * Deletes the entries of local files that don't exist anymore, e.g. because they have
+     * been renamed, and the entries that haven't been written for a long time.
+     * No other method may be called while the entries are being removed.
+     **/
+    void removeStaleEntries();
+
+private:
+    QString m_directory;
+
+    QString fileNameFor(const QUrl &url) const;
+};
+
+}
+
+#endif
@@ -13,8 +13,11 @@
 
 #include "parsermanager.h"
 
+#include <KLocalizedString>
+
 #include "documentinfo.h"
 #include "errorhandler.h"
+#include "kileconfig.h"
 #include "kiledocmanager.h"
 #include "kileinfo.h"
 #include "kiletool_enums.h"
@@ -41,9 +44,12 @@ Manager::Manager(KileInfo *info, QObject *parent) :
             this, SIGNAL(documentParsingStarted()), Qt::QueuedConnection);
     m_documentParserThread->start();
 
+    qRegisterMetaType<LatexOutputInfoArray>("LatexOutputInfoArray");
     m_outputParserThread = new OutputParserThread(m_ki, this);
     connect(m_outputParserThread, SIGNAL(parsingComplete(QUrl,KileParser::ParserOutput*)),
             this, SLOT(handleOutputParsingComplete(QUrl,KileParser::ParserOutput*)), Qt::QueuedConnection);
+    connect(m_outputParserThread, SIGNAL(partialParsingResult(QUrl,LatexOutputInfoArray)),
+            this, SLOT(handleOutputPartialParsingResult(QUrl,LatexOutputInfoArray)), Qt::QueuedConnection);
     m_outputParserThread->start();
 }
 
@@ -65,14 +71,36 @@ void Manager::parseOutput(KileTool::Base *tool, const QString& fileName, const Q
                           const QString& texFileName, int selrow, int docrow)
 {
     qCDebug(LOG_KILE_PARSER) << fileName << sourceFile;
-    m_outputParserThread->addLaTeXLogFile(fileName, sourceFile, texFileName, selrow, docrow);
-    connect(tool, SIGNAL(aboutToBeDestroyed(KileTool::Base*)),
-            this, SLOT(removeToolFromUrlHash(KileTool::Base*)), Qt::UniqueConnection);
-
     // using 'fileName' directly is tricky as it might contain occurrences of '//' which are filtered out
     // by QUrl (given as argument in 'handleOutputParsingComplete') and the matching won't work anymore;
     // so we use QUrl already here
     const QUrl url = QUrl::fromLocalFile(fileName);
+    if(m_followedOutputUrlSet.remove(url)) {
+        // most of the log file has been parsed already, only the remaining lines have to be read
+        m_outputParserThread->stopFollowingLaTeXLogFile(fileName);
+    }
+    else {
+        m_outputParserThread->addLaTeXLogFile(fileName, sourceFile, texFileName, selrow, docrow);
+    }
+    registerToolForOutput(tool, url);
+}
+
+void Manager::followOutput(KileTool::Base *tool, const QString& fileName, const QString& sourceFile)
+{
+    qCDebug(LOG_KILE_PARSER) << fileName << sourceFile;
+    const QUrl url = QUrl::fromLocalFile(fileName);
+    if(m_followedOutputUrlSet.contains(url)) {
+        return;
+    }
+    m_followedOutputUrlSet.insert(url);
+    m_outputParserThread->followLaTeXLogFile(fileName, sourceFile);
+    registerToolForOutput(tool, url);
+}
+
+void Manager::registerToolForOutput(KileTool::Base *tool, const QUrl &url)
+{
+    connect(tool, SIGNAL(aboutToBeDestroyed(KileTool::Base*)),
+            this, SLOT(removeToolFromUrlHash(KileTool::Base*)), Qt::UniqueConnection);
     if(!m_urlToToolHash.contains(url, tool)) {
         m_urlToToolHash.insert(url, tool);
     }
@@ -93,6 +121,8 @@ void Manager::handleOutputParsingComplete(const QUrl &url, KileParser::ParserOut
     qCDebug(LOG_KILE_PARSER) << url;
     QList<KileTool::Base*> toolList = m_urlToToolHash.values(url);
     m_urlToToolHash.remove(url);
+    const int partialOutputItemCount = m_partialOutputItemCountHash.take(url);
+    m_followedOutputUrlSet.remove(url);
 
     LaTeXOutputParserOutput *latexOutput = dynamic_cast<LaTeXOutputParserOutput*>(output);
     if(!latexOutput) {
@@ -106,8 +136,9 @@ void Manager::handleOutputParsingComplete(const QUrl &url, KileParser::ParserOut
         m_ki->errorHandler()->printProblem(KileTool::Warning, latexOutput->problem);
         return;
     }
-    // use the returned list as the new global error information list
-    m_ki->errorHandler()->setMostRecentLogInformation(latexOutput->logFile, latexOutput->infoList);
+    // use the returned list as the new global error information list; the items that have
+    // been shown already while the log file was parsed are skipped
+    m_ki->errorHandler()->setMostRecentLogInformation(latexOutput->logFile, latexOutput->infoList.mid(partialOutputItemCount));
     // finally, inform the tools waiting for the error information
     Q_FOREACH(KileTool::Base *tool, toolList) {
         tool->installLaTeXOutputParserResult(latexOutput->nErrors, latexOutput->nWarnings,
@@ -117,6 +148,30 @@ void Manager::handleOutputParsingComplete(const QUrl &url, KileParser::ParserOut
     }
 }
 
+void Manager::handleOutputPartialParsingResult(const QUrl &url, const LatexOutputInfoArray& infoList)
+{
+    qCDebug(LOG_KILE_PARSER) << url << infoList.size();
+    if(!m_urlToToolHash.contains(url)) { // all the tools for 'url' have been killed
+        return;
+    }
+    m_ki->errorHandler()->setMostRecentLogInformation(url.toLocalFile(), infoList);
+    m_partialOutputItemCountHash[url] += infoList.size();
+
+    // LaTeX can only be stopped while the log file is still being followed
+    if(!KileConfig::stopLaTeXOnFirstError() || !m_followedOutputUrlSet.contains(url)) {
+        return;
+    }
+    for(const LatexOutputInfo& info : infoList) {
+        if(info.type() == LatexOutputInfo::itmError) {
+            Q_FOREACH(KileTool::Base *tool, m_urlToToolHash.values(url)) {
+                m_ki->errorHandler()->printMessage(KileTool::Error, i18n("Compilation stopped at the first error"), tool->name());
+                tool->stop();
+            }
+            break;
+        }
+    }
+}
+
 void Manager::removeToolFromUrlHash(KileTool::Base *tool)
 {
     QMultiHash<QUrl, KileTool::Base*>::iterator i = m_urlToToolHash.begin();
@@ -126,6 +181,8 @@ void Manager::removeToolFromUrlHash(KileTool::Base *tool)
             i = m_urlToToolHash.erase(i);
             // any more mappings for 'url' -> 'tool' left?
             if(!m_urlToToolHash.contains(url)) {
+                m_partialOutputItemCountHash.remove(url);
+                m_followedOutputUrlSet.remove(url);
                 m_outputParserThread->removeFile(url.toLocalFile());
             }
         }
@@ -18,9 +18,12 @@
 #include <QMultiHash>
 #include <QObject>
 #include <QQueue>
+#include <QSet>
 
 #include <QUrl>
 
+#include "outputinfo.h"
+
 class KileInfo;
 
 namespace KileDocument {
@@ -52,6 +55,13 @@ public:
                      // for QuickPreview
                      const QString& texFileName = "", int selrow = -1, int docrow = -1);
 
+    /**
+     * Parses the log file 'fileName' while 'tool' is still running. The problems that are found
+     * are shown immediately; the parsing is completed when 'parseOutput' is called for the
+     * log file after 'tool' has finished.
+     **/
+    void followOutput(KileTool::Base *tool, const QString& fileName, const QString& sourceFile);
+
     bool isDocumentParsingComplete();
 
     void stopDocumentParsing(const QUrl &url);
@@ -62,6 +72,7 @@ Q_SIGNALS:
 
 protected Q_SLOTS:
     void handleOutputParsingComplete(const QUrl &url, KileParser::ParserOutput *output);
+    void handleOutputPartialParsingResult(const QUrl &url, const LatexOutputInfoArray& infoList);
 
     void removeToolFromUrlHash(KileTool::Base *tool);
 
@@ -70,6 +81,11 @@ private:
     DocumentParserThread *m_documentParserThread;
     OutputParserThread *m_outputParserThread;
     QMultiHash<QUrl, KileTool::Base*> m_urlToToolHash;
+    // the number of items that have already been shown for the log files that are being parsed
+    QHash<QUrl, int> m_partialOutputItemCountHash;
+    QSet<QUrl> m_followedOutputUrlSet;
+
+    void registerToolForOutput(KileTool::Base *tool, const QUrl &url);
 };
 
 }
@@ -13,12 +13,15 @@
 
 #include "parserthread.h"
 
+#include <QFileInfo>
+
 #include "documentinfo.h"
 #include "kiledocmanager.h"
 #include "kileinfo.h"
 #include "bibtexparser.h"
 #include "latexparser.h"
 #include "latexoutputparser.h"
+#include "parsercache.h"
 
 namespace KileParser {
 
@@ -36,11 +39,39 @@ DocumentParserInput::DocumentParserInput(const QUrl &url, QStringList lines,
 {
 }
 
-ParserThread::ParserThread(KileInfo *info, QObject *parent) :
+class ParserThread::WorkerThread : public QThread
+{
+public:
+    WorkerThread(ParserThread *parserThread, int workerIndex)
+        : QThread(),
+          m_parserThread(parserThread),
+          m_workerIndex(workerIndex)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        m_parserThread->processParserQueue(m_workerIndex);
+    }
+
+private:
+    ParserThread *m_parserThread;
+    int m_workerIndex;
+};
+
+ParserThread::ParserThread(KileInfo *info, int workerCount, QObject *parent) :
     QThread(parent),
     m_ki(info),
     m_keepParserThreadAlive(true)
 {
+    m_workers.resize(qMax(1, workerCount));
+    m_workers[0].thread = this;
+    for(int i = 1; i < m_workers.size(); ++i) {
+        WorkerThread *workerThread = new WorkerThread(this, i);
+        m_workers[i].thread = workerThread;
+        m_additionalWorkerThreads.push_back(workerThread);
+    }
 }
 
 ParserThread::~ParserThread()
@@ -48,9 +79,11 @@ ParserThread::~ParserThread()
     qCDebug(LOG_KILE_PARSER) << "destroying parser thread" << this;
     stopParsing();
     // wait for the thread to finish before it is deleted at
-    // the end of this destructor
+    // the end of this destructor; 'run' only returns once all the
+    // additional workers have finished, too
     qCDebug(LOG_KILE_PARSER) << "waiting for parser thread to finish...";
     wait();
+    qDeleteAll(m_additionalWorkerThreads);
     // and delete remaining queue items (no mutex is required
     // as the thread's execution has stopped)
     qDeleteAll(m_parserQueue);
@@ -72,14 +105,23 @@ void ParserThread::addParserInput(ParserInput *input)
 
     if(it != m_parserQueue.end()) {
         qCDebug(LOG_KILE_PARSER) << "document in queue already";
+        inputSuperseded(*it, input);
+        delete *it;
         *it = input;
     }
     else {
-        if(m_currentlyParsedUrl == input->url) {
+        bool currentlyParsed = false;
+        for(Worker &worker : m_workers) {
+            if(worker.currentlyParsedUrl == input->url) {
+                // stop the parsing of the document
+                worker.cancelParsing();
+                currentlyParsed = true;
+            }
+        }
+        if(currentlyParsed) {
             qCDebug(LOG_KILE_PARSER) << "re-parsing document";
-            // stop the parsing of the document
-            m_keepParsingDocument = false;
-            // and add it as first element to the queue
+            // and add it as first element to the queue; it will be picked up
+            // as soon as the aborted worker has released the document
             m_parserQueue.push_front(input);
         }
         else {
@@ -98,9 +140,11 @@ void ParserThread::removeParserInput(const QUrl &url)
     qCDebug(LOG_KILE_PARSER) << url;
     m_parserMutex.lock();
     // first, if the document is currently parsed, we stop the parsing
-    if(m_currentlyParsedUrl == url) {
-        qCDebug(LOG_KILE_PARSER) << "document currently being parsed";
-        m_keepParsingDocument = false;
+    for(Worker &worker : m_workers) {
+        if(worker.currentlyParsedUrl == url) {
+            qCDebug(LOG_KILE_PARSER) << "document currently being parsed";
+            worker.cancelParsing();
+        }
     }
     // nevertheless, we remove all traces of the document from the queue
     for(QQueue<ParserInput*>::iterator it = m_parserQueue.begin(); it != m_parserQueue.end();) {
@@ -123,51 +167,107 @@ void ParserThread::stopParsing()
     m_parserMutex.lock();
 
     m_keepParserThreadAlive = false;
-    m_keepParsingDocument = false;
+    for(Worker &worker : m_workers) {
+        worker.cancelParsing();
+    }
     m_parserMutex.unlock();
     // wake all the threads that are still waiting for the queue to fill up
     m_queueEmptyWaitCondition.wakeAll();
 }
 
+// called once per line by the parsers, hence no mutex is used here: the workers never change
+// after the construction, and 'generation' is only incremented to abort the current job
 bool ParserThread::shouldContinueDocumentParsing()
 {
-    QMutexLocker locker(&m_parserMutex);
-    return m_keepParsingDocument;
+    const QThread *currentThread = QThread::currentThread();
+    const QVector<Worker>& workers = m_workers;
+    for(const Worker &worker : workers) {
+        if(worker.thread == currentThread) {
+            return (worker.generation.load() == worker.parsedGeneration);
+        }
+    }
+    return false;
 }
 
 bool ParserThread::isParsingComplete()
 {
     QMutexLocker locker(&m_parserMutex);
     // as the parser queue might be empty but a document is still being parsed,
-    // we additionally have to check whether 'm_currentlyParsedUrl' is empty or not
-    return m_parserQueue.isEmpty() && m_currentlyParsedUrl.isEmpty();
+    // we additionally have to check whether any worker is still busy
+    return m_parserQueue.isEmpty() && !isAnyWorkerBusy();
+}
+
+bool ParserThread::isAnyWorkerBusy() const
+{
+    for(const Worker &worker : m_workers) {
+        if(!worker.currentlyParsedUrl.isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// returns the first queued input whose URL is not being parsed by another worker
+QQueue<ParserInput*>::iterator ParserThread::findParsableInput()
+{
+    QQueue<ParserInput*>::iterator it = m_parserQueue.begin();
+    for(; it != m_parserQueue.end(); ++it) {
+        bool isBeingParsed = false;
+        for(const Worker &worker : m_workers) {
+            if(worker.currentlyParsedUrl == (*it)->url) {
+                isBeingParsed = true;
+                break;
+            }
+        }
+        if(!isBeingParsed) {
+            break;
+        }
+    }
+    return it;
 }
 
-// the document that is currently parsed is always the head of the queue
 void ParserThread::run()
+{
+    qCDebug(LOG_KILE_PARSER) << "starting up" << m_workers.size() << "workers...";
+    for(WorkerThread *workerThread : m_additionalWorkerThreads) {
+        workerThread->start();
+    }
+    processParserQueue(0);
+    for(WorkerThread *workerThread : m_additionalWorkerThreads) {
+        workerThread->wait();
+    }
+    qCDebug(LOG_KILE_PARSER) << "leaving...";
+}
+
+void ParserThread::processParserQueue(int workerIndex)
 {
     ParserInput* currentParsedItem;
-    qCDebug(LOG_KILE_PARSER) << "starting up...";
+    // only the first worker reports the empty queue on start-up
+    bool notifyQueueEmpty = (workerIndex == 0);
     while(true) {
-        // first, try to extract the head of the queue
+        // first, try to extract an item from the queue
         m_parserMutex.lock();
-        // clear the variable currently parsed url; might be necessary from the previous iteration
-        m_currentlyParsedUrl = QUrl();
         // check if we should still be running before going to sleep
         if(!m_keepParserThreadAlive) {
             m_parserMutex.unlock();
             // remaining queue elements are deleted in the destructor
             return;
         }
-        // but if there are no items to be parsed, we go to sleep.
+        // but if there are no items that can be parsed, we go to sleep.
         // However, we have to be careful and use a 'while' loop here
         // as it can happen that an item is added to the queue but this
         // thread is woken up only after it has been removed again.
-        while(m_parserQueue.size() == 0 && m_keepParserThreadAlive) {
+        QQueue<ParserInput*>::iterator parsableIt = findParsableInput();
+        while(parsableIt == m_parserQueue.end() && m_keepParserThreadAlive) {
+            // the queue counts as empty only once all the other workers are idle, too
+            if(notifyQueueEmpty && m_parserQueue.isEmpty() && !isAnyWorkerBusy()) {
+                emit(parsingQueueEmpty());
+            }
+            notifyQueueEmpty = false;
             qCDebug(LOG_KILE_PARSER) << "going to sleep...";
-            emit(parsingQueueEmpty());
             m_queueEmptyWaitCondition.wait(&m_parserMutex);
             qCDebug(LOG_KILE_PARSER) << "woken up...";
+            parsableIt = findParsableInput();
         }
         // threads are woken up when an object of this class is destroyed; in
         // that case the queue might still be empty
@@ -176,48 +276,104 @@ void ParserThread::run()
             // remaining queue elements are deleted in the destructor
             return;
         }
-        Q_ASSERT(m_parserQueue.size() > 0);
         qCDebug(LOG_KILE_PARSER) << "queue length" << m_parserQueue.length();
-        // now, extract the head
-        currentParsedItem = m_parserQueue.dequeue();
+        currentParsedItem = *parsableIt;
+        m_parserQueue.erase(parsableIt);
 
-        m_keepParsingDocument = true;
-        m_currentlyParsedUrl = currentParsedItem->url;
+        m_workers[workerIndex].parsedGeneration = m_workers[workerIndex].generation.load();
+        m_workers[workerIndex].currentlyParsedUrl = currentParsedItem->url;
         emit(parsingStarted());
         m_parserMutex.unlock();
 
-        Parser *parser = createParser(currentParsedItem);
+        Parser *parser = Q_NULLPTR;
+        ParserOutput *parserOutput = findCachedParserOutput(currentParsedItem);
+        if(!parserOutput) {
+            parser = createParser(currentParsedItem);
+            if(parser) {
+                parserOutput = parser->parse();
+            }
+        }
 
-        ParserOutput *parserOutput = Q_NULLPTR;
-        if(parser) {
-            parserOutput = parser->parse();
+        if(!parserOutput) {
+            // if the parsing has been aborted because the document has been queued again,
+            // the queued input has to take over what has been missed by the aborted one
+            m_parserMutex.lock();
+            for(QQueue<ParserInput*>::iterator it = m_parserQueue.begin(); it != m_parserQueue.end(); ++it) {
+                if((*it)->url == currentParsedItem->url) {
+                    inputSuperseded(currentParsedItem, *it);
+                    break;
+                }
+            }
+            m_parserMutex.unlock();
         }
+        processParserResult(currentParsedItem, parserOutput);
 
+        const QUrl url = currentParsedItem->url;
         delete currentParsedItem;
         delete parser;
 
         // we also emit when 'parserOutput == Q_NULLPTR' as this will be used to indicate
         // that some error has occurred;
         // as this call will be blocking, one has to make sure that no mutex is held
-        emit(parsingComplete(m_currentlyParsedUrl, parserOutput));
+        emit(parsingComplete(url, parserOutput));
+
+        // release the URL so that other workers can pick up queued inputs for it
+        m_parserMutex.lock();
+        m_workers[workerIndex].currentlyParsedUrl = QUrl();
+        m_parserMutex.unlock();
+        m_queueEmptyWaitCondition.wakeAll();
+        notifyQueueEmpty = true;
     }
-    qCDebug(LOG_KILE_PARSER) << "leaving...";
-    // remaining queue elements are deleted in the destructor
+}
+
+ParserOutput* ParserThread::findCachedParserOutput(ParserInput *input)
+{
+    Q_UNUSED(input);
+    return Q_NULLPTR;
+}
+
+void ParserThread::inputSuperseded(ParserInput *input, ParserInput *newInput)
+{
+    Q_UNUSED(input);
+    Q_UNUSED(newInput);
+}
+
+void ParserThread::processParserResult(ParserInput *input, ParserOutput *output)
+{
+    Q_UNUSED(input);
+    Q_UNUSED(output);
 }
 
 DocumentParserThread::DocumentParserThread(KileInfo *info, QObject *parent)
-    : ParserThread(info, parent)
+    : ParserThread(info, QThread::idealThreadCount(), parent),
+      m_parserCache(new ParserCache())
 {
 }
 
 DocumentParserThread::~DocumentParserThread()
 {
+    // the workers have to be stopped before the cache can be deleted
+    stopParsing();
+    wait();
+    delete m_parserCache;
+}
+
+void DocumentParserThread::run()
+{
+    // this is done before the workers start, i.e. before the cache is used
+    m_parserCache->removeStaleEntries();
+    ParserThread::run();
 }
 
 Parser* DocumentParserThread::createParser(ParserInput *input)
 {
-    if(dynamic_cast<LaTeXParserInput*>(input)) {
-        return new LaTeXParser(this, dynamic_cast<LaTeXParserInput*>(input));
+    LaTeXParserInput *latexInput = dynamic_cast<LaTeXParserInput*>(input);
+    if(latexInput) {
+        if(latexInput->editedLineRange.isValid()) {
+            QMutexLocker locker(&m_latexParserStateMutex);
+            latexInput->previousState = m_latexParserStateHash.value(latexInput->url);
+        }
+        return new LaTeXParser(this, latexInput);
     }
     else if(dynamic_cast<BibTeXParserInput*>(input)) {
         return new BibTeXParser(this, dynamic_cast<BibTeXParserInput*>(input));
@@ -226,6 +382,64 @@ Parser* DocumentParserThread::createParser(ParserInput *input)
     return Q_NULLPTR;
 }
 
+ParserOutput* DocumentParserThread::findCachedParserOutput(ParserInput *input)
+{
+    LaTeXParserInput *latexInput = dynamic_cast<LaTeXParserInput*>(input);
+    // edits are parsed incrementally from the results of the previous revision, which are
+    // more recent than what might be cached
+    if(latexInput && latexInput->editedLineRange.isValid()) {
+        return Q_NULLPTR;
+    }
+    const QByteArray key = ParserCache::keyFor(input);
+    ParserOutput *output = m_parserCache->lookup(input, key);
+    if(output) {
+        QMutexLocker locker(&m_parserCacheMutex);
+        m_cachedKeyHash.insert(input->url, key);
+    }
+    return output;
+}
+
+void DocumentParserThread::inputSuperseded(ParserInput *input, ParserInput *newInput)
+{
+    LaTeXParserInput *latexInput = dynamic_cast<LaTeXParserInput*>(input);
+    LaTeXParserInput *newLaTeXInput = dynamic_cast<LaTeXParserInput*>(newInput);
+    if(latexInput && newLaTeXInput) {
+        newLaTeXInput->editedLineRange = latexInput->editedLineRange.followedBy(newLaTeXInput->editedLineRange);
+    }
+}
+
+void DocumentParserThread::processParserResult(ParserInput *input, ParserOutput *output)
+{
+    if(!output) {
+        return;
+    }
+    // unsaved modifications are not cached as they would never be found again
+    if(input->isSaved) {
+        const QByteArray key = ParserCache::keyFor(input);
+        QMutexLocker locker(&m_parserCacheMutex);
+        if(m_cachedKeyHash.value(input->url) != key) {
+            m_cachedKeyHash.insert(input->url, key);
+            locker.unlock();
+            m_parserCache->store(input, key, output);
+        }
+    }
+
+    LaTeXParserInput *latexInput = dynamic_cast<LaTeXParserInput*>(input);
+    LaTeXParserOutput *latexOutput = dynamic_cast<LaTeXParserOutput*>(output);
+    if(!latexInput || !latexOutput) {
+        return;
+    }
+    QMutexLocker locker(&m_latexParserStateMutex);
+    // states are only kept for open documents, whose edits can be tracked
+    if(latexInput->editedLineRange.revision > 0 && latexOutput->parserState) {
+        m_latexParserStateHash.insert(latexInput->url, latexOutput->parserState);
+    }
+    else {
+        m_latexParserStateHash.remove(latexInput->url);
+    }
+    latexOutput->parserState.clear();
+}
+
 void DocumentParserThread::addDocument(KileDocument::TextInfo *textInfo)
 {
     qCDebug(LOG_KILE_PARSER) << textInfo;
@@ -235,16 +449,25 @@ void DocumentParserThread::addDocument(KileDocument::TextInfo *textInfo)
     }
 
     ParserInput* newItem = Q_NULLPTR;
+    // the snapshot shares the unchanged lines with the previous one and is not copied any further
+    const KileDocument::DocumentSnapshot documentContents = textInfo->documentSnapshot();
+    KileDocument::EditedLineRange editedLineRange = textInfo->takeEditedLineRange();
     if(dynamic_cast<KileDocument::BibInfo*>(textInfo)) {
-        newItem = new BibTeXParserInput(url, textInfo->documentContents());
+        newItem = new BibTeXParserInput(url, documentContents);
     }
     else {
-        newItem = new LaTeXParserInput(url, textInfo->documentContents(),
+        if(!KileConfig::svIncrementalParsing()) {
+            editedLineRange.valid = false;
+        }
+        newItem = new LaTeXParserInput(url, documentContents,
                                        m_ki->extensions(),
                                        textInfo->dictStructLevel(),
                                        KileConfig::svShowSectioningLabels(),
-                                       KileConfig::svShowTodo());
+                                       KileConfig::svShowTodo(),
+                                       editedLineRange);
     }
+    KTextEditor::Document *document = textInfo->getDoc();
+    newItem->isSaved = !document || !document->isModified();
     addParserInput(newItem);
 
     // It is not very useful to watch for the destruction of 'textInfo' here and stop the parsing
@@ -260,16 +483,24 @@ void DocumentParserThread::removeDocument(KileDocument::TextInfo *textInfo)
     if(!document) {
         return;
     }
-    removeParserInput(document->url());
+    removeDocument(document->url());
 }
 
 void DocumentParserThread::removeDocument(const QUrl &url)
 {
     removeParserInput(url);
+    {
+        QMutexLocker locker(&m_parserCacheMutex);
+        m_cachedKeyHash.remove(url);
+    }
+    QMutexLocker locker(&m_latexParserStateMutex);
+    m_latexParserStateHash.remove(url);
 }
 
+// a second worker ensures that the log files of other tools can be parsed
+// while the log file of a long LaTeX run is being followed
 OutputParserThread::OutputParserThread(KileInfo *info, QObject *parent)
-    : ParserThread(info, parent)
+    : ParserThread(info, 2, parent)
 {
 }
 
@@ -298,7 +529,48 @@ void OutputParserThread::addLaTeXLogFile(const QString& logFile, const QString&
 
 void OutputParserThread::removeFile(const QString& fileName)
 {
-    removeParserInput(QUrl::fromLocalFile(fileName));
+    const QUrl url = QUrl::fromLocalFile(fileName);
+    m_followedUrlMutex.lock();
+    m_followedUrlSet.remove(url);
+    m_followedUrlMutex.unlock();
+    removeParserInput(url);
+}
+
+void OutputParserThread::followLaTeXLogFile(const QString& logFile, const QString& sourceFile)
+{
+    qCDebug(LOG_KILE_PARSER) << logFile << sourceFile;
+
+    LaTeXOutputParserInput* newItem = new LaTeXOutputParserInput(QUrl::fromLocalFile(logFile), m_ki->extensions(),
+            sourceFile);
+    newItem->followOutput = true;
+    const QFileInfo logFileInfo(logFile);
+    if(logFileInfo.exists()) {
+        newItem->previousLogSize = logFileInfo.size();
+        newItem->previousLogModified = logFileInfo.lastModified();
+    }
+
+    m_followedUrlMutex.lock();
+    m_followedUrlSet.insert(newItem->url);
+    m_followedUrlMutex.unlock();
+    addParserInput(newItem);
+}
+
+void OutputParserThread::stopFollowingLaTeXLogFile(const QString& logFile)
+{
+    qCDebug(LOG_KILE_PARSER) << logFile;
+    QMutexLocker locker(&m_followedUrlMutex);
+    m_followedUrlSet.remove(QUrl::fromLocalFile(logFile));
+}
+
+bool OutputParserThread::isFollowingLaTeXLogFile(const QUrl &url)
+{
+    QMutexLocker locker(&m_followedUrlMutex);
+    return m_followedUrlSet.contains(url);
+}
+
+void OutputParserThread::reportPartialResult(const QUrl &url, const LatexOutputInfoArray& infoList)
+{
+    emit(partialParsingResult(url, infoList));
 }
 
 }
@@ -14,15 +14,21 @@
 #ifndef PARSERTHREAD_H
 #define PARSERTHREAD_H
 
+#include <QAtomicInt>
+#include <QHash>
 #include <QMutex>
 #include <QPair>
+#include <QSet>
+#include <QSharedPointer>
 #include <QThread>
 #include <QQueue>
+#include <QVector>
 #include <QWaitCondition>
 
 #include <QUrl>
 
 #include "documentinfo.h"
+#include "outputinfo.h"
 
 #include "parser.h"
 
@@ -36,8 +42,10 @@ class TextInfo;
 namespace KileParser {
 
 class Parser;
+class ParserCache;
 class ParserInput;
 class ParserOutput;
+class LaTeXParserState;
 
 enum ParserType { LaTeX = 0, BibTeX };
 
@@ -60,12 +68,17 @@ public:
     bool showStructureTodo;
 };
 
+/**
+ * Parses the queued inputs in the background. Up to 'workerCount' inputs are parsed
+ * concurrently: the thread itself acts as the first worker and starts the additional
+ * ones when it is run. Inputs for the same URL are never parsed at the same time.
+ **/
 class ParserThread : public QThread
 {
     Q_OBJECT
 
 public:
-    explicit ParserThread(KileInfo *info, QObject *parent = 0);
+    explicit ParserThread(KileInfo *info, int workerCount = 1, QObject *parent = 0);
     virtual ~ParserThread();
 
     void stopParsing();
@@ -94,13 +107,58 @@ protected:
 
     virtual Parser* createParser(ParserInput *input) = 0;
 
+    /**
+     * Called before 'input' is parsed; if an output is returned, it is used instead of parsing 'input'.
+     * The default implementation returns Q_NULLPTR.
+     **/
+    virtual ParserOutput* findCachedParserOutput(ParserInput *input);
+
+    /**
+     * Called when 'input' is replaced by 'newInput' for the same URL before any results for 'input'
+     * could be delivered, i.e. when 'input' was still queued or its parsing has been aborted.
+     * The parser mutex is held while this method is called. The default implementation does nothing.
+     **/
+    virtual void inputSuperseded(ParserInput *input, ParserInput *newInput);
+
+    /**
+     * Called after 'input' has been parsed; 'output' is Q_NULLPTR if the parsing has been aborted.
+     * This method is run directly on the worker thread that has parsed 'input', and several workers
+     * can call it concurrently without holding any mutex; implementations therefore have to protect
+     * the data they access themselves. The default implementation does nothing.
+     **/
+    virtual void processParserResult(ParserInput *input, ParserOutput *output);
+
 private:
+    class WorkerThread;
+
+    struct Worker {
+        Worker() : thread(Q_NULLPTR), generation(0), parsedGeneration(0) {}
+
+        // must be called with 'm_parserMutex' held
+        void cancelParsing() {
+            generation.fetchAndAddRelaxed(1);
+        }
+
+        QThread *thread;
+        QUrl currentlyParsedUrl;
+        // the parsing of the current input is aborted by incrementing 'generation', which
+        // the worker compares with the value it has seen when it has started parsing
+        QAtomicInt generation;
+        int parsedGeneration;
+    };
+
     bool m_keepParserThreadAlive;
-    bool m_keepParsingDocument;
     QQueue<ParserInput*> m_parserQueue;
-    QUrl m_currentlyParsedUrl;
+    // the first worker is this thread itself
+    QVector<Worker> m_workers;
+    QList<WorkerThread*> m_additionalWorkerThreads;
     QMutex m_parserMutex;
     QWaitCondition m_queueEmptyWaitCondition;
+
+    void processParserQueue(int workerIndex);
+    // the following methods must be called with 'm_parserMutex' held
+    QQueue<ParserInput*>::iterator findParsableInput();
+    bool isAnyWorkerBusy() const;
 };
 
 
@@ -118,8 +176,24 @@ public Q_SLOTS:
     void removeDocument(const QUrl &url);
 
 protected:
+    void run() override;
+
     virtual Parser* createParser(ParserInput *input) override;
+    virtual ParserOutput* findCachedParserOutput(ParserInput *input) override;
+    virtual void inputSuperseded(ParserInput *input, ParserInput *newInput) override;
+    virtual void processParserResult(ParserInput *input, ParserOutput *output) override;
 
+private:
+    ParserCache *m_parserCache;
+    // the keys of the cache entries that have been read or written for each URL in this session;
+    // only inputs that have been saved to disk are cached, which is why the documents are
+    // parsed again when they are saved
+    QHash<QUrl, QByteArray> m_cachedKeyHash;
+    QMutex m_parserCacheMutex;
+
+    // the states of the last parsing runs, which are used for incremental parsing
+    QHash<QUrl, QSharedPointer<const LaTeXParserState> > m_latexParserStateHash;
+    QMutex m_latexParserStateMutex;
 };
 
 
@@ -137,8 +211,32 @@ public Q_SLOTS:
                          const QString& texFileName = "", int selrow = -1, int docrow = -1);
     void removeFile(const QString& fileName);
 
+    /**
+     * Starts to parse the log file 'logFile' while it is still being written by LaTeX. The
+     * parsing is only completed after 'stopFollowingLaTeXLogFile' has been called for it.
+     **/
+    void followLaTeXLogFile(const QString& logFile, const QString& sourceFile);
+    void stopFollowingLaTeXLogFile(const QString& logFile);
+
+public:
+    bool isFollowingLaTeXLogFile(const QUrl &url);
+
+    // called by the output parser while the log file is still being read
+    void reportPartialResult(const QUrl &url, const LatexOutputInfoArray& infoList);
+
+Q_SIGNALS:
+    /**
+     * Emitted with the items that have been found in the log file 'url' so far; the
+     * final output given via 'parsingComplete' still contains all the items.
+     **/
+    void partialParsingResult(const QUrl &url, const LatexOutputInfoArray& infoList);
+
 protected:
     virtual Parser* createParser(ParserInput *input) override;
+
+private:
+    QSet<QUrl> m_followedUrlSet;
+    QMutex m_followedUrlMutex;
 };
 
 }
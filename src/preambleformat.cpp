@@ -0,0 +1,198 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "preambleformat.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+#include <KProcess>
+
+#include "documentsnapshot.h"
+#include "kileconstants.h"
+#include "kiledebug.h"
+#include "kileinfo.h"
+
+namespace KileTool
+{
+
+PreambleFormat::PreambleFormat(const QString& directory, const QString& jobName, QObject *parent)
+    : QObject(parent),
+      m_directory(directory),
+      m_jobName(jobName),
+      m_state(NoFormat),
+      m_process(Q_NULLPTR)
+{
+}
+
+PreambleFormat::~PreambleFormat()
+{
+    stopProcess();
+}
+
+bool PreambleFormat::isSupportedCommand(const QString& command)
+{
+    const QString engine = QFileInfo(command).fileName();
+    return engine == QLatin1String("pdflatex") || engine == QLatin1String("latex");
+}
+
+bool PreambleFormat::preambleMatchesDocument(const QString& preamble, const KileDocument::DocumentSnapshot& snapshot)
+{
+    // every line of the preamble is terminated by '\n'
+    const QStringList lines = preamble.split(QLatin1Char('\n'));
+    const int lineCount = lines.size() - 1;
+    if(lineCount <= 0 || lineCount > snapshot.size()) {
+        return false;
+    }
+    for(int i = 0; i < lineCount - 1; ++i) {
+        if(snapshot[i] != lines[i]) {
+            return false;
+        }
+    }
+
+    // '\begin{document}' either starts the next line or follows the last line of the preamble
+    const QString& lastLine = lines[lineCount - 1];
+    QString rest;
+    if(snapshot[lineCount - 1] == lastLine) {
+        if(lineCount == snapshot.size()) {
+            return false;
+        }
+        rest = snapshot[lineCount];
+    }
+    else if(snapshot[lineCount - 1].startsWith(lastLine)) {
+        rest = snapshot[lineCount - 1].mid(lastLine.length());
+    }
+    else {
+        return false;
+    }
+    return rest.startsWith(QLatin1String("\\begin{document}"));
+}
+
+QString PreambleFormat::format(const QString& preamble, const QString& command, const QString& sourceFile,
+                               const QString& teXInputPaths)
+{
+    if(!isSupportedCommand(command)) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(preamble.toUtf8());
+    hash.addData(command.toUtf8());
+    hash.addData(sourceFile.toUtf8());
+    hash.addData(teXInputPaths.toUtf8());
+    const QByteArray preambleHash = hash.result();
+
+    if(preambleHash == m_preambleHash) {
+        return (m_state == Available) ? formatBaseName() : QString();
+    }
+
+    KILE_DEBUG_MAIN << "preamble has changed, creating a new format for" << sourceFile;
+    m_preambleHash = preambleHash;
+    startProcess(command, sourceFile, teXInputPaths);
+    return QString();
+}
+
+void PreambleFormat::discard()
+{
+    stopProcess();
+    QFile::remove(formatFile());
+    m_preambleHash.clear();
+    m_state = NoFormat;
+}
+
+QString PreambleFormat::formatBaseName() const
+{
+    return m_directory + QLatin1Char('/') + m_jobName;
+}
+
+QString PreambleFormat::formatFile() const
+{
+    return formatBaseName() + QLatin1String(".fmt");
+}
+
+void PreambleFormat::stopProcess()
+{
+    if(!m_process) {
+        return;
+    }
+    m_process->disconnect(this);
+    if(m_process->state() != QProcess::NotRunning) {
+        m_process->kill();
+        m_process->waitForFinished();
+    }
+    m_process->deleteLater();
+    m_process = Q_NULLPTR;
+}
+
+void PreambleFormat::startProcess(const QString& command, const QString& sourceFile, const QString& teXInputPaths)
+{
+    stopProcess();
+    QFile::remove(formatFile());
+
+    const QFileInfo sourceFileInfo(sourceFile);
+    m_process = new KProcess(this);
+    m_process->setWorkingDirectory(sourceFileInfo.absolutePath());
+    // the output isn't needed; the log file is kept in the format directory
+    m_process->setStandardInputFile(QProcess::nullDevice());
+    m_process->setStandardOutputFile(QProcess::nullDevice());
+    m_process->setStandardErrorFile(QProcess::nullDevice());
+    m_process->setEnv("PATH", KileInfo::expandEnvironmentVars("$PATH"));
+    if(!teXInputPaths.isEmpty()) {
+        m_process->setEnv("TEXINPUTS", KileInfo::expandEnvironmentVars(teXInputPaths + LIST_SEPARATOR + "$TEXINPUTS"));
+    }
+
+    // 'mylatexformat' reads the document up to '\begin{document}' and dumps everything
+    // that has been loaded so far
+    QStringList arguments;
+    arguments << QStringLiteral("-ini")
+              << QStringLiteral("-interaction=nonstopmode")
+              << QStringLiteral("-jobname=") + m_jobName
+              << QStringLiteral("-output-directory=") + m_directory
+              << QStringLiteral("&") + QFileInfo(command).fileName()
+              << QStringLiteral("mylatexformat.ltx")
+              << QStringLiteral("\"") + sourceFileInfo.fileName() + QStringLiteral("\"");
+    m_process->setProgram(command, arguments);
+
+    connect(m_process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, &PreambleFormat::processFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if(error == QProcess::FailedToStart) {
+            processFinished(-1, QProcess::CrashExit);
+        }
+    });
+
+    m_state = Creating;
+    m_process->start();
+}
+
+void PreambleFormat::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    stopProcess();
+
+    if(exitStatus == QProcess::NormalExit && exitCode == 0 && QFile::exists(formatFile())) {
+        KILE_DEBUG_MAIN << "created" << formatFile();
+        m_state = Available;
+        emit(formatAvailable());
+    }
+    else {
+        // most likely, 'mylatexformat' is not installed or the preamble contains an error;
+        // we don't try again before the preamble has changed
+        KILE_DEBUG_MAIN << "creating" << formatFile() << "failed with exit code" << exitCode;
+        QFile::remove(formatFile());
+        m_state = Failed;
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PREAMBLEFORMAT_H
+#define PREAMBLEFORMAT_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+
+class KProcess;
+
+namespace KileDocument {
+class DocumentSnapshot;
+}
+
+namespace KileTool
+{
+
+/**
+ * Manages a format file in which the preamble of a document has been precompiled with the
+ * 'mylatexformat' package. A document whose preamble hasn't changed can then be compiled
+ * with '-fmt=<format>', which skips loading all the packages again.
+ *
+ * The format is created in the background; until it is available (or if it cannot be
+ * created), the documents have to be compiled in the usual way.
+ **/
+class PreambleFormat : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State { NoFormat, Creating, Available, Failed };
+
+    /**
+     * The format files are written into 'directory' with the base name 'jobName'.
+     **/
+    PreambleFormat(const QString& directory, const QString& jobName, QObject *parent = Q_NULLPTR);
+    ~PreambleFormat();
+
+    /**
+     * Only pdfTeX can store a LaTeX preamble in a format; XeTeX and LuaTeX cannot dump
+     * the loaded fonts or the Lua state.
+     **/
+    static bool isSupportedCommand(const QString& command);
+
+    /**
+     * Returns true if 'preamble', as found by the parser, is the beginning of 'snapshot'
+     * up to '\begin{document}', i.e. if the parser has caught up with the document.
+     **/
+    static bool preambleMatchesDocument(const QString& preamble, const KileDocument::DocumentSnapshot& snapshot);
+
+    State state() const {
+        return m_state;
+    }
+
+    /**
+     * Returns the format (suitable for the '-fmt' option) that contains 'preamble' compiled
+     * with 'command', or an empty string if no such format is available yet. In that case,
+     * the creation of the format from 'sourceFile' is started unless it has already failed
+     * for the same preamble.
+     **/
+    QString format(const QString& preamble, const QString& command, const QString& sourceFile,
+                   const QString& teXInputPaths);
+
+    /**
+     * Stops the creation of the format and deletes it.
+     **/
+    void discard();
+
+Q_SIGNALS:
+    void formatAvailable();
+
+private Q_SLOTS:
+    void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    QString m_directory;
+    QString m_jobName;
+    QByteArray m_preambleHash;
+    State m_state;
+    KProcess *m_process;
+
+    QString formatBaseName() const;
+    QString formatFile() const;
+    void stopProcess();
+    void startProcess(const QString& command, const QString& sourceFile, const QString& teXInputPaths);
+};
+
+}
+
+#endif
@@ -32,12 +32,14 @@
 #include "errorhandler.h"
 #include "kileconstants.h"
 #include "kiledebug.h"
+#include "parser/parsermanager.h"
+#include "preambleformat.h"
 
 
 namespace KileTool
 {
 
-QuickPreview::QuickPreview(KileInfo *ki) : m_ki(ki), m_running(0), m_tempDir(Q_NULLPTR)
+QuickPreview::QuickPreview(KileInfo *ki) : m_ki(ki), m_running(0), m_tempDir(Q_NULLPTR), m_preambleFormat(Q_NULLPTR)
 {
     m_taskList << i18n("LaTeX ---> DVI (Okular)")
                << i18n("LaTeX ---> DVI (Document Viewer)")
@@ -54,6 +56,7 @@ QuickPreview::QuickPreview(KileInfo *ki) : m_ki(ki), m_running(0), m_tempDir(Q_N
 
 QuickPreview::~QuickPreview()
 {
+    delete m_preambleFormat;
     delete m_tempDir;
 }
 
@@ -208,9 +211,20 @@ bool QuickPreview::run(const QString &text,const QString &textfilename,int start
         return false;
     }
 
-    delete m_tempDir;
-    m_tempDir = new QTemporaryDir(QDir::tempPath() + QLatin1Char('/') + "kile-preview");
-    m_tempDir->setAutoRemove(true);
+    // the directory is kept for all previews so that the precompiled preamble can be reused
+    if(!m_tempDir) {
+        m_tempDir = new QTemporaryDir(QDir::tempPath() + QLatin1Char('/') + "kile-preview");
+        m_tempDir->setAutoRemove(true);
+        m_preambleFormat = new PreambleFormat(m_tempDir->path(), QStringLiteral("kile-preamble"));
+    }
+    else {
+        // don't show the output of the previous preview if this one fails
+        const QDir tempDir(m_tempDir->path());
+        const QStringList previousFiles = tempDir.entryList(QStringList() << QStringLiteral("preview.*"), QDir::Files);
+        for(const QString& fileName : previousFiles) {
+            tempDir.remove(fileName);
+        }
+    }
     m_tempFile = QFileInfo(m_tempDir->path(), "preview.tex").absoluteFilePath();
     KILE_DEBUG_MAIN << "\tdefine tempfile: " << m_tempFile << endl;
 
@@ -261,6 +275,10 @@ bool QuickPreview::run(const QString &text,const QString &textfilename,int start
     KileConfig::setPreviewTeXPaths(inputdir);
     KILE_DEBUG_MAIN << "\tQuickPreview: inputdir is '" << inputdir << "'" << endl;
 
+    if(KileConfig::previewPrecompilePreamble()) {
+        latex->setPrecompiledFormat(precompiledFormat(latex->readEntry("command"), inputdir));
+    }
+
     // prepare tools: previewlatex
     QString filepath = m_tempFile.left(m_tempFile.length() - 3);
     latex->setPreviewInfo(textfilename, startrow, preamblelines + 1);
@@ -322,61 +340,122 @@ int QuickPreview::createTempfile(const QString &text)
         return 0;
     }
 
-    // open to read
-    QFile fin(filename);
-    if(!fin.exists() || !fin.open(QIODevice::ReadOnly)) {
-        showError(i18n("Could not read the preamble."));
+    if(!readPreamble(filename, m_preamble)) {
         return 0;
     }
-    KILE_DEBUG_MAIN << "\tcreate a temporary file: "  << m_tempFile << endl;
 
-    // use a textstream
-    QTextStream preamble(&fin);
-
-    // create the temporary file
-    QFile tempfile(m_tempFile);
-    if(!tempfile.open(QIODevice::WriteOnly)) {
+    KILE_DEBUG_MAIN << "\tcreate a temporary file: "  << m_tempFile << endl;
+    if(!writeTeXFile(m_tempFile, m_preamble, text)) {
         showError(i18n("Could not create a temporary file."));
         return 0;
     }
-    QTextStream stream(&tempfile);
 
-    // set the encoding according to the original file (tbraun)
-    if(m_ki->activeTextDocument()) {
-        QTextCodec *codec = QTextCodec::codecForName(m_ki->activeTextDocument()->encoding().toLatin1());
-        if(codec) {
-            stream.setCodec(codec);
-        }
+    return m_preamble.count('\n');
+}
+
+bool QuickPreview::readPreamble(const QString &filename, QString &preamble)
+{
+    // the parser knows the preamble of open documents, unless they have been changed since
+    KileDocument::LaTeXInfo *latexInfo = dynamic_cast<KileDocument::LaTeXInfo*>(m_ki->docManager()->textInfoFor(filename));
+    if(latexInfo && m_ki->parserManager()->isDocumentParsingComplete()
+            && PreambleFormat::preambleMatchesDocument(latexInfo->preamble(), latexInfo->documentSnapshot())) {
+        preamble = latexInfo->preamble();
+        return true;
+    }
+
+    // otherwise, the file is only read again when it has been modified
+    const QDateTime lastModified = QFileInfo(filename).lastModified();
+    QHash<QString, CachedPreamble>::const_iterator it = m_preambleCache.constFind(filename);
+    if(it != m_preambleCache.constEnd() && it->lastModified == lastModified) {
+        preamble = it->preamble;
+        return true;
+    }
+
+    // open to read
+    QFile fin(filename);
+    if(!fin.exists() || !fin.open(QIODevice::ReadOnly)) {
+        showError(i18n("Could not read the preamble."));
+        return false;
     }
-    // write the whole preamble into this temporary file
-    QString textline;
-    int preamblelines = 0;
+
+    // use a textstream
+    QTextStream stream(&fin);
+
+    // read the whole preamble
+    QString text;
     bool begindocumentFound = false;
-    while(!preamble.atEnd()) {
-        textline = preamble.readLine();
+    while(!stream.atEnd()) {
+        const QString textline = stream.readLine();
         if (textline.indexOf("\\begin{document}") >= 0) {
             begindocumentFound = true;
             break;
         }
-        stream << textline << "\n";
-        preamblelines++;
+        text += textline + '\n';
     }
 
     // look if we found '\begin{document}' to finish the preamble
     if (!begindocumentFound) {
-        tempfile.close();
         showError(i18n("Could not find a '\\begin{document}' command."));
-        return 0;
+        return false;
+    }
+
+    CachedPreamble &cachedPreamble = m_preambleCache[filename];
+    cachedPreamble.lastModified = lastModified;
+    cachedPreamble.preamble = text;
+    preamble = text;
+    return true;
+}
+
+bool QuickPreview::writeTeXFile(const QString &filename, const QString &preamble, const QString &body)
+{
+    QFile tempfile(filename);
+    if(!tempfile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QTextStream stream(&tempfile);
+
+    QTextCodec *codec = documentCodec();
+    if(codec) {
+        stream.setCodec(codec);
     }
 
-    // add the text to compile
+    stream << preamble;
     stream << "\\pagestyle{empty}\n";
     stream << "\\begin{document}\n";
-    stream << text;
+    stream << body;
     stream << "\n\\end{document}\n";
     tempfile.close();
 
-    return preamblelines;
+    return true;
+}
+
+QTextCodec* QuickPreview::documentCodec()
+{
+    // set the encoding according to the original file (tbraun)
+    if(m_ki->activeTextDocument()) {
+        return QTextCodec::codecForName(m_ki->activeTextDocument()->encoding().toLatin1());
+    }
+    return Q_NULLPTR;
+}
+
+QString QuickPreview::precompiledFormat(const QString &command, const QString &texInputPaths)
+{
+    if(!PreambleFormat::isSupportedCommand(command)) {
+        return QString();
+    }
+
+    // the format is created from a document that only consists of the preamble; as the
+    // preview documents start with the same lines, 'mylatexformat' skips them when the
+    // format is used
+    const QString sourceFile = QFileInfo(m_tempDir->path(), "preamble.tex").absoluteFilePath();
+    if(m_preamble != m_formatPreamble || !QFile::exists(sourceFile)) {
+        if(!writeTeXFile(sourceFile, m_preamble, QString())) {
+            return QString();
+        }
+        m_formatPreamble = m_preamble;
+    }
+
+    return m_preambleFormat->format(m_preamble, command, sourceFile, texInputPaths);
 }
 
 //////////////////// error messages ////////////////////
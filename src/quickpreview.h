@@ -22,14 +22,20 @@
 #include "editorextension.h"
 #include "widgets/previewwidget.h"
 
+#include <QDateTime>
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QStringList>
 
 #include <QTemporaryDir>
 
+class QTextCodec;
+
 namespace KileTool
 {
+class PreambleFormat;
+
 enum { qpSelection=0, qpEnvironment, qpSubdocument, qpMathgroup };
 
 class QuickPreview : public QObject
@@ -85,13 +91,32 @@ private Q_SLOTS:
 private:
     enum { pvLatex=0, pvDvips=1, pvDvipsCfg=2, pvViewer=3, pvViewerCfg=4, pvExtension=5 };
 
+    struct CachedPreamble {
+        QDateTime lastModified;
+        QString preamble;
+    };
+
     KileInfo *m_ki;
     QString m_tempFile;
     QStringList m_taskList;
     int m_running;
     QTemporaryDir *m_tempDir;
+    QString m_preamble;
+    QHash<QString, CachedPreamble> m_preambleCache;
+    PreambleFormat *m_preambleFormat;
+    QString m_formatPreamble;
 
     int createTempfile(const QString &text);
+    bool readPreamble(const QString &filename, QString &preamble);
+    bool writeTeXFile(const QString &filename, const QString &preamble, const QString &body);
+    QTextCodec* documentCodec();
+
+    /**
+     * Returns the format in which the current preamble has been precompiled, or an empty
+     * string if it isn't available (yet).
+     **/
+    QString precompiledFormat(const QString &command, const QString &texInputPaths);
+
     void showError(const QString &text);
 };
 
@@ -0,0 +1,82 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "startupprofiler.h"
+
+#include <QElapsedTimer>
+#include <QPair>
+#include <QTextStream>
+#include <QVector>
+
+#include <cstdio>
+
+namespace KileUtilities {
+
+namespace {
+
+bool profilingEnabled = false;
+bool profilingStopped = false;
+QElapsedTimer startupClock;
+qint64 lastPhaseEnd = 0;
+// the names of the phases together with their durations in milliseconds
+QVector<QPair<QString, qint64> > phases;
+
+}
+
+void StartupProfiler::start()
+{
+    startupClock.start();
+}
+
+void StartupProfiler::setEnabled(bool enabled)
+{
+    profilingEnabled = enabled;
+}
+
+bool StartupProfiler::isEnabled()
+{
+    return profilingEnabled;
+}
+
+void StartupProfiler::finishPhase(const QString& name)
+{
+    if(profilingStopped || !startupClock.isValid()) {
+        return;
+    }
+    const qint64 now = startupClock.elapsed();
+    phases.append(qMakePair(name, now - lastPhaseEnd));
+    lastPhaseEnd = now;
+}
+
+void StartupProfiler::report()
+{
+    if(profilingStopped) {
+        return;
+    }
+    profilingStopped = true;
+    if(!profilingEnabled) {
+        phases.clear();
+        return;
+    }
+    QTextStream out(stderr);
+    out << "Kile start-up times (ms):\n";
+    for(const QPair<QString, qint64>& phase : qAsConst(phases)) {
+        out << QString::number(phase.second).rightJustified(7) << "  " << phase.first << '\n';
+    }
+    out << QString::number(lastPhaseEnd).rightJustified(7) << "  total\n";
+    out.flush();
+
+    phases.clear();
+}
+
+}
@@ -0,0 +1,47 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QString>
+
+namespace KileUtilities {
+
+/**
+ * Measures how long the phases of Kile's start-up take.
+ *
+ * The clock starts with @ref start at the beginning of 'main'; every call to @ref finishPhase
+ * records the time that has passed since the previous phase was finished. The timings are
+ * only printed if Kile has been started with '--profile-startup'.
+ **/
+class StartupProfiler
+{
+public:
+    static void start();
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    static void finishPhase(const QString& name);
+
+    /**
+     * Prints the timings of all the phases to the standard error output if the profiling
+     * is enabled, and stops the profiling.
+     **/
+    static void report();
+};
+
+}
+
+#endif
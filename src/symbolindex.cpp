@@ -0,0 +1,183 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "symbolindex.h"
+
+#include "documentinfo.h"
+
+namespace KileDocument {
+
+SymbolScope::SymbolScope()
+{
+}
+
+SymbolScope::SymbolScope(const QList<TextInfo*>& documents)
+    : m_documents(documents)
+{
+    m_positions.reserve(documents.size());
+    for(int i = documents.size() - 1; i >= 0; --i) {
+        m_positions.insert(documents[i], i);
+    }
+}
+
+SymbolIndex::SymbolIndex()
+{
+}
+
+SymbolIndex::~SymbolIndex()
+{
+}
+
+QStringList SymbolIndex::symbolsOf(TextInfo *textInfo, SymbolType type)
+{
+    switch(type) {
+    case Labels:
+        return textInfo->labels();
+    case BibItems:
+        return textInfo->bibItems();
+    case Bibliographies:
+        return textInfo->bibliographies();
+    case Dependencies:
+        return textInfo->dependencies();
+    case NewCommands:
+        return textInfo->newCommands();
+    case AsyFigures:
+        return textInfo->asyFigures();
+    case Packages:
+        return textInfo->packages();
+    default:
+        return QStringList();
+    }
+}
+
+void SymbolIndex::setSymbols(SymbolTable &table, TextInfo *textInfo, const QStringList& symbols)
+{
+    QHash<TextInfo*, QStringList>::iterator it = table.documentSymbols.find(textInfo);
+    if(it == table.documentSymbols.end()) {
+        if(symbols.isEmpty()) {
+            return;
+        }
+        it = table.documentSymbols.insert(textInfo, QStringList());
+    }
+    else if(*it == symbols) {
+        // nothing has changed, which is the common case after a parsing run
+        return;
+    }
+
+    for(const QString& symbol : *it) {
+        QMap<QString, QList<TextInfo*> >::iterator definitionIt = table.definitions.find(symbol);
+        if(definitionIt != table.definitions.end()) {
+            definitionIt->removeAll(textInfo);
+            if(definitionIt->isEmpty()) {
+                table.definitions.erase(definitionIt);
+            }
+        }
+    }
+    for(const QString& symbol : symbols) {
+        QList<TextInfo*> &definingDocuments = table.definitions[symbol];
+        if(!definingDocuments.contains(textInfo)) {
+            definingDocuments.append(textInfo);
+        }
+    }
+
+    if(symbols.isEmpty()) {
+        table.documentSymbols.erase(it);
+    }
+    else {
+        *it = symbols;
+    }
+    ++table.generation;
+}
+
+void SymbolIndex::update(TextInfo *textInfo)
+{
+    if(!textInfo) {
+        return;
+    }
+    for(int type = 0; type < SymbolTypeCount; ++type) {
+        setSymbols(m_tables[type], textInfo, symbolsOf(textInfo, static_cast<SymbolType>(type)));
+    }
+}
+
+void SymbolIndex::remove(TextInfo *textInfo)
+{
+    for(int type = 0; type < SymbolTypeCount; ++type) {
+        SymbolTable &table = m_tables[type];
+        setSymbols(table, textInfo, QStringList());
+        // the pointer might be reused for another object later on
+        if(table.cachedScope.contains(textInfo)) {
+            table.cachedScope = SymbolScope();
+            table.cachedSymbols.clear();
+        }
+    }
+}
+
+QStringList SymbolIndex::symbols(SymbolType type, const SymbolScope& scope)
+{
+    SymbolTable &table = m_tables[type];
+    if(table.cachedGeneration == table.generation && table.cachedScope == scope) {
+        return table.cachedSymbols;
+    }
+
+    QStringList symbols;
+    for(TextInfo *textInfo : scope.documents()) {
+        symbols += table.documentSymbols.value(textInfo);
+    }
+    table.cachedScope = scope;
+    table.cachedSymbols = symbols;
+    table.cachedGeneration = table.generation;
+    return symbols;
+}
+
+bool SymbolIndex::contains(SymbolType type, const QString& symbol, const SymbolScope& scope) const
+{
+    return (definingDocument(type, symbol, scope) != Q_NULLPTR);
+}
+
+QStringList SymbolIndex::symbolsWithPrefix(SymbolType type, const QString& prefix, const SymbolScope& scope) const
+{
+    const SymbolTable &table = m_tables[type];
+    QStringList toReturn;
+    for(QMap<QString, QList<TextInfo*> >::const_iterator it = table.definitions.lowerBound(prefix);
+            it != table.definitions.constEnd() && it.key().startsWith(prefix); ++it) {
+        for(TextInfo *textInfo : *it) {
+            if(scope.contains(textInfo)) {
+                toReturn.append(it.key());
+                break;
+            }
+        }
+    }
+    return toReturn;
+}
+
+TextInfo* SymbolIndex::definingDocument(SymbolType type, const QString& symbol, const SymbolScope& scope) const
+{
+    const SymbolTable &table = m_tables[type];
+    QMap<QString, QList<TextInfo*> >::const_iterator it = table.definitions.constFind(symbol);
+    if(it == table.definitions.constEnd()) {
+        return Q_NULLPTR;
+    }
+    // a symbol is usually defined in very few documents
+    TextInfo *firstDocument = Q_NULLPTR;
+    int firstIndex = -1;
+    for(TextInfo *textInfo : *it) {
+        const int index = scope.indexOf(textInfo);
+        if(index >= 0 && (firstIndex < 0 || index < firstIndex)) {
+            firstDocument = textInfo;
+            firstIndex = index;
+        }
+    }
+    return firstDocument;
+}
+
+}
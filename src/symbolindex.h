@@ -0,0 +1,121 @@
+/**************************************************************************
+*   Copyright (C) 2026 by the Kile Team                                   *
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+
+namespace KileDocument {
+
+class TextInfo;
+
+/**
+ * The documents in which symbols are looked up, e.g. all the documents of a project tree.
+ * Besides their order, the position of every document is kept, such that it can be checked
+ * quickly whether a document belongs to the scope.
+ **/
+class SymbolScope
+{
+public:
+    SymbolScope();
+    explicit SymbolScope(const QList<TextInfo*>& documents);
+
+    const QList<TextInfo*>& documents() const {
+        return m_documents;
+    }
+
+    bool contains(TextInfo *textInfo) const {
+        return m_positions.contains(textInfo);
+    }
+
+    /**
+     * Returns the position of 'textInfo' in the scope, or -1 if it doesn't belong to it.
+     **/
+    int indexOf(TextInfo *textInfo) const {
+        return m_positions.value(textInfo, -1);
+    }
+
+    bool operator==(const SymbolScope& other) const {
+        return m_documents == other.m_documents;
+    }
+
+private:
+    QList<TextInfo*> m_documents;
+    QHash<TextInfo*, int> m_positions;
+};
+
+/**
+ * Keeps track of the symbols (labels, BibTeX keys, packages, etc.) that are defined in the open
+ * documents. The index is updated whenever the results of a parsing run are installed, and the
+ * symbols can be queried for a set of documents, e.g. all the documents of a project tree.
+ **/
+class SymbolIndex
+{
+public:
+    enum SymbolType { Labels = 0, BibItems, Bibliographies, Dependencies, NewCommands, AsyFigures, Packages, SymbolTypeCount };
+
+    SymbolIndex();
+    ~SymbolIndex();
+
+    /**
+     * Takes over the symbols that have been found by the last parsing run of 'textInfo'.
+     **/
+    void update(TextInfo *textInfo);
+    /**
+     * Has to be called before 'textInfo' is deleted.
+     **/
+    void remove(TextInfo *textInfo);
+
+    /**
+     * Returns the symbols of type 'type' that are defined in the documents in 'scope' (in the
+     * order of the documents). The list is only assembled again if the symbols have changed.
+     **/
+    QStringList symbols(SymbolType type, const SymbolScope& scope);
+
+    bool contains(SymbolType type, const QString& symbol, const SymbolScope& scope) const;
+    QStringList symbolsWithPrefix(SymbolType type, const QString& prefix, const SymbolScope& scope) const;
+
+    /**
+     * Returns the first document in 'scope' that defines 'symbol', or Q_NULLPTR if there is none.
+     **/
+    TextInfo* definingDocument(SymbolType type, const QString& symbol, const SymbolScope& scope) const;
+
+private:
+    struct SymbolTable {
+        SymbolTable() : generation(0), cachedGeneration(0) {}
+
+        QHash<TextInfo*, QStringList> documentSymbols;
+        // maps the symbols to the documents defining them; as the map is sorted,
+        // all the symbols starting with a given prefix can be found quickly
+        QMap<QString, QList<TextInfo*> > definitions;
+        quint64 generation;
+
+        // the result of the last call of 'symbols'
+        SymbolScope cachedScope;
+        QStringList cachedSymbols;
+        quint64 cachedGeneration;
+    };
+
+    SymbolTable m_tables[SymbolTypeCount];
+
+    static QStringList symbolsOf(TextInfo *textInfo, SymbolType type);
+    static void setSymbols(SymbolTable &table, TextInfo *textInfo, const QStringList& symbols);
+};
+
+}
+
+#endif
@@ -10,7 +10,9 @@
 #ifndef SYMBOLVIEWCLASSES_H
 #define SYMBOLVIEWCLASSES_H
 
+#include <QDataStream>
 #include <QObject>
+#include <QRect>
 #include <QString>
 
 struct Preamble {
@@ -41,4 +43,34 @@ struct Version {
     QString minor;
 };
 
+// The images of the symbols that are shipped with Kile are combined into one image at build
+// time ('symbols-atlas.png'), which is described by an index file ('symbols-atlas.index').
+// The index starts with the magic number and the version, followed by the number of entries.
+#define SYMBOL_ATLAS_MAGIC 0x4b535941 // "KSYA"
+#define SYMBOL_ATLAS_VERSION 1
+
+struct SymbolAtlasEntry {
+    QString group;
+    QString fileName;
+    QRect rect;
+    // the text chunks of the original image
+    QString command;
+    QString commandUnicode;
+    QString unicodePackages;
+    QString packages;
+    QString comment;
+};
+
+inline QDataStream& operator<<(QDataStream &stream, const SymbolAtlasEntry &entry)
+{
+    return stream << entry.group << entry.fileName << entry.rect << entry.command << entry.commandUnicode
+                  << entry.unicodePackages << entry.packages << entry.comment;
+}
+
+inline QDataStream& operator>>(QDataStream &stream, SymbolAtlasEntry &entry)
+{
+    return stream >> entry.group >> entry.fileName >> entry.rect >> entry.command >> entry.commandUnicode
+                  >> entry.unicodePackages >> entry.packages >> entry.comment;
+}
+
 #endif //SYMBOLVIEWCLASSES_H
@@ -127,6 +127,8 @@ void CodeCompletionConfigWidget::readConfig()
     cb_setcursor->setChecked(KileConfig::completeCursor());
     cb_setbullets->setChecked(KileConfig::completeBullets());
     cb_closeenv->setChecked(KileConfig::completeCloseEnv());
+    cb_packagelists->setChecked(KileConfig::completePackageLists());
+    cb_fuzzy->setChecked(KileConfig::completeFuzzy());
     cb_showabbrevview->setChecked(KileConfig::completeShowAbbrev());
     cb_showcwlview->setChecked(KileConfig::showCwlCommands());
 
@@ -157,6 +159,12 @@ void CodeCompletionConfigWidget::writeConfig()
     KileConfig::setCompleteCursor(cb_setcursor->isChecked());
     KileConfig::setCompleteBullets(cb_setbullets->isChecked());
     KileConfig::setCompleteCloseEnv(cb_closeenv->isChecked());
+    // the lists of the packages are read at different times in the two modes
+    if(cb_packagelists->isChecked() != KileConfig::completePackageLists()) {
+        m_configChanged = true;
+    }
+    KileConfig::setCompletePackageLists(cb_packagelists->isChecked());
+    KileConfig::setCompleteFuzzy(cb_fuzzy->isChecked());
     KileConfig::setCompleteShowAbbrev(cb_showabbrevview->isChecked());
     KileConfig::setShowCwlCommands(cb_showcwlview->isChecked());
 
@@ -14,12 +14,10 @@
 
 #include "widgets/logwidget.h"
 
-#include <QAbstractTextDocumentLayout>
 #include <QClipboard>
-#include <QHash>
+#include <QFontMetrics>
 #include <QMenu>
 #include <QPainter>
-#include <QTextDocument>
 #include <QTextStream>
 
 #include <QAction>
@@ -28,6 +26,8 @@
 #include <KStandardAction>
 #include <QUrl>
 
+#include <algorithm>
+
 #include "kileconfig.h"
 #include "kiledebug.h"
 #include "kileinfo.h"
@@ -35,82 +35,219 @@
 
 namespace KileWidget
 {
+
+namespace {
+
+const int textMargin = 4;
+// number of lines whose text layout is kept
+const int staticTextCacheSize = 2000;
+
+QColor textColor(int type, const QWidget *widget)
+{
+    switch(type) {
+    case KileTool::Warning: // fall through
+    case KileTool::ProblemWarning:
+        return KStatefulBrush(KColorScheme::View, KColorScheme::NeutralText).brush(widget).color();
+    case KileTool::Error: // fall through
+    case KileTool::ProblemError:
+        return KStatefulBrush(KColorScheme::View, KColorScheme::NegativeText).brush(widget).color();
+    case KileTool::ProblemBadBox: {
+        // 'KColorScheme::scheme' doesn't take the background colour into account, so we have to do it manually
+        const QColor color = KStatefulBrush(KColorScheme::View, KColorScheme::NeutralText).brush(widget).color();
+        return (KStatefulBrush(KColorScheme::View, KColorScheme::NormalBackground).brush(widget).color().lightnessF() > 0.5)
+               ? KColorScheme::shade(color, KColorScheme::DarkShade)
+               : KColorScheme::shade(color, KColorScheme::LightShade);
+    }
+    default:
+        return KStatefulBrush(KColorScheme::View, KColorScheme::NormalText).brush(widget).color();
+    }
+}
+
+}
+
+LogModel::LogModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_hideWarnings(false)
+    , m_hideBadBoxes(false)
+    , m_maximumTextWidth(0)
+{
+}
+
+int LogModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant LogModel::data(const QModelIndex& index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+    const Message& msg = message(index.row());
+    switch(role) {
+    case Qt::DisplayRole:
+        return msg.tool.isEmpty() ? msg.text : '[' + msg.tool + "] " + msg.text;
+    case Qt::UserRole:
+        return msg.outputInfo.isValid() ? QVariant::fromValue(msg.outputInfo) : QVariant();
+    case TypeRole:
+        return msg.type;
+    case ToolRole:
+        return msg.tool;
+    case TextRole:
+        return msg.text;
+    case MessageIdRole:
+        return m_rows[index.row()];
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags LogModel::flags(const QModelIndex& index) const
+{
+    if(!index.isValid() || index.row() >= m_rows.size()) {
+        return Qt::NoItemFlags;
+    }
+    // the user can't manually select the lines that don't allow it
+    return message(index.row()).selectable ? (Qt::ItemIsEnabled | Qt::ItemIsSelectable) : Qt::ItemIsEnabled;
+}
+
+bool LogModel::isHidden(const Message& message) const
+{
+    return (message.type == KileTool::ProblemWarning && m_hideWarnings)
+           || (message.type == KileTool::ProblemBadBox && m_hideBadBoxes);
+}
+
+void LogModel::appendMessages(const QVector<Message>& messages, int textWidth)
+{
+    QVector<int> newRows;
+    newRows.reserve(messages.size());
+    for(int i = 0; i < messages.size(); ++i) {
+        if(!isHidden(messages[i])) {
+            newRows.append(m_messages.size() + i);
+        }
+    }
+    m_messages += messages;
+    m_maximumTextWidth = qMax(m_maximumTextWidth, textWidth);
+    if(newRows.isEmpty()) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + newRows.size() - 1);
+    m_rows += newRows;
+    endInsertRows();
+}
+
+void LogModel::clear()
+{
+    beginResetModel();
+    m_messages.clear();
+    m_rows.clear();
+    m_maximumTextWidth = 0;
+    endResetModel();
+}
+
+void LogModel::setHiddenProblems(bool hideWarnings, bool hideBadBoxes)
+{
+    if(hideWarnings == m_hideWarnings && hideBadBoxes == m_hideBadBoxes) {
+        return;
+    }
+    beginResetModel();
+    m_hideWarnings = hideWarnings;
+    m_hideBadBoxes = hideBadBoxes;
+    m_rows.clear();
+    for(int i = 0; i < m_messages.size(); ++i) {
+        if(!isHidden(m_messages[i])) {
+            m_rows.append(i);
+        }
+    }
+    endResetModel();
+}
+
 LogWidgetItemDelegate::LogWidgetItemDelegate(QObject* parent)
     : QItemDelegate(parent)
+    , m_staticTextCache(staticTextCacheSize)
 {
 }
 
-QSize LogWidgetItemDelegate::sizeHint(const QStyleOptionViewItem& /* option */,
+QSize LogWidgetItemDelegate::sizeHint(const QStyleOptionViewItem& option,
                                       const QModelIndex& index) const
 {
-    QTextDocument *textDocument = constructTextDocument(index);
-    QSize size = textDocument->documentLayout()->documentSize().toSize();
-    delete textDocument;
-    return size;
+    // all the lines have the same size; the width is the one of the longest line
+    const LogModel *model = qobject_cast<const LogModel*>(index.model());
+    QFont font = option.font;
+    font.setBold(true);
+    return QSize((model ? model->maximumTextWidth() : 0) + 2 * textMargin,
+                 QFontMetrics(font).height() + 2 * textMargin);
+}
+
+QStaticText* LogWidgetItemDelegate::staticText(const QModelIndex& index) const
+{
+    const int id = index.data(LogModel::MessageIdRole).toInt();
+    QStaticText *staticText = m_staticTextCache.object(id);
+    if(!staticText) {
+        const QString tool = index.data(LogModel::ToolRole).toString();
+        QString html = index.data(LogModel::TextRole).toString().toHtmlEscaped();
+        if(!tool.isEmpty()) {
+            html = "<b>[" + tool.toHtmlEscaped() + "]</b> " + html;
+        }
+        staticText = new QStaticText(html);
+        staticText->setTextFormat(Qt::RichText);
+        staticText->setPerformanceHint(QStaticText::AggressiveCaching);
+        m_staticTextCache.insert(id, staticText);
+    }
+    return staticText;
+}
+
+void LogWidgetItemDelegate::clearCache()
+{
+    m_staticTextCache.clear();
 }
 
 void LogWidgetItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
                                   const QModelIndex& index) const
 {
     painter->save();
-    QAbstractTextDocumentLayout::PaintContext context;
-    QVector<QAbstractTextDocumentLayout::Selection> selectionVector;
 
-    painter->translate(option.rect.x(), option.rect.y());
-    QTextDocument *textDocument = constructTextDocument(index);
+    QFont font = option.font;
+    QColor color = textColor(index.data(LogModel::TypeRole).toInt(), option.widget);
 
     if(option.state & QStyle::State_MouseOver && index.data(Qt::UserRole).isValid()) {
-        QTextCursor cursor(textDocument);
-        cursor.select(QTextCursor::Document);
-        QTextCharFormat format;
-        format.setFontUnderline(true);
-        cursor.mergeCharFormat(format);
+        font.setUnderline(true);
     }
 
     if(option.state & QStyle::State_Selected) {
-        QTextCursor cursor(textDocument);
-        cursor.setPosition(0);
-        cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
-        QTextCharFormat selectionTextCharFormat;
-        selectionTextCharFormat.setFontWeight(QFont::Bold);
-        selectionTextCharFormat.setBackground(option.palette.highlight());
-        selectionTextCharFormat.setForeground(option.palette.highlightedText());
-        QAbstractTextDocumentLayout::Selection selection;
-        selection.cursor = cursor;
-        selection.format = selectionTextCharFormat;
-        selectionVector.push_back(selection);
-        context.selections = selectionVector;
-    }
-
-    textDocument->documentLayout()->draw(painter, context);
-    delete textDocument;
+        font.setBold(true);
+        painter->fillRect(option.rect, option.palette.highlight());
+        color = option.palette.highlightedText().color();
+    }
 
-    painter->restore();
-}
+    painter->setFont(font);
+    painter->setPen(color);
+    painter->drawStaticText(option.rect.topLeft() + QPoint(textMargin, textMargin), *staticText(index));
 
-QTextDocument* LogWidgetItemDelegate::constructTextDocument(const QModelIndex& index) const
-{
-    QTextDocument *textDocument = new QTextDocument();
-    textDocument->setHtml(index.data().toString());
-    return textDocument;
+    painter->restore();
 }
 
 LogWidget::LogWidget(PopupType popupType, QWidget *parent, const char *name) :
-    QListWidget(parent), m_popupType(popupType)
+    QListView(parent), m_popupType(popupType)
 {
     setObjectName(name);
-    connect(this, SIGNAL(itemClicked(QListWidgetItem*)),
-            this, SLOT(slotItemClicked(QListWidgetItem*)));
+    m_model = new LogModel(this);
+    m_model->setHiddenProblems(KileConfig::hideProblemWarning(), KileConfig::hideProblemBadBox());
+    setModel(m_model);
+    connect(this, SIGNAL(clicked(QModelIndex)),
+            this, SLOT(slotItemClicked(QModelIndex)));
     QPalette customPalette = palette();
     customPalette.setColor(QPalette::Window, QColor(Qt::white));
     setPalette(customPalette);
     m_itemDelegate = new LogWidgetItemDelegate(this);
+    connect(m_model, SIGNAL(modelReset()), m_itemDelegate, SLOT(clearCache()));
     setSelectionMode(QAbstractItemView::MultiSelection);
     QAbstractItemDelegate *delegate = itemDelegate();
     if(delegate) {
         delete delegate;
     }
     setItemDelegate(m_itemDelegate);
+    setUniformItemSizes(true);
     setMouseTracking(true);
 }
 
@@ -120,30 +257,31 @@ LogWidget::~LogWidget()
 
 bool LogWidget::isShowingOutput() const
 {
-    return (count() > 0);
+    return (m_model->rowCount() > 0);
 }
 
 void LogWidget::highlight(const OutputInfo& info, bool startFromBottom)
 {
-    for(int i = 0; i < count(); ++i) {
-        QListWidgetItem *listItem = item(startFromBottom ? count() - 1 - i : i);
-        QVariant variant = listItem->data(Qt::UserRole);
-        if(!variant.isValid()) {
+    const int count = m_model->rowCount();
+    for(int i = 0; i < count; ++i) {
+        const int row = startFromBottom ? count - 1 - i : i;
+        const OutputInfo& info2 = m_model->message(row).outputInfo;
+        if(!info2.isValid()) {
             continue;
         }
-        OutputInfo info2 = variant.value<OutputInfo>();
         if(info == info2) {
             deselectAllItems();
-            scrollToItem(listItem);
-            listItem->setSelected(true);
+            const QModelIndex index = m_model->index(row);
+            scrollTo(index);
+            selectionModel()->select(index, QItemSelectionModel::Select);
             break;
         }
     }
 }
 
-void LogWidget::slotItemClicked(QListWidgetItem *item)
+void LogWidget::slotItemClicked(const QModelIndex& index)
 {
-    QVariant variant = item->data(Qt::UserRole);
+    QVariant variant = index.data(Qt::UserRole);
     if(!variant.isValid()) {
         return;
     }
@@ -169,15 +307,22 @@ void LogWidget::mouseMoveEvent(QMouseEvent* event)
     adaptMouseCursor(p);
 }
 
+void LogWidget::showEvent(QShowEvent *event)
+{
+    // the filter might have been changed in another log widget
+    updateProblemFilter();
+    QListView::showEvent(event);
+}
+
 void LogWidget::adaptMouseCursor(const QPoint& p)
 {
-    QListWidgetItem *item = itemAt(p);
-    if(!item) {
+    const QModelIndex index = indexAt(p);
+    if(!index.isValid()) {
         unsetCursor();
         return;
     }
 
-    QVariant variant = item->data(Qt::UserRole);
+    QVariant variant = index.data(Qt::UserRole);
     if(variant.isValid()) {
         setCursor(Qt::PointingHandCursor);
     }
@@ -193,12 +338,7 @@ void LogWidget::keyPressEvent(QKeyEvent *event)
 
 void LogWidget::deselectAllItems()
 {
-    QList<QListWidgetItem*> items = selectedItems();
-    for(QList<QListWidgetItem*>::iterator i = items.begin();
-            i != items.end(); ++i) {
-        QListWidgetItem *item = *i;
-        item->setSelected(false);
-    }
+    selectionModel()->clearSelection();
 }
 
 void LogWidget::printMessage(const QString& message)
@@ -211,80 +351,58 @@ void LogWidget::printMessage(int type, const QString& message, const QString &to
                              const OutputInfo& outputInfo, bool allowSelection,
                              bool scroll)
 {
-    QStringList messageList = message.split('\n');
-    for(QStringList::iterator it = messageList.begin(); it != messageList.end(); ++it) {
-        printMessageLine(type, *it, tool, outputInfo, allowSelection, scroll);
-    }
+    QVector<LogModel::Message> messages;
+    addMessageLines(messages, type, message, tool, outputInfo, allowSelection);
+    appendMessages(messages, scroll);
 }
 
-void LogWidget::printMessageLine(int type, const QString& message, const QString &tool,
-                                 const OutputInfo& outputInfo, bool allowSelection,
-                                 bool scroll)
+void LogWidget::addMessageLines(QVector<LogModel::Message>& messages, int type, const QString& message,
+                                const QString &tool, const OutputInfo& outputInfo, bool allowSelection)
 {
     if(type == KileTool::Error) {
         KILE_DEBUG_MAIN << "showing error message emitted";
         emit showingErrorMessage(this);
     }
 
-    QString myMsg = message.toHtmlEscaped();
-    QString fontColor;
-
-    switch(type) {
-    case KileTool::Warning :
-        fontColor = "<font color='" + KStatefulBrush(KColorScheme::View, KColorScheme::NeutralText).brush(this).color().name() + "'>";
-        break;
-    case KileTool::ProblemWarning :
-        if(KileConfig::hideProblemWarning()) {
-            return;
-        }
-        fontColor = "<font color='" + KStatefulBrush(KColorScheme::View, KColorScheme::NeutralText).brush(this).color().name() + "'>";
-        break;
-    case KileTool::Error: // fall through
-    case KileTool::ProblemError:
-        fontColor = "<font color='" + KStatefulBrush(KColorScheme::View, KColorScheme::NegativeText).brush(this).color().name() + "'>";
-        break;
-    case KileTool::ProblemBadBox:
-        if (KileConfig::hideProblemBadBox()) {
-            return;
-        }
-        {
-            // 'KColorScheme::scheme' doesn't take the background colour into account, so we have to do it manually
-            const QColor color = (KStatefulBrush(KColorScheme::View, KColorScheme::NormalBackground).brush(this).color().lightnessF() > 0.5)
-                                 ? KColorScheme::shade(KStatefulBrush(KColorScheme::View, KColorScheme::NeutralText).brush(this).color(), KColorScheme::DarkShade)
-                                 : KColorScheme::shade(KStatefulBrush(KColorScheme::View, KColorScheme::NeutralText).brush(this).color(), KColorScheme::LightShade);
-            fontColor = "<font color='" + color.name() + "'>";
-        }
-        break;
-    default:
-        fontColor = "<font color='" + KStatefulBrush(KColorScheme::View, KColorScheme::NormalText).brush(this).color().name() + "'>";
-        break;
+    if((type == KileTool::Error || type == KileTool::ProblemError)
+            && !m_firstErrorMessgeInToolLog.isValid()) {
+        m_firstErrorMessgeInToolLog = outputInfo;
     }
 
-    QListWidgetItem *item = new QListWidgetItem(this);
-
-    if(tool.isEmpty()) {
-        item->setText(fontColor + myMsg + "</font>");
-    }
-    else {
-        item->setText(fontColor + "<b>[" + tool + "]</b> " + myMsg + "</font>");
+    LogModel::Message line;
+    line.type = type;
+    line.tool = tool;
+    line.outputInfo = outputInfo;
+    line.selectable = allowSelection;
+    const QStringList messageList = message.split('\n');
+    for(QStringList::const_iterator it = messageList.begin(); it != messageList.end(); ++it) {
+        line.text = *it;
+        messages.append(line);
     }
+}
 
-
-    if(outputInfo.isValid()) {
-        item->setData(Qt::UserRole, QVariant::fromValue(outputInfo));
-    }
-    if(!allowSelection) {
-        // Don't allow the user to manually select this item
-        item->setFlags(item->flags() & ~Qt::ItemIsSelectable);
+void LogWidget::appendMessages(const QVector<LogModel::Message>& messages, bool scroll)
+{
+    // the lines are drawn in bold when they are selected
+    QFont font = this->font();
+    font.setBold(true);
+    const QFontMetrics fontMetrics(font);
+    int textWidth = 0;
+    for(QVector<LogModel::Message>::const_iterator it = messages.begin(); it != messages.end(); ++it) {
+        const LogModel::Message& message = *it;
+        const QString text = message.tool.isEmpty() ? message.text : '[' + message.tool + "] " + message.text;
+        textWidth = qMax(textWidth, fontMetrics.horizontalAdvance(text));
     }
 
-    if((type == KileTool::Error || type == KileTool::ProblemError)
-            && !m_firstErrorMessgeInToolLog.isValid()) {
-        m_firstErrorMessgeInToolLog = outputInfo;
+    const bool widthChanged = (textWidth > m_model->maximumTextWidth());
+    m_model->appendMessages(messages, textWidth);
+    if(widthChanged) {
+        // the size of the lines is only computed once for all of them
+        scheduleDelayedItemsLayout();
     }
 
     if(scroll) {
-        scrollToItem(item);
+        scrollToBottom();
     }
 }
 
@@ -296,12 +414,12 @@ void LogWidget::printProblem(int type, const QString& problem, const OutputInfo&
 
 void LogWidget::printProblems(const QList<KileWidget::LogWidget::ProblemInformation>& list)
 {
-    setUpdatesEnabled(false);
+    QVector<LogModel::Message> messages;
+    messages.reserve(list.size());
     for(QList<ProblemInformation>::const_iterator i = list.begin(); i != list.end(); ++i) {
-        printMessage((*i).type, (*i).message, QString(), (*i).outputInfo, false, false);
+        addMessageLines(messages, (*i).type, (*i).message, QString(), (*i).outputInfo, false);
     }
-    setUpdatesEnabled(true);
-    scrollToBottom();
+    appendMessages(messages, true);
 }
 
 void LogWidget::addEmptyLine()
@@ -311,28 +429,22 @@ void LogWidget::addEmptyLine()
 
 void LogWidget::copy()
 {
-    QList<QListWidgetItem*> selectedList = selectedItems();
+    QModelIndexList selectedList = selectionModel()->selectedIndexes();
+    std::sort(selectedList.begin(), selectedList.end());
     QString toCopy;
-    int maxIndex = 0;
-    QHash<int, QListWidgetItem*> itemHash;
-    for(QList<QListWidgetItem*>::iterator i = selectedList.begin();
-            i != selectedList.end(); ++i) {
-        QListWidgetItem* item = *i;
-        int row = indexFromItem(item).row();
-        itemHash[row] = item;
-        maxIndex = qMax(maxIndex, row);
-    }
-    for(int i = 0; i <= maxIndex; ++i) {
-        QHash<int, QListWidgetItem*>::iterator it = itemHash.find(i);
-        if(it != itemHash.end()) {
-            toCopy += (*it)->data(Qt::UserRole).value<OutputInfo>().message() + '\n';
-        }
+    for(QModelIndexList::const_iterator i = selectedList.begin(); i != selectedList.end(); ++i) {
+        toCopy += m_model->message((*i).row()).outputInfo.message() + '\n';
     }
     if(!toCopy.isEmpty()) {
         QApplication::clipboard()->setText(toCopy);
     }
 }
 
+void LogWidget::clear()
+{
+    m_model->clear();
+}
+
 void LogWidget::startToolLogOutput()
 {
     m_firstErrorMessgeInToolLog = OutputInfo();
@@ -351,7 +463,7 @@ void LogWidget::contextMenuEvent(QContextMenuEvent *event)
 
     QAction *action = KStandardAction::copy(this, SLOT(copy()), this);
     action->setShortcuts(QList<QKeySequence>());
-    if(selectedItems().size() == 0) {
+    if(!selectionModel()->hasSelection()) {
         action->setEnabled(false);
     }
     popup.addAction(action);
@@ -386,17 +498,25 @@ void LogWidget::contextMenuEvent(QContextMenuEvent *event)
 void LogWidget::toggleBadBoxHiding()
 {
     KileConfig::setHideProblemBadBox(!KileConfig::hideProblemBadBox());
+    updateProblemFilter();
 }
 
 void LogWidget::toggleWarningsHiding()
 {
     KileConfig::setHideProblemWarning(!KileConfig::hideProblemWarning());
+    updateProblemFilter();
+}
+
+void LogWidget::updateProblemFilter()
+{
+    m_model->setHiddenProblems(KileConfig::hideProblemWarning(), KileConfig::hideProblemBadBox());
 }
 
 bool LogWidget::containsSelectableItems() const
 {
-    for(int i = 0; i < count(); ++i) {
-        if(item(i)->flags() & Qt::ItemIsSelectable) {
+    const int count = m_model->rowCount();
+    for(int i = 0; i < count; ++i) {
+        if(m_model->message(i).selectable) {
             return true;
         }
     }
@@ -405,4 +525,3 @@ bool LogWidget::containsSelectableItems() const
 }
 
 }
-
@@ -15,10 +15,12 @@
 #ifndef LOGWIDGET_H
 #define LOGWIDGET_H
 
+#include <QAbstractListModel>
+#include <QCache>
 #include <QItemDelegate>
-#include <QTextDocument>
-
-#include <QListWidget>
+#include <QListView>
+#include <QStaticText>
+#include <QVector>
 
 #include "outputinfo.h"
 
@@ -29,6 +31,64 @@ class KileInfo;
 class QUrl;
 
 namespace KileWidget {
+
+/**
+ * Stores the lines that are shown in a log widget. All the lines are kept, but only those that
+ * aren't hidden by the current filter are rows of the model, so changing the filter is cheap.
+ *
+ * The role Qt::UserRole contains the OutputInfo of a line if it has a valid one.
+ **/
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles { TypeRole = Qt::UserRole + 1, ToolRole, TextRole, MessageIdRole };
+
+    struct Message {
+        int type;
+        QString tool;
+        QString text;
+        OutputInfo outputInfo;
+        bool selectable;
+    };
+
+    explicit LogModel(QObject *parent = Q_NULLPTR);
+
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    virtual Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+    const Message& message(int row) const {
+        return m_messages[m_rows[row]];
+    }
+
+    /**
+     * 'textWidth' is the largest width of the given lines when they are drawn.
+     **/
+    void appendMessages(const QVector<Message>& messages, int textWidth);
+    void clear();
+
+    void setHiddenProblems(bool hideWarnings, bool hideBadBoxes);
+
+    int maximumTextWidth() const {
+        return m_maximumTextWidth;
+    }
+
+private:
+    QVector<Message> m_messages;
+    // indices of the visible messages
+    QVector<int> m_rows;
+    bool m_hideWarnings, m_hideBadBoxes;
+    int m_maximumTextWidth;
+
+    bool isHidden(const Message& message) const;
+};
+
+/**
+ * Draws the lines of a log widget; all of them have the same height, and the text layout of the
+ * lines that have been drawn most recently is kept.
+ **/
 class LogWidgetItemDelegate : public QItemDelegate
 {
     Q_OBJECT
@@ -39,15 +99,21 @@ public:
     virtual QSize sizeHint(const QStyleOptionViewItem& option,
                            const QModelIndex& index) const override;
 
+public Q_SLOTS:
+    void clearCache();
+
 protected:
     virtual void paint(QPainter* painter,
                        const QStyleOptionViewItem& option,
                        const QModelIndex & index) const override;
 
-    QTextDocument* constructTextDocument(const QModelIndex& index) const;
+    QStaticText* staticText(const QModelIndex& index) const;
+
+private:
+    mutable QCache<int, QStaticText> m_staticTextCache;
 };
 
-class LogWidget : public QListWidget
+class LogWidget : public QListView
 {
     Q_OBJECT
 
@@ -78,6 +144,7 @@ public Q_SLOTS:
     void addEmptyLine();
 
     void copy();
+    void clear();
 
     void startToolLogOutput();
     void endToolLogOutput();
@@ -90,26 +157,29 @@ protected:
     virtual void enterEvent(QEvent *event) override;
     virtual void leaveEvent(QEvent *event) override;
     virtual void mouseMoveEvent(QMouseEvent* event) override;
+    virtual void showEvent(QShowEvent *event) override;
 
     void adaptMouseCursor(const QPoint& p);
     virtual void keyPressEvent(QKeyEvent *event) override;
 
     virtual void contextMenuEvent(QContextMenuEvent *event) override;
 
-    void printMessageLine(int type, const QString& message, const QString &tool = "Kile",
-                          const OutputInfo& outputInfo = OutputInfo(), bool allowSelection = false,
-                          bool scroll = true);
+    void addMessageLines(QVector<LogModel::Message>& messages, int type, const QString& message,
+                         const QString &tool, const OutputInfo& outputInfo, bool allowSelection);
+    void appendMessages(const QVector<LogModel::Message>& messages, bool scroll);
 
 protected Q_SLOTS:
-    void slotItemClicked(QListWidgetItem *item);
+    void slotItemClicked(const QModelIndex& index);
     void deselectAllItems();
 
     void toggleBadBoxHiding();
     void toggleWarningsHiding();
+    void updateProblemFilter();
 
 private:
     int 			m_popupType;
     int			m_idWarning, m_idBadBox;
+    LogModel		*m_model;
     LogWidgetItemDelegate	*m_itemDelegate;
     OutputInfo 		m_firstErrorMessgeInToolLog;
 
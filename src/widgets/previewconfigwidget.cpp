@@ -157,9 +157,13 @@ KileWidgetPreviewConfig::KileWidgetPreviewConfig(KConfig *config, KileTool::Quic
     previewLayout->setColumnMinimumWidth(3, 40);
     previewLayout->setColumnStretch(5, 1);
 
+    m_cbPrecompilePreamble = new QCheckBox(i18n("&Precompile the preamble of the master document (LaTeX and PDFLaTeX only)"), this);
+    m_cbPrecompilePreamble->setToolTip(i18n("Compile the preamble only once into a format file with the mylatexformat package"));
+
     vbox->addWidget(groupbox);
     vbox->addWidget(gbResolution);
     vbox->addWidget(m_gbPreview);
+    vbox->addWidget(m_cbPrecompilePreamble);
     vbox->addStretch();
 
     connect(m_cbEnvironment, SIGNAL(clicked()), this, SLOT(updateConversionTools()));
@@ -176,6 +180,8 @@ void KileWidgetPreviewConfig::readConfig()
     setupProperties();
 
     updateConversionTools();
+
+    m_cbPrecompilePreamble->setChecked(KileConfig::previewPrecompilePreamble());
 }
 
 void KileWidgetPreviewConfig::writeConfig()
@@ -211,6 +217,8 @@ void KileWidgetPreviewConfig::writeConfig()
     KileConfig::setSelPreviewTool(index2tool(m_coSelection->currentIndex()));
     KileConfig::setEnvPreviewTool(index2tool(m_coEnvironment->currentIndex()));
     KileConfig::setMathgroupPreviewTool(index2tool(m_coMathgroup->currentIndex()));
+
+    KileConfig::setPreviewPrecompilePreamble(m_cbPrecompilePreamble->isChecked());
 }
 
 void KileWidgetPreviewConfig::setupSeparateWindow()
@@ -48,6 +48,7 @@ private:
     QLineEdit *m_leDvipngResolution;
     QLabel *m_lbDvipng, *m_lbConvert;
     QCheckBox *m_cbEnvironment, *m_cbSelection, *m_cbMathgroup;
+    QCheckBox *m_cbPrecompilePreamble;
     KComboBox *m_coSelection, *m_coEnvironment, *m_coMathgroup;
     QGroupBox *m_gbPreview;
     KColorButton *m_backgroundColorButton;
@@ -64,7 +64,6 @@
 #include <QMimeDatabase>
 #include <QMimeType>
 #include <QRegExp>
-#include <QScrollBar>
 #include <QUrl>
 
 #include <KApplicationTrader>
@@ -119,6 +118,22 @@ void StructureViewItem::setItemEntry()
     setToolTip(0, text(0));
 }
 
+void StructureViewItem::setPosition(uint line, uint column, uint startline, uint startcol)
+{
+    m_column = column;
+    m_startline = startline;
+    m_startcol = startcol;
+    if(m_line == line) {
+        return;
+    }
+    m_line = line;
+    // keep the tool tip showing the label
+    setText(0, i18nc("structure view entry: title (line)", "%1 (line %2)", m_title, QString::number(m_line)));
+    if(m_label.isEmpty()) {
+        setToolTip(0, text(0));
+    }
+}
+
 void StructureViewItem::setLabel(const QString &label)
 {
     m_label = label;
@@ -127,6 +142,28 @@ void StructureViewItem::setLabel(const QString &label)
     }
 }
 
+void StructureViewItem::assign(const StructureViewItem *item)
+{
+    m_title = item->m_title;
+    m_url = item->m_url;
+    m_line = item->m_line;
+    m_column = item->m_column;
+    m_startline = item->m_startline;
+    m_startcol = item->m_startcol;
+    m_label = item->m_label;
+    // every change of the texts leads to a repaint
+    if(text(0) != item->text(0)) {
+        setText(0, item->text(0));
+    }
+    if(toolTip(0) != item->toolTip(0)) {
+        setToolTip(0, item->toolTip(0));
+    }
+    // the icons are taken from the theme, i.e. they can be compared by their names
+    if(icon(0).name() != item->icon(0).name() || icon(0).isNull() != item->icon(0).isNull()) {
+        setIcon(0, item->icon(0));
+    }
+}
+
 ////////////////////// StructureView tree widget //////////////////////
 
 StructureView::StructureView(StructureWidget *stack, KileDocument::Info *docinfo) :
@@ -167,16 +204,12 @@ void StructureView::init()
                 this, SLOT(addItem(QString,uint,uint,int,int,uint,uint,QString,QString)));
     }
 
-    m_parent[0]=m_parent[1]=m_parent[2]=m_parent[3]=m_parent[4]=m_parent[5]=m_parent[6]=m_root;
-    m_lastType = KileStruct::None;
-    m_lastSectioning = Q_NULLPTR;
-    m_lastFloat = Q_NULLPTR;
-    m_lastFrame = Q_NULLPTR;
-    m_lastFrameEnv = Q_NULLPTR;
+    resetParents();
     m_stop = false;
 
     m_folders.clear();
     m_references.clear();
+    m_addedItems.clear();
 
     if(m_docinfo) {
         m_openStructureLabels = m_docinfo->openStructureLabels();
@@ -194,6 +227,16 @@ void StructureView::init()
     }
 }
 
+void StructureView::resetParents()
+{
+    m_parent[0]=m_parent[1]=m_parent[2]=m_parent[3]=m_parent[4]=m_parent[5]=m_parent[6]=m_root;
+    m_lastType = KileStruct::None;
+    m_lastSectioning = Q_NULLPTR;
+    m_lastFloat = Q_NULLPTR;
+    m_lastFrame = Q_NULLPTR;
+    m_lastFrameEnv = Q_NULLPTR;
+}
+
 void StructureView::updateRoot()
 {
     m_root->setURL( m_docinfo->url() );
@@ -319,6 +362,28 @@ bool StructureView::shouldBeOpen(StructureViewItem *item, const QString & folder
     }
 }
 
+void StructureView::setItemExpanded(StructureViewItem *item, bool expanded)
+{
+    // items that are not part of the view cannot be expanded yet
+    if(item->treeWidget()) {
+        item->setExpanded(expanded);
+    }
+    else {
+        m_expansionOfNewItems[item] = expanded;
+    }
+}
+
+void StructureView::expandInsertedItems(StructureViewItem *item)
+{
+    QHash<StructureViewItem*, bool>::const_iterator it = m_expansionOfNewItems.constFind(item);
+    if(it != m_expansionOfNewItems.constEnd()) {
+        item->setExpanded(*it);
+    }
+    for(int i = 0; i < item->childCount(); ++i) {
+        expandInsertedItems(static_cast<StructureViewItem*>(item->child(i)));
+    }
+}
+
 StructureViewItem* StructureView::createFolder(const QString &folder)
 {
     StructureViewItem *fldr = new StructureViewItem(folder);
@@ -442,6 +507,7 @@ void StructureView::addItem(const QString &title, uint line, uint column, int ty
     if(m_stop) {
         return;
     }
+    m_addedItems.append({title, type, lev, line, Q_NULLPTR});
 
     // some types need a special action
     if(type == KileStruct::Reference) {
@@ -509,6 +575,7 @@ void StructureView::addItem(const QString &title, uint line, uint column, int ty
 
     // create a new item
     StructureViewItem *newChild = new StructureViewItem(parentItem, title, m_docinfo->url(), line, column, type, lev, startline, startcol);
+    m_addedItems.last().item = newChild;
     if(!pix.isEmpty()) {
         newChild->setIcon(0, QIcon::fromTheme(pix));
     }
@@ -516,7 +583,7 @@ void StructureView::addItem(const QString &title, uint line, uint column, int ty
 
     //if the level is not greater than the defaultLevel
     //open the parentItem to make this item visible
-    parentItem->setExpanded(shouldBeOpen(parentItem, fldr, lev));
+    setItemExpanded(parentItem, shouldBeOpen(parentItem, fldr, lev));
 
     //update the m_parent levels, such that section etc. get inserted at the correct level
     //m_current = newChild;
@@ -548,39 +615,225 @@ void StructureView::addItem(const QString &title, uint line, uint column, int ty
     }
 }
 
-void StructureView::showReferences(KileInfo *ki)
+bool StructureView::updateItemPositions(const QLinkedList<KileParser::StructureViewItem*>& items)
 {
-    // remove old listview item for references, if it exists
-    if(m_folders.contains("refs")) {
-        StructureViewItem *refitem = m_folders["refs"];
-        m_root->removeChild(refitem);
-        delete refitem;
+    if(m_addedItems.size() != items.size()) {
+        return false;
+    }
+
+    // labels are assigned to sectioning items if they are found on the same or on the next
+    // line, hence we also have to check that the distances between the items stay the same
+    int index = 0;
+    uint previousLine = 0;
+    for(KileParser::StructureViewItem *item : items) {
+        const AddedItem &addedItem = m_addedItems[index];
+        if(addedItem.type != item->type || addedItem.level != item->level || addedItem.title != item->title) {
+            return false;
+        }
+        if(index > 0) {
+            const bool wasClose = (addedItem.line <= m_addedItems[index - 1].line + 1);
+            const bool isClose = (item->line <= previousLine + 1);
+            if(wasClose != isClose) {
+                return false;
+            }
+        }
+        previousLine = item->line;
+        ++index;
+    }
+
+    m_references.clear();
+    index = 0;
+    for(KileParser::StructureViewItem *item : items) {
+        AddedItem &addedItem = m_addedItems[index++];
+        addedItem.line = item->line;
+        if(item->type == KileStruct::Reference) {
+            m_references.prepend(KileReferenceData(item->title, item->line, item->column));
+        }
+        if(addedItem.item) {
+            addedItem.item->setPosition(item->line, item->column, item->startline, item->startcol);
+        }
+    }
+    return true;
+}
+
+void StructureView::updateItems(const QLinkedList<KileParser::StructureViewItem*>& items)
+{
+    KILE_DEBUG_MAIN << "==void StructureView::updateItems()========";
+
+    // build the new tree outside of the view
+    StructureViewItem *root = m_root;
+    const QMap<QString, StructureViewItem*> folders = m_folders;
+    StructureViewItem *newRoot = new StructureViewItem(QString());
+    m_root = newRoot;
+    resetParents();
+    m_folders.clear();
+    m_references.clear();
+    m_addedItems.clear();
+    m_stop = false;
+    for(KileParser::StructureViewItem *item : items) {
+        addItem(item->title, item->line, item->column, item->type, item->level, item->startline, item->startcol, item->pix, item->folder);
+    }
+    m_root = root;
+    m_folders = folders;
+
+    // maps the items of the new tree to the items in the view that have been kept
+    QHash<StructureViewItem*, StructureViewItem*> itemMap;
+    mergeChildren(m_root, newRoot, itemMap);
+    delete newRoot;
+    m_expansionOfNewItems.clear();
 
-        m_folders.remove("refs");
+    m_folders.clear();
+    for(int i = 0; i < m_root->childCount(); ++i) {
+        StructureViewItem *child = static_cast<StructureViewItem*>(m_root->child(i));
+        if(child->type() == KileStruct::None) {
+            m_folders[child->title()] = child;
+        }
     }
+    for(AddedItem &addedItem : m_addedItems) {
+        if(addedItem.item) {
+            addedItem.item = itemMap.value(addedItem.item, addedItem.item);
+        }
+    }
+    // the pointers into the new tree aren't valid anymore
+    resetParents();
 
+    // the saved state was only needed for the items that haven't been shown before
+    m_openByTitle.clear();
+    m_openByLine.clear();
+}
+
+namespace {
+
+inline QString mergeKey(const StructureViewItem *item)
+{
+    return QString::number(item->type()) + ':' + QString::number(item->level()) + ':' + item->title();
+}
+
+}
+
+void StructureView::mergeChildren(StructureViewItem *item, StructureViewItem *newItem,
+                                  QHash<StructureViewItem*, StructureViewItem*>& itemMap)
+{
+    StructureViewItem *refsFolder = m_folders.value("refs");
+
+    QVector<StructureViewItem*> children(item->childCount());
+    QHash<QString, QList<int> > childIndices;
+    for(int i = 0; i < children.size(); ++i) {
+        children[i] = static_cast<StructureViewItem*>(item->child(i));
+        if(children[i] != refsFolder) {
+            childIndices[mergeKey(children[i])].append(i);
+        }
+    }
+
+    // match the new children in their order with the existing ones
+    QVector<StructureViewItem*> newChildren(newItem->childCount());
+    QVector<int> matches(newChildren.size(), -1);
+    int lastMatch = -1;
+    for(int i = 0; i < newChildren.size(); ++i) {
+        newChildren[i] = static_cast<StructureViewItem*>(newItem->child(i));
+        QHash<QString, QList<int> >::iterator it = childIndices.find(mergeKey(newChildren[i]));
+        if(it == childIndices.end()) {
+            continue;
+        }
+        QList<int> &indices = *it;
+        while(!indices.isEmpty() && indices.first() <= lastMatch) {
+            indices.removeFirst();
+        }
+        if(!indices.isEmpty()) {
+            matches[i] = lastMatch = indices.takeFirst();
+        }
+    }
+
+    int position = 0;
+    for(int i = 0; i < newChildren.size(); ++i) {
+        StructureViewItem *newChild = newChildren[i];
+        if(matches[i] < 0) {
+            newItem->removeChild(newChild);
+            item->insertChild(position++, newChild);
+            expandInsertedItems(newChild);
+            continue;
+        }
+
+        // remove the children in front of the matching one that don't exist anymore
+        StructureViewItem *child = children[matches[i]];
+        while(item->child(position) != child) {
+            if(item->child(position) == refsFolder) {
+                ++position;
+            }
+            else {
+                delete item->takeChild(position);
+            }
+        }
+        ++position;
+
+        const bool hadChildren = (child->childCount() > 0);
+        child->assign(newChild);
+        itemMap.insert(newChild, child);
+        mergeChildren(child, newChild, itemMap);
+        // an item that hasn't had any children before is expanded like a new item
+        if(!hadChildren && child->childCount() > 0) {
+            QHash<StructureViewItem*, bool>::const_iterator it = m_expansionOfNewItems.constFind(newChild);
+            if(it != m_expansionOfNewItems.constEnd()) {
+                child->setExpanded(*it);
+            }
+        }
+    }
+    while(position < item->childCount()) {
+        if(item->child(position) == refsFolder) {
+            ++position;
+        }
+        else {
+            delete item->takeChild(position);
+        }
+    }
+}
+
+void StructureView::showReferences(KileInfo *ki)
+{
     //KILE_DEBUG_MAIN << "==void StructureView::showReferences()========";
     //KILE_DEBUG_MAIN << "\tfound " << m_references.count() << " references";
-    if(m_references.count() == 0) {
-        return;
-    }
 
-    // read list with all labels
-    QStringList list = ki->allLabels();
-    //KILE_DEBUG_MAIN << "\tfound " << list.count() << " labels";
-    QMap<QString,bool> labelmap;
-    for (QStringList::const_iterator itmap = list.constBegin(); itmap != list.constEnd(); ++itmap) {
-        labelmap[(*itmap)] = true;
+    // the undefined references are collected outside of the view first, such that only the
+    // items that have changed have to be updated
+    StructureViewItem *newFolder = new StructureViewItem(QStringLiteral("refs"));
+    if(m_references.count() > 0) {
+        // the labels are looked up in all the documents that are visible from the current one
+        const KileDocument::SymbolScope scope = ki->symbolScope();
+        const KileDocument::SymbolIndex *symbolIndex = ki->docManager()->symbolIndex();
+        // most labels are referenced several times
+        QHash<QString, bool> definedLabels;
+
+        // now check if there are unsolved references
+        for (QList<KileReferenceData>::const_iterator it = m_references.constBegin(); it!=m_references.constEnd(); ++it) {
+            QHash<QString, bool>::iterator defined = definedLabels.find((*it).name());
+            if(defined == definedLabels.end()) {
+                defined = definedLabels.insert((*it).name(), symbolIndex->contains(KileDocument::SymbolIndex::Labels, (*it).name(), scope));
+            }
+            if(!*defined) {
+                new StructureViewItem(newFolder, (*it).name(), m_docinfo->url(), (*it).line(), (*it).column(), KileStruct::Reference, KileStruct::NotSpecified, 0, 0);
+            }
+        }
     }
 
-    // now check if there are unsolved references
-    for (QList<KileReferenceData>::const_iterator it = m_references.constBegin(); it!=m_references.constEnd(); ++it) {
-        if(!labelmap.contains((*it).name())) {
-            StructureViewItem *refitem = folder("refs");
-            refitem->setExpanded(shouldBeOpen(refitem, "refs", 0));
-            new StructureViewItem(refitem, (*it).name(), m_docinfo->url(), (*it).line(), (*it).column(), KileStruct::Reference, KileStruct::NotSpecified, 0, 0);
+    StructureViewItem *refitem = m_folders.value("refs");
+    if(newFolder->childCount() == 0) {
+        // remove old listview item for references, if it exists
+        if(refitem) {
+            m_root->removeChild(refitem);
+            delete refitem;
+            m_folders.remove("refs");
         }
     }
+    else if(refitem) {
+        QHash<StructureViewItem*, StructureViewItem*> itemMap;
+        mergeChildren(refitem, newFolder, itemMap);
+    }
+    else {
+        refitem = folder("refs");
+        refitem->addChildren(newFolder->takeChildren());
+        refitem->setExpanded(shouldBeOpen(refitem, "refs", 0));
+    }
+    delete newFolder;
 }
 
 ////////////////////// StructureWidget: QWidgetStack //////////////////////
@@ -935,7 +1188,8 @@ void StructureWidget::update(KileDocument::Info *docinfo, bool forceParsing)
     view->activate();
 }
 
-void StructureWidget::updateAfterParsing(KileDocument::Info *info, const QLinkedList<KileParser::StructureViewItem*>& items)
+void StructureWidget::updateAfterParsing(KileDocument::Info *info, const QLinkedList<KileParser::StructureViewItem*>& items,
+                                         bool onlyPositionsChanged)
 {
     KILE_DEBUG_MAIN;
     StructureView *view = viewFor(info);
@@ -944,18 +1198,17 @@ void StructureWidget::updateAfterParsing(KileDocument::Info *info, const QLinked
         return;
     }
 
-    int xtop = view->horizontalScrollBar()->value();
-    int ytop = view->verticalScrollBar()->value();
+    // after an incremental parsing run, the items often only have to be moved
+    if(onlyPositionsChanged && view->updateItemPositions(items)) {
+        view->showReferences(m_ki);
+        return;
+    }
+
     // avoid flickering when parsing
     view->setUpdatesEnabled(false);
-    view->cleanUp();
-    Q_FOREACH( KileParser::StructureViewItem *item, items) {
-        view->addItem(item->title, item->line, item->column, item->type, item->level, item->startline, item->startcol, item->pix, item->folder);
-    }
-    view->setUpdatesEnabled(true);
+    view->updateItems(items);
     view->showReferences(m_ki);
-    view->horizontalScrollBar()->setValue(xtop);
-    view->verticalScrollBar()->setValue(ytop);
+    view->setUpdatesEnabled(true);
 }
 
 void StructureWidget::clean(KileDocument::Info *docinfo)
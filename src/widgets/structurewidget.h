@@ -17,10 +17,12 @@
 #ifndef STRUCTUREWIDGET_H
 #define STRUCTUREWIDGET_H
 
+#include <QHash>
 #include <QList>
 #include <QStackedWidget>
 #include <QToolTip>
 #include <QTreeWidget>
+#include <QVector>
 
 #include <QMenu>
 #include <KService>
@@ -87,6 +89,10 @@ public:
 
     void setTitle(const QString &title);
     void setLabel(const QString &label);
+    void setPosition(uint line, uint column, uint startline, uint startcol);
+
+    /** Takes over the title, label and position of 'item', which has to be of the same type. **/
+    void assign(const StructureViewItem *item);
 
 private:
     QString  m_title;
@@ -138,6 +144,21 @@ public:
     void cleanUp(bool preserveState = true);
     void showReferences(KileInfo *ki);
 
+    /**
+     * Updates the positions of the items in place if the view has been filled with items that
+     * only differ from 'items' in their positions.
+     * @returns true iff the positions could be updated
+     **/
+    bool updateItemPositions(const QLinkedList<KileParser::StructureViewItem*>& items);
+
+    /**
+     * Updates the view such that it shows 'items'. The new tree is built outside of the view
+     * and then compared with the items that are shown: only the items that have been added
+     * or removed are inserted into or taken out of the view, the remaining ones are updated
+     * in place and keep their expansion state.
+     **/
+    void updateItems(const QLinkedList<KileParser::StructureViewItem*>& items);
+
     QUrl url() const {
         return m_docinfo->url();
     }
@@ -155,11 +176,37 @@ private:
     StructureViewItem* parentFor(int lev, const QString &fldr);
 
     void init();
+    void resetParents();
     StructureViewItem* createFolder(const QString &folder);
     StructureViewItem* folder(const QString &folder);
 
     void saveState();
     bool shouldBeOpen(StructureViewItem *item, const QString &folder, int level);
+    void setItemExpanded(StructureViewItem *item, bool expanded);
+    void expandInsertedItems(StructureViewItem *item);
+
+    /**
+     * Makes the children of 'item' equal to the children of 'newItem', which is not part of
+     * the view. Children with the same type, level and title are matched in their order; the
+     * new items that have been matched are mapped to the existing items in 'itemMap'. The
+     * folder of the undefined references is left untouched.
+     **/
+    void mergeChildren(StructureViewItem *item, StructureViewItem *newItem,
+                       QHash<StructureViewItem*, StructureViewItem*>& itemMap);
+
+    // the items that have been passed to 'addItem' together with the
+    // list view items that have been created for them (if any)
+    struct AddedItem {
+        QString title;
+        int type;
+        int level;
+        uint line;
+        StructureViewItem *item;
+    };
+    QVector<AddedItem> m_addedItems;
+
+    // the expansion state of the items that haven't been inserted into the view yet
+    QHash<StructureViewItem*, bool> m_expansionOfNewItems;
 
 private:
     StructureWidget				*m_stack;
@@ -205,7 +252,8 @@ public:
                         int col, bool backwards, bool checkLevel, int &sectRow, int &sectCol);
     void updateUrl(KileDocument::Info *docinfo);
 
-    void updateAfterParsing(KileDocument::Info *info, const QLinkedList<KileParser::StructureViewItem*>& items);
+    void updateAfterParsing(KileDocument::Info *info, const QLinkedList<KileParser::StructureViewItem*>& items,
+                            bool onlyPositionsChanged = false);
 
     enum { SectioningCut = 10, SectioningCopy = 11, SectioningPaste = 12,
            SectioningSelect = 13, SectioningDelete = 14,
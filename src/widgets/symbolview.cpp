@@ -33,12 +33,22 @@ tbraun 2007-06-13
 #include "symbolview.h"
 
 #include <QApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QHelpEvent>
+#include <QImageReader>
 #include <QMouseEvent>
 #include <QPixmap>
 #include <QPainter>
 #include <QRegExp>
+#include <QScrollBar>
 #include <QStringList>
 #include <QTextDocument>
+#include <QTimer>
+#include <QToolTip>
+#include <QVector>
 
 #include <KColorScheme>
 #include <KConfig>
@@ -56,8 +66,93 @@ tbraun 2007-06-13
 
 namespace KileWidget {
 
+namespace {
+
+/**
+ * The symbols shipped with Kile, which are read from the atlas generated at build time.
+ * The index is read when the first symbol view is filled, and the image is only decoded
+ * once a symbol has to be shown.
+ **/
+class SymbolAtlas
+{
+public:
+    SymbolAtlas() : m_indexLoaded(false), m_imageLoaded(false) {}
+
+    // returns -1 if the image 'path' isn't contained in the atlas
+    int indexOf(const QString &path)
+    {
+        loadIndex();
+        const QFileInfo fileInfo(path);
+        return m_indexByName.value(fileInfo.dir().dirName() + '/' + fileInfo.fileName(), -1);
+    }
+
+    const SymbolAtlasEntry& entry(int index) const
+    {
+        return m_entries[index];
+    }
+
+    QImage image(int index)
+    {
+        if(!m_imageLoaded) {
+            m_imageLoaded = true;
+            const QString fileName = KileUtilities::locate(QStandardPaths::AppDataLocation, QLatin1String("mathsymbols/symbols-atlas.png"));
+            if(!m_image.load(fileName)) {
+                KILE_DEBUG_MAIN << "Loading the symbol atlas" << fileName << "failed";
+            }
+        }
+        return m_image.copy(m_entries[index].rect);
+    }
+
+private:
+    bool m_indexLoaded;
+    bool m_imageLoaded;
+    QVector<SymbolAtlasEntry> m_entries;
+    // maps "<group>/<file name>" to the entry
+    QHash<QString, int> m_indexByName;
+    QImage m_image;
+
+    void loadIndex()
+    {
+        if(m_indexLoaded) {
+            return;
+        }
+        m_indexLoaded = true;
+
+        QFile file(KileUtilities::locate(QStandardPaths::AppDataLocation, QLatin1String("mathsymbols/symbols-atlas.index")));
+        if(!file.open(QIODevice::ReadOnly)) {
+            KILE_DEBUG_MAIN << "no symbol atlas found, the symbols are loaded from the individual images";
+            return;
+        }
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_6);
+        quint32 magic = 0, version = 0;
+        qint32 count = 0;
+        stream >> magic >> version >> count;
+        if(magic != SYMBOL_ATLAS_MAGIC || version != SYMBOL_ATLAS_VERSION || count < 0) {
+            KILE_DEBUG_MAIN << "ignoring symbol atlas with wrong version";
+            return;
+        }
+        m_entries.resize(count);
+        for(int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            stream >> m_entries[i];
+        }
+        if(stream.status() != QDataStream::Ok) {
+            KILE_DEBUG_MAIN << "the symbol atlas index is corrupted";
+            m_entries.clear();
+            return;
+        }
+        for(int i = 0; i < m_entries.size(); ++i) {
+            m_indexByName.insert(m_entries[i].group + '/' + m_entries[i].fileName, i);
+        }
+    }
+};
+
+Q_GLOBAL_STATIC(SymbolAtlas, symbolAtlas)
+
+}
+
 SymbolView::SymbolView(KileInfo *kileInfo, QWidget *parent, int type, const char *name)
-    : QListWidget(parent), m_ki(kileInfo)
+    : QListWidget(parent), m_ki(kileInfo), m_recolorSymbols(type != User)
 {
     setObjectName(name);
     setViewMode(IconMode);
@@ -72,6 +167,14 @@ SymbolView::SymbolView(KileInfo *kileInfo, QWidget *parent, int type, const char
     setFlow(LeftToRight);
     setDragDropMode(NoDragDrop);
     m_brush = KStatefulBrush(KColorScheme::View, KColorScheme::NormalText);
+
+    // the symbols are only rendered once they become visible
+    m_renderTimer = new QTimer(this);
+    m_renderTimer->setSingleShot(true);
+    m_renderTimer->setInterval(0);
+    connect(m_renderTimer, &QTimer::timeout, this, &SymbolView::renderVisibleSymbols);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, m_renderTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+
     initPage(type);
 }
 
@@ -245,6 +348,82 @@ QString SymbolView::getToolTip(const QString &key)
     return label;
 }
 
+bool SymbolView::viewportEvent(QEvent *event)
+{
+    // the tool tips are built when they are needed
+    if(event->type() == QEvent::ToolTip) {
+        QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
+        QListWidgetItem *item = itemAt(helpEvent->pos());
+        if(item) {
+            QToolTip::showText(helpEvent->globalPos(), getToolTip(item->data(Qt::UserRole).toString()), viewport(), visualItemRect(item));
+        }
+        else {
+            QToolTip::hideText();
+            event->ignore();
+        }
+        return true;
+    }
+    return QListWidget::viewportEvent(event);
+}
+
+void SymbolView::showEvent(QShowEvent *event)
+{
+    QListWidget::showEvent(event);
+    m_renderTimer->start();
+}
+
+void SymbolView::resizeEvent(QResizeEvent *event)
+{
+    QListWidget::resizeEvent(event);
+    m_renderTimer->start();
+}
+
+void SymbolView::renderVisibleSymbols()
+{
+    if(!isVisible()) {
+        return;
+    }
+    const QRect visibleRect = viewport()->rect();
+    for(int i = 0; i < count(); ++i) {
+        QListWidgetItem *item = this->item(i);
+        if(!item->data(RenderedRole).toBool() && visualItemRect(item).intersects(visibleRect)) {
+            renderSymbol(item);
+        }
+    }
+}
+
+void SymbolView::renderSymbol(QListWidgetItem *item)
+{
+    item->setData(RenderedRole, true);
+
+    QImage image;
+    const int atlasIndex = item->data(AtlasIndexRole).toInt();
+    if(atlasIndex >= 0) {
+        image = symbolAtlas()->image(atlasIndex);
+    }
+    else {
+        Command cmd;
+        extract(item->data(Qt::UserRole).toString(), cmd);
+        if(!image.load(cmd.path)) {
+            KILE_DEBUG_MAIN << "Loading file " << cmd.path << " failed";
+            return;
+        }
+    }
+
+    if(m_recolorSymbols) {
+        if (image.format() != QImage::Format_ARGB32_Premultiplied && image.format() != QImage::Format_ARGB32) {
+            image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        }
+
+        QPainter p;
+        p.begin(&image);
+        p.setCompositionMode(QPainter::CompositionMode_SourceAtop);
+        p.fillRect(image.rect(), m_brush.brush(QPalette::Active));
+        p.end();
+    }
+    item->setIcon(QPixmap::fromImage(image));
+}
+
 void SymbolView::mousePressEvent(QMouseEvent *event)
 {
     Command cmd;
@@ -315,7 +494,6 @@ QString convertLatin1StringtoUTF8(const QString &string)
 void SymbolView::fillWidget(const QString& prefix)
 {
     KILE_DEBUG_MAIN << "===SymbolView::fillWidget(const QString& " << prefix <<  " )===";
-    QImage image;
     QListWidgetItem* item;
     QStringList refCnts, paths, unicodeValues;
     QString key;
@@ -353,38 +531,45 @@ void SymbolView::fillWidget(const QString& prefix)
         }
     }
 
-    // render symbols
+    // Only the descriptions of the symbols are read here; the images are rendered once they
+    // become visible. The descriptions of the symbols shipped with Kile are taken from the atlas,
+    // for the other symbols only the text chunks of the images are read.
     for (int i = 0; i < paths.count(); i++) {
-        if (image.load(paths[i])) {
-            item = new QListWidgetItem(this);
-
-            key = refCnts[i] + '%' + image.text("Command");
-            key += '%' + convertLatin1StringtoUTF8(image.text("CommandUnicode"));
-            key += '%' + image.text("UnicodePackages");
-            key += '%' + image.text("Packages");
-            key += '%' + convertLatin1StringtoUTF8(image.text("Comment"));
-            key += '%' + paths[i];
-
-            item->setData(Qt::UserRole, key);
-            item->setToolTip(getToolTip(key));
-
-            if (prefix != QLatin1String("user")) {
-                if (image.format() != QImage::Format_ARGB32_Premultiplied && image.format() != QImage::Format_ARGB32) {
-                    image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-                }
-
-                QPainter p;
-                p.begin(&image);
-                p.setCompositionMode(QPainter::CompositionMode_SourceAtop);
-                p.fillRect(image.rect(), m_brush.brush(QPalette::Active));
-                p.end();
-            }
-            item->setIcon(QPixmap::fromImage(image));
+        const int atlasIndex = symbolAtlas()->indexOf(paths[i]);
+        QString command, commandUnicode, unicodePackages, packages, comment;
+        if(atlasIndex >= 0) {
+            const SymbolAtlasEntry &entry = symbolAtlas()->entry(atlasIndex);
+            command = entry.command;
+            commandUnicode = entry.commandUnicode;
+            unicodePackages = entry.unicodePackages;
+            packages = entry.packages;
+            comment = entry.comment;
         }
         else {
-            KILE_DEBUG_MAIN << "Loading file " << paths[i] << " failed";
+            QImageReader reader(paths[i]);
+            if(!reader.canRead()) {
+                KILE_DEBUG_MAIN << "Loading file " << paths[i] << " failed";
+                continue;
+            }
+            command = reader.text("Command");
+            commandUnicode = reader.text("CommandUnicode");
+            unicodePackages = reader.text("UnicodePackages");
+            packages = reader.text("Packages");
+            comment = reader.text("Comment");
         }
+        item = new QListWidgetItem(this);
+
+        key = refCnts[i] + '%' + command;
+        key += '%' + convertLatin1StringtoUTF8(commandUnicode);
+        key += '%' + unicodePackages;
+        key += '%' + packages;
+        key += '%' + convertLatin1StringtoUTF8(comment);
+        key += '%' + paths[i];
+
+        item->setData(Qt::UserRole, key);
+        item->setData(AtlasIndexRole, atlasIndex);
     }
+    m_renderTimer->start();
 }
 
 void SymbolView::writeConfig()
@@ -462,14 +647,13 @@ void SymbolView::slotAddToList(const QListWidgetItem *item)
         QString key = tmpItem->data(Qt::UserRole).toString();
         key.replace(reCnt, QString::number(refCnt + 1));
         tmpItem->setData(Qt::UserRole, key);
-        tmpItem->setToolTip(getToolTip(key));
     }
     else {
         tmpItem = new QListWidgetItem(this);
         tmpItem->setIcon(item->icon());
-        QString key = item->data(Qt::UserRole).toString();
-        tmpItem->setData(Qt::UserRole, key);
-        tmpItem->setToolTip(getToolTip(key));
+        tmpItem->setData(Qt::UserRole, item->data(Qt::UserRole));
+        tmpItem->setData(AtlasIndexRole, item->data(AtlasIndexRole));
+        tmpItem->setData(RenderedRole, true);
     }
 }
 
@@ -24,6 +24,7 @@
 #include "../symbolviewclasses.h"
 
 class QMouseEvent;
+class QTimer;
 
 class KileInfo;
 
@@ -40,19 +41,31 @@ public:
     void writeConfig();
 
 private:
+    enum { AtlasIndexRole = Qt::UserRole + 1, RenderedRole };
+
     void fillWidget(const QString &prefix);
     void extractPackageString(const QString &string, QList<Package> &pkgs);
     void extract(const QString& key, Command &cmd);
     void extract(const QString& key, int& refCnt);
     void initPage(int page);
     QString getToolTip(const QString &key);
+    void renderSymbol(QListWidgetItem *item);
 
 protected:
     KileInfo *m_ki;
     KStatefulBrush m_brush;
+    // the symbols of the user group keep their colours
+    bool m_recolorSymbols;
+    QTimer *m_renderTimer;
 
 
     virtual void mousePressEvent(QMouseEvent *event) override;
+    virtual bool viewportEvent(QEvent *event) override;
+    virtual void showEvent(QShowEvent *event) override;
+    virtual void resizeEvent(QResizeEvent *event) override;
+
+private Q_SLOTS:
+    void renderVisibleSymbols();
 
 Q_SIGNALS:
     void insertText(const QString& text, const QList<Package> &pkgs);